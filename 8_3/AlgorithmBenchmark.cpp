@@ -0,0 +1,79 @@
+#include "AlgorithmBenchmark.h"
+#include "FilterPipeline.h"
+#include "FilterVerification.h"
+#include "OpenCLUtils.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+
+using Clock = std::chrono::high_resolution_clock;
+using Milliseconds = std::chrono::duration<double, std::milli>;
+
+namespace
+{
+const int TIMED_RUNS = 5;
+}
+
+void RunAlgorithmBenchmark(const std::string& filterName, int width, int height, int channels,
+                           const std::vector<int>& parameters, const std::vector<std::string>& algorithms)
+{
+    if (algorithms.empty()) throw std::runtime_error("Benchmark needs at least one algorithm.");
+    const size_t imageSizeBytes = static_cast<size_t>(width) * height * channels;
+    const PixelBuffer image = CreateTestImage(width, height, channels);
+
+    std::cout << "Benchmark " << filterName << " on " << width << "x" << height << "x" << channels
+              << ", best of " << TIMED_RUNS << " runs, reference: " << algorithms.front() << std::endl;
+
+    for (int parameter : parameters) {
+        PixelBuffer reference;
+        for (const std::string& algorithm : algorithms) {
+            FilterSpec spec;
+            spec.name = filterName;
+            spec.parameter = parameter;
+            spec.options["algo"] = algorithm;
+
+            std::cout << "  param " << std::setw(3) << parameter << "  " << std::left << std::setw(12) << algorithm << std::right;
+            try {
+                std::unique_ptr<OpenCLImageFilter> filter = CreateImageFilter(spec);
+                OpenCLRuntime& runtime = *filter->GetRuntime();
+                cl_command_queue queue = runtime.GetQueue();
+                PooledBuffer inputBuffer(runtime.GetBufferPool(), imageSizeBytes);
+                PooledBuffer outputBuffer(runtime.GetBufferPool(), imageSizeBytes);
+                cl_int err = clEnqueueWriteBuffer(queue, inputBuffer.Get(), CL_TRUE, 0, imageSizeBytes, image.data(), 0, nullptr, nullptr);
+                CheckCLError(err, "Benchmark clEnqueueWriteBuffer");
+
+                // Первый запуск - прогрев: сборка специализированных программ
+                double bestMs = std::numeric_limits<double>::infinity();
+                for (int run = 0; run <= TIMED_RUNS; ++run) {
+                    auto startTime = Clock::now();
+                    filter->EnqueueOnDevice(queue, inputBuffer.Get(), outputBuffer.Get(), width, height, channels, ElementType::UCHAR);
+                    clFinish(queue);
+                    if (run > 0) bestMs = std::min(bestMs, Milliseconds(Clock::now() - startTime).count());
+                }
+
+                PixelBuffer result(imageSizeBytes);
+                err = clEnqueueReadBuffer(queue, outputBuffer.Get(), CL_TRUE, 0, imageSizeBytes, result.data(), 0, nullptr, nullptr);
+                CheckCLError(err, "Benchmark clEnqueueReadBuffer");
+
+                std::cout << std::fixed << std::setprecision(3) << std::setw(10) << bestMs << " ms"
+                          << std::setprecision(1) << std::setw(9) << imageSizeBytes / channels / bestMs / 1000.0 << " MPix/s";
+                if (reference.empty()) {
+                    reference = std::move(result);
+                    std::cout << "  (reference)";
+                } else {
+                    int maxError = 0;
+                    for (size_t i = 0; i < result.size(); ++i) {
+                        maxError = std::max(maxError, std::abs(static_cast<int>(result[i]) - static_cast<int>(reference[i])));
+                    }
+                    std::cout << "  max error: " << maxError;
+                }
+                std::cout << std::endl;
+            } catch (const std::exception& e) {
+                std::cout << "  skipped: " << e.what() << std::endl;
+            }
+        }
+    }
+}
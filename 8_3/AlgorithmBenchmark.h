@@ -0,0 +1,9 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Сравнение вариантов реализации одного фильтра (опция "algo") на синтетическом изображении.
+// Для каждого значения параметра каждый вариант запускается на устройстве без передач
+// на хост; печатается лучшее время и максимальное отличие от первого варианта в списке.
+void RunAlgorithmBenchmark(const std::string& filterName, int width, int height, int channels,
+                           const std::vector<int>& parameters, const std::vector<std::string>& algorithms);
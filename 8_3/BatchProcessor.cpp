@@ -0,0 +1,226 @@
+#include "BatchProcessor.h"
+#include "BoundedQueue.h"
+#include "ImageIO.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::high_resolution_clock;
+using Seconds = std::chrono::duration<double>;
+
+namespace
+{
+struct BatchItem
+{
+    fs::path inputPath;
+    HostImage image;
+};
+
+// Суммарное время работы потоков стадии (без ожидания в очередях)
+struct StageStats
+{
+    std::atomic<long long> busyNanoseconds{0};
+    int workers = 0;
+
+    void AddBusy(Clock::duration duration)
+    {
+        busyNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    }
+
+    [[nodiscard]] double Utilization(double wallSeconds) const
+    {
+        if (wallSeconds <= 0.0 || workers == 0) return 0.0;
+        return static_cast<double>(busyNanoseconds.load()) * 1e-9 / (wallSeconds * workers);
+    }
+};
+
+// Простая маска имени файла: '*' - любая последовательность, '?' - любой символ
+bool MatchesWildcard(const std::string& text, const std::string& pattern)
+{
+    size_t t = 0, p = 0, starPos = std::string::npos, matchPos = 0;
+    while (t < text.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) {
+            ++t;
+            ++p;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            starPos = p++;
+            matchPos = t;
+        } else if (starPos != std::string::npos) {
+            p = starPos + 1;
+            t = ++matchPos;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') ++p;
+    return p == pattern.size();
+}
+
+bool HasImageExtension(const fs::path& path)
+{
+    std::string ext = path.extension().string();
+    for (char& c : ext) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp" || ext == ".tga"
+           || ext == ".gif" || ext == ".psd" || ext == ".pnm" || ext == ".ppm" || ext == ".pgm" || ext == ".hdr";
+}
+
+int DefaultStageThreads()
+{
+    unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    return std::max(1, static_cast<int>(hardwareThreads / 2));
+}
+}
+
+BatchProcessor::BatchProcessor(BatchOptions options)
+        : m_options(std::move(options))
+{
+    if (m_options.decodeThreads <= 0) m_options.decodeThreads = DefaultStageThreads();
+    if (m_options.encodeThreads <= 0) m_options.encodeThreads = DefaultStageThreads();
+}
+
+std::vector<fs::path> BatchProcessor::ListInputFiles(const std::string& inputPattern)
+{
+    fs::path directory;
+    std::string fileMask;
+    if (fs::is_directory(inputPattern)) {
+        directory = inputPattern;
+    } else {
+        fs::path patternPath(inputPattern);
+        directory = patternPath.has_parent_path() ? patternPath.parent_path() : fs::path(".");
+        fileMask = patternPath.filename().string();
+    }
+    if (!fs::is_directory(directory)) {
+        throw std::runtime_error("Input directory does not exist: " + directory.string());
+    }
+
+    std::vector<fs::path> files;
+    for (const fs::directory_entry& entry : fs::directory_iterator(directory)) {
+        if (!entry.is_regular_file()) continue;
+        const fs::path& path = entry.path();
+        bool matches = fileMask.empty() ? HasImageExtension(path) : MatchesWildcard(path.filename().string(), fileMask);
+        if (matches) files.push_back(path);
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+void BatchProcessor::Run()
+{
+    std::vector<fs::path> inputFiles = ListInputFiles(m_options.inputPattern);
+    if (inputFiles.empty()) {
+        throw std::runtime_error("No input images match: " + m_options.inputPattern);
+    }
+    fs::create_directories(m_options.outputDirectory);
+
+    FilterPipeline pipeline = FilterPipeline::FromSpecs(m_options.filters);
+    const int desiredChannels = pipeline.GetRequiredChannels();
+
+    std::cout << "Batch: " << inputFiles.size() << " images, filters: " << pipeline.GetDescription()
+              << ", decode threads: " << m_options.decodeThreads
+              << ", encode threads: " << m_options.encodeThreads << std::endl;
+
+    BoundedQueue<BatchItem> decodedQueue(m_options.queueCapacity);
+    BoundedQueue<BatchItem> filteredQueue(m_options.queueCapacity);
+    StageStats decodeStats, deviceStats, encodeStats;
+    decodeStats.workers = m_options.decodeThreads;
+    deviceStats.workers = 1;
+    encodeStats.workers = m_options.encodeThreads;
+
+    std::atomic<size_t> nextInput{0};
+    std::atomic<int> activeDecoders{m_options.decodeThreads};
+    std::atomic<size_t> processedCount{0};
+    std::atomic<size_t> failedCount{0};
+    std::mutex logMutex;
+    std::exception_ptr deviceError;
+
+    auto logFailure = [&](const fs::path& path, const std::exception& e) {
+        std::lock_guard<std::mutex> lock(logMutex);
+        std::cerr << "Warning: skipping " << path.string() << ": " << e.what() << std::endl;
+        ++failedCount;
+    };
+
+    auto startTime = Clock::now();
+
+    std::vector<std::thread> decoders;
+    for (int i = 0; i < m_options.decodeThreads; ++i) {
+        decoders.emplace_back([&] {
+            for (size_t index = nextInput++; index < inputFiles.size(); index = nextInput++) {
+                auto busyStart = Clock::now();
+                BatchItem item;
+                item.inputPath = inputFiles[index];
+                try {
+                    item.image = LoadImageFile(item.inputPath.string(), desiredChannels);
+                    if (m_options.elementType) {
+                        item.image.pixels = ConvertElements(item.image.pixels, item.image.elementType, *m_options.elementType);
+                        item.image.elementType = *m_options.elementType;
+                    }
+                } catch (const std::exception& e) {
+                    logFailure(item.inputPath, e);
+                    continue;
+                }
+                decodeStats.AddBusy(Clock::now() - busyStart);
+                if (!decodedQueue.Push(std::move(item))) break; // Конвейер остановлен
+            }
+            if (--activeDecoders == 0) decodedQueue.Close(); // Последний декодер закрывает очередь
+        });
+    }
+
+    // Стадия устройства: один поток, все изображения идут через один FilterPipeline
+    std::thread deviceWorker([&] {
+        try {
+            while (std::optional<BatchItem> item = decodedQueue.Pop()) {
+                auto busyStart = Clock::now();
+                HostImage& image = item->image;
+                pipeline.Apply(image.pixels, image.width, image.height, image.channels, image.elementType);
+                deviceStats.AddBusy(Clock::now() - busyStart);
+                filteredQueue.Push(std::move(*item));
+            }
+        } catch (...) {
+            // Ошибка OpenCL - не проблема одного файла, останавливаем весь конвейер
+            deviceError = std::current_exception();
+            decodedQueue.Close();
+        }
+        filteredQueue.Close();
+    });
+
+    std::vector<std::thread> encoders;
+    for (int i = 0; i < m_options.encodeThreads; ++i) {
+        encoders.emplace_back([&] {
+            while (std::optional<BatchItem> item = filteredQueue.Pop()) {
+                auto busyStart = Clock::now();
+                fs::path outputPath = fs::path(m_options.outputDirectory) / item->inputPath.filename();
+                try {
+                    SaveImageFile(outputPath.string(), item->image);
+                    ++processedCount;
+                } catch (const std::exception& e) {
+                    logFailure(item->inputPath, e);
+                }
+                encodeStats.AddBusy(Clock::now() - busyStart);
+            }
+        });
+    }
+
+    for (std::thread& decoder : decoders) decoder.join();
+    deviceWorker.join();
+    for (std::thread& encoder : encoders) encoder.join();
+
+    if (deviceError) std::rethrow_exception(deviceError);
+
+    double wallSeconds = Seconds(Clock::now() - startTime).count();
+    std::cout << std::fixed << std::setprecision(2)
+              << "Batch done: " << processedCount << " images (" << failedCount << " failed) in "
+              << wallSeconds << " s, " << (wallSeconds > 0 ? processedCount / wallSeconds : 0.0) << " images/s\n"
+              << "Stage utilization: decode " << decodeStats.Utilization(wallSeconds) * 100.0 << "%"
+              << " (" << decodeStats.workers << " threads)"
+              << ", device " << deviceStats.Utilization(wallSeconds) * 100.0 << "%"
+              << ", encode " << encodeStats.Utilization(wallSeconds) * 100.0 << "%"
+              << " (" << encodeStats.workers << " threads)" << std::endl;
+}
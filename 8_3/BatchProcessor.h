@@ -0,0 +1,35 @@
+#pragma once
+#include "FilterPipeline.h"
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+struct BatchOptions
+{
+    std::string inputPattern;    // Каталог или маска файлов: "scans/*.png"
+    std::string outputDirectory;
+    std::vector<FilterSpec> filters;
+    int decodeThreads = 0;       // 0 - половина аппаратных потоков (не меньше 1)
+    int encodeThreads = 0;
+    size_t queueCapacity = 8;    // Сколько изображений может ждать между стадиями
+    std::optional<ElementType> elementType; // Тип значений для обработки; пусто - как загружено
+};
+
+// Пакетная обработка каталога: декодирование, фильтрация на устройстве и кодирование
+// идут одновременно в отдельных потоках, связанных очередями ограниченной емкости.
+// Стадия устройства однопоточная (один FilterPipeline), декодирование/кодирование - в
+// нескольких потоках, так что работа CPU перекрывается с работой устройства.
+class BatchProcessor
+{
+public:
+    explicit BatchProcessor(BatchOptions options);
+
+    // Обрабатывает все файлы и печатает изображения/с и загрузку каждой стадии
+    void Run();
+
+    static std::vector<std::filesystem::path> ListInputFiles(const std::string& inputPattern);
+
+private:
+    BatchOptions m_options;
+};
@@ -0,0 +1,181 @@
+#include "CommandProfiler.h"
+#include "OpenCLUtils.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+
+namespace
+{
+// Чтобы длинный пакетный прогон не копил тысячи живых событий
+const size_t MAX_PENDING_COMMANDS = 1024;
+
+const char* CategoryName(ProfileCategory category)
+{
+    return category == ProfileCategory::TRANSFER ? "transfer" : "compute";
+}
+
+double ToMs(cl_ulong nanoseconds)
+{
+    return static_cast<double>(nanoseconds) * 1e-6;
+}
+
+std::string EscapeJson(const std::string& text)
+{
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+}
+
+CommandProfiler::CommandProfiler(ProfilingOptions options)
+        : m_options(std::move(options))
+{
+}
+
+CommandProfiler::~CommandProfiler()
+{
+    for (PendingCommand& command : m_pending) {
+        if (command.event) clReleaseEvent(command.event);
+    }
+}
+
+cl_event* CommandProfiler::Track(const std::string& name, ProfileCategory category)
+{
+    if (!m_options.enabled) return nullptr;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_pending.size() >= MAX_PENDING_COMMANDS) ResolveLocked(false);
+    m_pending.push_back({name, category, nullptr});
+    return &m_pending.back().event;
+}
+
+void CommandProfiler::Record(const std::string& name, ProfileCategory category, cl_event event)
+{
+    if (!m_options.enabled || !event) return;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_pending.size() >= MAX_PENDING_COMMANDS) ResolveLocked(false);
+    clRetainEvent(event);
+    m_pending.push_back({name, category, event});
+}
+
+void CommandProfiler::ResolveLocked(bool wait)
+{
+    while (!m_pending.empty()) {
+        PendingCommand& command = m_pending.front();
+        if (!command.event) {
+            // Track без события: enqueue завершился ошибкой, либо слот еще не заполнен
+            if (!wait) break;
+            m_pending.pop_front();
+            continue;
+        }
+        if (wait) {
+            clWaitForEvents(1, &command.event);
+        } else {
+            cl_int status = CL_QUEUED;
+            clGetEventInfo(command.event, CL_EVENT_COMMAND_EXECUTION_STATUS, sizeof(status), &status, nullptr);
+            if (status > CL_COMPLETE) break; // Очереди in-order: за незавершенной командой идут такие же
+        }
+
+        CommandTiming timing{command.name, command.category, 0, 0, 0, 0};
+        cl_int err = clGetEventProfilingInfo(command.event, CL_PROFILING_COMMAND_QUEUED, sizeof(cl_ulong), &timing.queued, nullptr);
+        err |= clGetEventProfilingInfo(command.event, CL_PROFILING_COMMAND_SUBMIT, sizeof(cl_ulong), &timing.submit, nullptr);
+        err |= clGetEventProfilingInfo(command.event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &timing.start, nullptr);
+        err |= clGetEventProfilingInfo(command.event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &timing.end, nullptr);
+        if (err == CL_SUCCESS) m_timings.push_back(timing);
+
+        clReleaseEvent(command.event);
+        m_pending.pop_front();
+    }
+}
+
+void CommandProfiler::Report(std::ostream& out)
+{
+    if (!m_options.enabled) return;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ResolveLocked(true);
+    if (m_timings.empty()) {
+        out << "Profile: no commands recorded." << std::endl;
+        return;
+    }
+
+    struct NameStats
+    {
+        ProfileCategory category;
+        size_t count = 0;
+        cl_ulong total = 0, minimum = ~cl_ulong(0), maximum = 0;
+        cl_ulong launchLatency = 0; // QUEUED -> START
+    };
+    std::map<std::string, NameStats> byName;
+    cl_ulong origin = ~cl_ulong(0), finish = 0;
+    cl_ulong transferTotal = 0, computeTotal = 0;
+    for (const CommandTiming& timing : m_timings) {
+        cl_ulong duration = timing.end - timing.start;
+        NameStats& stats = byName[timing.name];
+        stats.category = timing.category;
+        ++stats.count;
+        stats.total += duration;
+        stats.minimum = std::min(stats.minimum, duration);
+        stats.maximum = std::max(stats.maximum, duration);
+        stats.launchLatency += timing.start - timing.queued;
+        (timing.category == ProfileCategory::TRANSFER ? transferTotal : computeTotal) += duration;
+        origin = std::min(origin, timing.queued);
+        finish = std::max(finish, timing.end);
+    }
+
+    // Занятость устройства - объединение интервалов [start, end]: при нескольких очередях они перекрываются
+    std::vector<std::pair<cl_ulong, cl_ulong>> intervals;
+    for (const CommandTiming& timing : m_timings) intervals.emplace_back(timing.start, timing.end);
+    std::sort(intervals.begin(), intervals.end());
+    cl_ulong busy = 0, coveredUntil = 0;
+    for (const auto& [start, end] : intervals) {
+        cl_ulong from = std::max(start, coveredUntil);
+        if (end > from) busy += end - from;
+        coveredUntil = std::max(coveredUntil, end);
+    }
+    cl_ulong span = finish - origin;
+
+    out << std::fixed << std::setprecision(3)
+        << "Profile (" << m_timings.size() << " commands, device time in ms):\n"
+        << "  " << std::left << std::setw(28) << "command" << std::right
+        << std::setw(9) << "category" << std::setw(8) << "count" << std::setw(11) << "total"
+        << std::setw(10) << "avg" << std::setw(10) << "min" << std::setw(10) << "max"
+        << std::setw(12) << "avg launch" << "\n";
+    for (const auto& [name, stats] : byName) {
+        out << "  " << std::left << std::setw(28) << name << std::right
+            << std::setw(9) << CategoryName(stats.category) << std::setw(8) << stats.count
+            << std::setw(11) << ToMs(stats.total) << std::setw(10) << ToMs(stats.total) / stats.count
+            << std::setw(10) << ToMs(stats.minimum) << std::setw(10) << ToMs(stats.maximum)
+            << std::setw(12) << ToMs(stats.launchLatency) / stats.count << "\n";
+    }
+    out << "  Transfer: " << ToMs(transferTotal) << " ms, compute: " << ToMs(computeTotal) << " ms"
+        << ", host overhead (device idle): " << ToMs(span - busy) << " ms"
+        << ", span (first queued -> last end): " << ToMs(span) << " ms" << std::endl;
+
+    if (!m_options.jsonPath.empty()) {
+        WriteJson(m_options.jsonPath, origin);
+        out << "  Profile JSON written to: " << m_options.jsonPath << std::endl;
+    }
+}
+
+void CommandProfiler::WriteJson(const std::string& path, cl_ulong origin) const
+{
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Warning: cannot write profile JSON to " << path << std::endl;
+        return;
+    }
+    // Времена в наносекундах от первой поставленной в очередь команды
+    file << "{\n  \"commands\": [\n";
+    for (size_t i = 0; i < m_timings.size(); ++i) {
+        const CommandTiming& timing = m_timings[i];
+        file << "    {\"name\": \"" << EscapeJson(timing.name) << "\", \"category\": \"" << CategoryName(timing.category)
+             << "\", \"queued_ns\": " << timing.queued - origin << ", \"submit_ns\": " << timing.submit - origin
+             << ", \"start_ns\": " << timing.start - origin << ", \"end_ns\": " << timing.end - origin << "}"
+             << (i + 1 < m_timings.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <CL/cl.h>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+enum class ProfileCategory
+{
+    TRANSFER, // Запись/чтение/копирование буферов
+    COMPUTE   // Запуски ядер
+};
+
+struct ProfilingOptions
+{
+    bool enabled = false;
+    std::string jsonPath; // Пусто - JSON не пишется
+};
+
+// Профилирование команд OpenCL по событиям (очереди создаются с CL_QUEUE_PROFILING_ENABLE).
+// Каждая команда регистрируется под именем ("BlurPass", "Median write"...), после завершения
+// из события берутся времена QUEUED/SUBMIT/START/END. Отчет делит время на передачи,
+// вычисления и простой устройства (накладные расходы хоста между командами).
+class CommandProfiler
+{
+public:
+    explicit CommandProfiler(ProfilingOptions options);
+    ~CommandProfiler();
+    CommandProfiler(const CommandProfiler&) = delete;
+    CommandProfiler& operator=(const CommandProfiler&) = delete;
+
+    [[nodiscard]] bool IsEnabled() const { return m_options.enabled; }
+
+    // Слот для последнего аргумента clEnqueue*: clEnqueueNDRangeKernel(..., Track("BlurPass", COMPUTE)).
+    // Когда профилирование выключено, возвращает nullptr - событие тогда просто не создается.
+    // Указатель действителен до следующего вызова Track/Record из того же потока.
+    cl_event* Track(const std::string& name, ProfileCategory category);
+    // Для событий, которые вызывающий создал сам: профайлер делает clRetainEvent
+    void Record(const std::string& name, ProfileCategory category, cl_event event);
+
+    // Ждет все зарегистрированные команды и печатает сводку (и JSON, если задан путь)
+    void Report(std::ostream& out);
+
+private:
+    struct PendingCommand
+    {
+        std::string name;
+        ProfileCategory category;
+        cl_event event = nullptr;
+    };
+
+    struct CommandTiming
+    {
+        std::string name;
+        ProfileCategory category;
+        cl_ulong queued, submit, start, end; // Наносекунды, часы устройства
+    };
+
+    // Переносит завершенные команды из m_pending в m_timings; wait - дождаться всех
+    void ResolveLocked(bool wait);
+    void WriteJson(const std::string& path, cl_ulong origin) const;
+
+    ProfilingOptions m_options;
+    std::deque<PendingCommand> m_pending; // deque: адреса элементов не меняются при push_back
+    std::vector<CommandTiming> m_timings;
+    std::mutex m_mutex;
+};
@@ -0,0 +1,369 @@
+#include "CpuFilters.h"
+#include "CpuSimd.h"
+#include "GaussianFilter.h"
+#include "MotionBlurGeometry.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+// Как convert_uchar_sat_rte в ядрах: округление к ближайшему четному и насыщение
+unsigned char ToByte(float value)
+{
+    return static_cast<unsigned char>(std::clamp(std::nearbyint(value), 0.0f, 255.0f));
+}
+
+// Медиана окна с повтором краев сортировкой; для крайних столбцов в пути 3x3
+unsigned char MedianAt(const PixelBuffer& image, int width, int height, int channels,
+                       int x, int y, int channel, int radius)
+{
+    std::vector<unsigned char> window;
+    window.reserve(static_cast<size_t>(2 * radius + 1) * (2 * radius + 1));
+    for (int dy = -radius; dy <= radius; ++dy) {
+        int sampleY = std::clamp(y + dy, 0, height - 1);
+        for (int dx = -radius; dx <= radius; ++dx) {
+            int sampleX = std::clamp(x + dx, 0, width - 1);
+            window.push_back(image[(static_cast<size_t>(sampleY) * width + sampleX) * channels + channel]);
+        }
+    }
+    auto middle = window.begin() + window.size() / 2;
+    std::nth_element(window.begin(), middle, window.end());
+    return *middle;
+}
+
+// Гистограмма окна одного канала с отслеживанием медианы (Huang): после добавления и удаления
+// значений медиана сдвигается от прежней, а не ищется заново с нуля
+class RunningMedian
+{
+public:
+    explicit RunningMedian(int windowSize) : m_rank(windowSize / 2) {}
+
+    void Add(unsigned char value)
+    {
+        ++m_histogram[value];
+        if (value < m_median) ++m_below;
+    }
+
+    void Remove(unsigned char value)
+    {
+        --m_histogram[value];
+        if (value < m_median) --m_below;
+    }
+
+    unsigned char Get()
+    {
+        // m_below - число значений меньше m_median; медиана - значение с номером m_rank
+        while (m_below > m_rank) {
+            --m_median;
+            m_below -= m_histogram[m_median];
+        }
+        while (m_below + m_histogram[m_median] <= m_rank) {
+            m_below += m_histogram[m_median];
+            ++m_median;
+        }
+        return static_cast<unsigned char>(m_median);
+    }
+
+private:
+    std::array<int, 256> m_histogram{};
+    int m_rank;
+    int m_median = 0;
+    int m_below = 0;
+};
+}
+
+void CpuGaussianFilter::ApplyFilter(PixelBuffer& imageData, int width, int height, int channels)
+{
+    if (IsIdentity()) return;
+    const int radius = m_radius;
+    const std::vector<float> weights = GaussianFilter::CreateGaussianKernelValues(radius, GaussianFilter::SigmaForRadius(radius));
+    const size_t rowLength = static_cast<size_t>(width) * channels;
+    PixelBuffer output(imageData.size());
+
+    ParallelForRows(height, [&](int rowBegin, int rowEnd) {
+        // Горизонтальный проход для строк полосы и ее полей по radius строк
+        int firstRow = std::max(0, rowBegin - radius);
+        int lastRow = std::min(height - 1, rowEnd - 1 + radius);
+        std::vector<float> blurredRows(static_cast<size_t>(lastRow - firstRow + 1) * rowLength, 0.0f);
+        std::vector<float> paddedRow((static_cast<size_t>(width) + 2 * radius) * channels);
+        for (int y = firstRow; y <= lastRow; ++y) {
+            const unsigned char* source = imageData.data() + static_cast<size_t>(y) * rowLength;
+            for (int x = -radius; x < width + radius; ++x) {
+                const unsigned char* pixel = source + static_cast<size_t>(std::clamp(x, 0, width - 1)) * channels;
+                for (int c = 0; c < channels; ++c) paddedRow[static_cast<size_t>(x + radius) * channels + c] = pixel[c];
+            }
+            // Сдвиг на k пикселей - это сдвиг на k * channels элементов, каналы не разделяются
+            float* destination = blurredRows.data() + static_cast<size_t>(y - firstRow) * rowLength;
+            for (int k = 0; k <= 2 * radius; ++k) {
+                AccumulateScaled(destination, paddedRow.data() + static_cast<size_t>(k) * channels, weights[k], rowLength);
+            }
+        }
+
+        std::vector<float> accumulator(rowLength);
+        for (int y = rowBegin; y < rowEnd; ++y) {
+            std::fill(accumulator.begin(), accumulator.end(), 0.0f);
+            for (int k = -radius; k <= radius; ++k) {
+                int sourceY = std::clamp(y + k, 0, height - 1);
+                AccumulateScaled(accumulator.data(), blurredRows.data() + static_cast<size_t>(sourceY - firstRow) * rowLength,
+                                 weights[k + radius], rowLength);
+            }
+            unsigned char* destination = output.data() + static_cast<size_t>(y) * rowLength;
+            for (size_t i = 0; i < rowLength; ++i) destination[i] = ToByte(accumulator[i]);
+        }
+    });
+    imageData.swap(output);
+}
+
+void CpuGaussianFilter::SetEffectRadius(int radius)
+{
+    m_radius = std::max(0, radius);
+}
+
+void CpuMedianFilter::ApplyFilter(PixelBuffer& imageData, int width, int height, int channels)
+{
+    if (IsIdentity()) return;
+    PixelBuffer output(imageData.size());
+    const size_t rowLength = static_cast<size_t>(width) * channels;
+
+    ParallelForRows(height, [&](int rowBegin, int rowEnd) {
+        if (m_radius != 1) {
+            ApplyHistogram(imageData, output, width, height, channels, rowBegin, rowEnd);
+            return;
+        }
+        for (int y = rowBegin; y < rowEnd; ++y) {
+            const unsigned char* above = imageData.data() + static_cast<size_t>(std::max(y - 1, 0)) * rowLength;
+            const unsigned char* row = imageData.data() + static_cast<size_t>(y) * rowLength;
+            const unsigned char* below = imageData.data() + static_cast<size_t>(std::min(y + 1, height - 1)) * rowLength;
+            unsigned char* destination = output.data() + static_cast<size_t>(y) * rowLength;
+            if (width >= 3) {
+                Median3x3Span(above, row, below, destination, channels, rowLength - channels, channels);
+            }
+            // Крайние столбцы (и узкие изображения целиком) - с повтором края
+            for (int x = 0; x < width; ++x) {
+                if (width >= 3 && x != 0 && x != width - 1) continue;
+                for (int c = 0; c < channels; ++c) {
+                    destination[static_cast<size_t>(x) * channels + c] = MedianAt(imageData, width, height, channels, x, y, c, 1);
+                }
+            }
+        }
+    });
+    imageData.swap(output);
+}
+
+void CpuMedianFilter::ApplyHistogram(const PixelBuffer& input, PixelBuffer& output,
+                                     int width, int height, int channels, int rowBegin, int rowEnd) const
+{
+    const int radius = m_radius;
+    const int windowSize = (2 * radius + 1) * (2 * radius + 1);
+    auto at = [&](int x, int y, int c) {
+        return input[(static_cast<size_t>(std::clamp(y, 0, height - 1)) * width + std::clamp(x, 0, width - 1)) * channels + c];
+    };
+
+    for (int y = rowBegin; y < rowEnd; ++y) {
+        for (int c = 0; c < channels; ++c) {
+            RunningMedian median(windowSize);
+            for (int dx = -radius; dx <= radius; ++dx) {
+                for (int dy = -radius; dy <= radius; ++dy) median.Add(at(dx, y + dy, c));
+            }
+            for (int x = 0; x < width; ++x) {
+                output[(static_cast<size_t>(y) * width + x) * channels + c] = median.Get();
+                // Сдвиг окна на столбец вправо: столбцы берутся с повтором края, как в ядрах
+                for (int dy = -radius; dy <= radius; ++dy) {
+                    median.Remove(at(x - radius, y + dy, c));
+                    median.Add(at(x + radius + 1, y + dy, c));
+                }
+            }
+        }
+    }
+}
+
+void CpuMedianFilter::SetEffectRadius(int radius)
+{
+    m_radius = std::max(0, radius);
+}
+
+void CpuMotionBlurFilter::ApplyFilter(PixelBuffer& imageData, int width, int height, int channels)
+{
+    if (IsIdentity()) return;
+    if (channels < 1 || channels > 4) {
+        throw std::runtime_error("Motion blur supports 1-4 channels, got " + std::to_string(channels));
+    }
+
+    // Геометрия и обход блоками те же, что в MotionBlurFilter::EnqueueRunningSum
+    const MotionBlurGeometry geometry = MakeMotionBlurGeometry(m_blurLength, m_angleDegrees, width, height);
+    const int majorLength = geometry.majorLength;
+    const int minorLength = geometry.minorLength;
+    const int majorStride = geometry.majorStride;
+    const int minorStride = geometry.minorStride;
+    const float slope = geometry.slope;
+    const int phases = geometry.phases;
+
+    auto addSample = [&](int major, int minor0, float weight, float sign, float* sum) {
+        int minor1 = std::clamp(minor0 + 1, 0, minorLength - 1);
+        minor0 = std::clamp(minor0, 0, minorLength - 1);
+        size_t index0 = (static_cast<size_t>(major) * majorStride + static_cast<size_t>(minor0) * minorStride) * channels;
+        size_t index1 = (static_cast<size_t>(major) * majorStride + static_cast<size_t>(minor1) * minorStride) * channels;
+        for (int c = 0; c < channels; ++c) {
+            float a = imageData[index0 + c];
+            sum[c] += sign * (a + (static_cast<float>(imageData[index1 + c]) - a) * weight);
+        }
+    };
+
+    std::vector<float> lines(GetMotionBlurScratchBytes(geometry) / sizeof(float));
+    PixelBuffer output(imageData.size());
+    for (const MotionBlurBlock& block : MakeMotionBlurBlocks(geometry)) {
+        const int majorStart = block.majorStart;
+        const int minorStart = block.minorStart;
+        const int bandLength = block.majorLength;
+        const int minorBase = block.minorStart + block.lineBaseInt;
+        auto addLineSample = [&](int major, int line, float sign, float* sum) {
+            float position = block.lineBaseFrac + static_cast<float>(line % phases) / static_cast<float>(phases) +
+                             static_cast<float>(major - majorStart) * slope;
+            float whole = std::floor(position);
+            addSample(major, minorBase + line / phases + static_cast<int>(whole), position - whole, sign, sum);
+        };
+
+        ParallelForRows(block.lineCount, [&](int lineBegin, int lineEnd) {
+            for (int line = lineBegin; line < lineEnd; ++line) {
+                float sum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+                for (int offset = geometry.windowStart; offset <= geometry.windowEnd; ++offset) {
+                    addLineSample(std::clamp(majorStart + offset, 0, majorLength - 1), line, 1.0f, sum);
+                }
+                float scale = 1.0f / static_cast<float>(geometry.windowEnd - geometry.windowStart + 1);
+                for (int i = 0; i < bandLength; ++i) {
+                    float* destination = lines.data() + (static_cast<size_t>(line) * bandLength + i) * 4;
+                    for (int c = 0; c < 4; ++c) destination[c] = sum[c] * scale;
+                    if (i + 1 == bandLength) break;
+                    int major = majorStart + i;
+                    addLineSample(std::min(major + geometry.windowEnd + 1, majorLength - 1), line, 1.0f, sum);
+                    addLineSample(std::clamp(major + geometry.windowStart, 0, majorLength - 1), line, -1.0f, sum);
+                }
+            }
+        });
+
+        ParallelForRows(block.minorLength, [&](int minorBegin, int minorEnd) {
+            for (int j = minorBegin; j < minorEnd; ++j) {
+                for (int i = 0; i < bandLength; ++i) {
+                    float position = block.lineBaseFrac + static_cast<float>(i) * slope;
+                    float whole = std::floor(position);
+                    float scaled = (position - whole) * static_cast<float>(phases); // Дробная часть в шагах линий
+                    float upper = std::ceil(scaled);
+                    int line0 = (j - block.lineBaseInt - static_cast<int>(whole)) * phases - static_cast<int>(upper);
+                    float weight = upper - scaled;
+                    line0 = std::clamp(line0, 0, block.lineCount - 2);
+                    const float* first = lines.data() + (static_cast<size_t>(line0) * bandLength + i) * 4;
+                    const float* second = first + static_cast<size_t>(bandLength) * 4;
+                    size_t outputIndex = (static_cast<size_t>(majorStart + i) * majorStride +
+                                          static_cast<size_t>(minorStart + j) * minorStride) * channels;
+                    for (int c = 0; c < channels; ++c) output[outputIndex + c] = ToByte(first[c] + (second[c] - first[c]) * weight);
+                }
+            }
+        });
+    }
+    imageData.swap(output);
+}
+
+void CpuMotionBlurFilter::SetEffectRadius(int blurLength)
+{
+    m_blurLength = std::max(0, blurLength);
+}
+
+void CpuMotionBlurFilter::SetOption(const std::string& key, const std::string& value)
+{
+    if (key == "angle") m_angleDegrees = std::stof(value);
+    else CpuImageFilter::SetOption(key, value);
+}
+
+void CpuRadialBlurFilter::ApplyFilter(PixelBuffer& imageData, int width, int height, int channels)
+{
+    if (IsIdentity()) return;
+    const float centerX = m_centerX * static_cast<float>(width);
+    const float centerY = m_centerY * static_cast<float>(height);
+    const float farX = std::max(centerX, static_cast<float>(width) - centerX);
+    const float farY = std::max(centerY, static_cast<float>(height) - centerY);
+    const float maxPossibleDist = std::max(1.0f, std::sqrt(farX * farX + farY * farY));
+    const float stepFactor = 0.005f * static_cast<float>(m_intensity);
+    const int numSamples = m_samples > 0 ? m_samples : std::max(1, m_intensity / 2 + 1);
+    PixelBuffer output(imageData.size());
+
+    ParallelForRows(height, [&](int rowBegin, int rowEnd) {
+        std::vector<float> accumulated(channels);
+        for (int y = rowBegin; y < rowEnd; ++y) {
+            for (int x = 0; x < width; ++x) {
+                size_t outputIndex = (static_cast<size_t>(y) * width + x) * channels;
+                float deltaX = static_cast<float>(x) - centerX;
+                float deltaY = static_cast<float>(y) - centerY;
+                float distanceToCenter = std::sqrt(deltaX * deltaX + deltaY * deltaY);
+                if (distanceToCenter < 1.0f) {
+                    std::copy_n(imageData.begin() + outputIndex, channels, output.begin() + outputIndex);
+                    continue;
+                }
+                float dirX = deltaX / distanceToCenter;
+                float dirY = deltaY / distanceToCenter;
+                float sampleStep = std::max(1.0f, 1.0f + (distanceToCenter / maxPossibleDist) * stepFactor * m_intensity);
+
+                // Геометрия сэмпла считается один раз для всех каналов
+                std::fill(accumulated.begin(), accumulated.end(), 0.0f);
+                for (int s = 0; s < numSamples; ++s) {
+                    float offset = static_cast<float>(s) * sampleStep;
+                    int sampleX = std::clamp(static_cast<int>(static_cast<float>(x) - dirX * offset), 0, width - 1);
+                    int sampleY = std::clamp(static_cast<int>(static_cast<float>(y) - dirY * offset), 0, height - 1);
+                    const unsigned char* pixel = imageData.data() + (static_cast<size_t>(sampleY) * width + sampleX) * channels;
+                    for (int c = 0; c < channels; ++c) accumulated[c] += pixel[c];
+                }
+                for (int c = 0; c < channels; ++c) {
+                    output[outputIndex + c] = static_cast<unsigned char>(accumulated[c] / static_cast<float>(numSamples));
+                }
+            }
+        }
+    });
+    imageData.swap(output);
+}
+
+void CpuRadialBlurFilter::SetEffectRadius(int intensity)
+{
+    m_intensity = std::max(0, intensity);
+}
+
+void CpuRadialBlurFilter::SetOption(const std::string& key, const std::string& value)
+{
+    if (key == "cx") m_centerX = std::stof(value);
+    else if (key == "cy") m_centerY = std::stof(value);
+    else if (key == "samples") m_samples = std::max(0, std::stoi(value));
+    else CpuImageFilter::SetOption(key, value);
+}
+
+void CpuPointOpsFilter::ApplyFilter(PixelBuffer& imageData, int width, int height, int channels)
+{
+    if (IsIdentity()) return;
+    ValidatePointOps(m_ops, channels);
+    bool hasSwizzle = std::any_of(m_ops.begin(), m_ops.end(), [](const PointOp& op) { return op.type == PointOpType::SWIZZLE; });
+    if (!hasSwizzle) {
+        // Без перестановки каналов операции независимы по каналам: 256 значений считаются заранее
+        std::array<unsigned char, 256> table{};
+        for (int value = 0; value < 256; ++value) {
+            float normalized = static_cast<float>(value) / 255.0f;
+            ApplyPointOps(m_ops, &normalized, 1);
+            table[value] = ToByte(normalized * 255.0f);
+        }
+        const bool keepAlpha = channels == 2 || channels == 4;
+        ParallelForRows(height, [&](int rowBegin, int rowEnd) {
+            for (size_t index = static_cast<size_t>(rowBegin) * width * channels;
+                 index < static_cast<size_t>(rowEnd) * width * channels; ++index) {
+                if (!keepAlpha || index % channels != static_cast<size_t>(channels - 1)) imageData[index] = table[imageData[index]];
+            }
+        });
+        return;
+    }
+    ParallelForRows(height, [&](int rowBegin, int rowEnd) {
+        float pixel[4];
+        for (size_t index = static_cast<size_t>(rowBegin) * width * channels;
+             index < static_cast<size_t>(rowEnd) * width * channels; index += channels) {
+            for (int c = 0; c < channels; ++c) pixel[c] = imageData[index + c] / 255.0f;
+            ApplyPointOps(m_ops, pixel, channels);
+            for (int c = 0; c < channels; ++c) imageData[index + c] = ToByte(pixel[c] * 255.0f);
+        }
+    });
+}
@@ -0,0 +1,54 @@
+#include "CpuImageFilter.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+const int MIN_ROWS_PER_TASK = 16; // Меньшие полосы не окупают запуск потока
+}
+
+void CpuImageFilter::SetOption(const std::string& key, const std::string& value)
+{
+    std::vector<std::string> ignored = GetIgnoredOptions();
+    if (std::find(ignored.begin(), ignored.end(), key) != ignored.end()) return;
+    throw std::runtime_error("Filter '" + GetName() + "' has no option '" + key + "' (value '" + value + "')");
+}
+
+void CpuImageFilter::ParallelForRows(int count, const std::function<void(int, int)>& body)
+{
+    if (count <= 0) return;
+    int threadCount = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    threadCount = std::min(threadCount, std::max(1, count / MIN_ROWS_PER_TASK));
+    if (threadCount == 1) {
+        body(0, count);
+        return;
+    }
+
+    // Полос в несколько раз больше потоков: полосы у краев и в центре стоят по-разному
+    const int taskCount = std::min(count, threadCount * 4);
+    std::atomic<int> nextTask{0};
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    auto worker = [&]() {
+        for (int task = nextTask++; task < taskCount; task = nextTask++) {
+            int begin = static_cast<int>(static_cast<long long>(count) * task / taskCount);
+            int end = static_cast<int>(static_cast<long long>(count) * (task + 1) / taskCount);
+            try {
+                body(begin, end);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) error = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < threadCount; ++i) threads.emplace_back(worker);
+    worker();
+    for (std::thread& thread : threads) thread.join();
+    if (error) std::rethrow_exception(error);
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include "IImageFilter.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+// Базовый класс фильтров CPU-бэкенда (--backend cpu): не требует платформы OpenCL.
+// Строки изображения делятся на полосы, полосы обрабатываются в std::thread.
+class CpuImageFilter : public IImageFilter
+{
+public:
+    // Те же ключи, что у OpenCL-версии фильтра, чтобы цепочки не зависели от бэкенда.
+    // Опции, выбирающие ядро ("algo" и пороги), здесь не действуют. Неизвестный ключ - исключение.
+    virtual void SetOption(const std::string& key, const std::string& value);
+
+    // true, если с текущими параметрами фильтр не меняет изображение и его можно пропустить
+    [[nodiscard]] virtual bool IsIdentity() const { return false; }
+
+protected:
+    // body(begin, end) для полос [begin, end) из count строк; исключение из потока
+    // пробрасывается вызывающему после завершения всех потоков
+    static void ParallelForRows(int count, const std::function<void(int, int)>& body);
+
+    // Ключи, которые SetOption принимает и пропускает (см. выше)
+    [[nodiscard]] virtual std::vector<std::string> GetIgnoredOptions() const { return {}; }
+};
@@ -0,0 +1,183 @@
+#include "CpuSimd.h"
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CPU_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define CPU_TARGET_AVX2
+#else
+#define CPU_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace
+{
+SimdLevel DetectSimdLevel()
+{
+#if defined(CPU_SIMD_X86)
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx2 = false;
+    if (maxLeaf >= 7 && osxsave && (_xgetbv(0) & 0x6) == 0x6) {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    bool sse2 = __builtin_cpu_supports("sse2");
+    bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+    if (avx2) return SimdLevel::AVX2;
+    if (sse2) return SimdLevel::SSE2;
+#endif
+    return SimdLevel::SCALAR;
+}
+
+// Сеть Devillard (opt_med9) на 19 компараторов; Ops задает тип вектора и min/max
+template <typename Ops>
+typename Ops::Vector Median9(typename Ops::Vector* p)
+{
+    auto sort = [p](int a, int b) {
+        typename Ops::Vector low = Ops::Min(p[a], p[b]);
+        p[b] = Ops::Max(p[a], p[b]);
+        p[a] = low;
+    };
+    sort(1, 2); sort(4, 5); sort(7, 8); sort(0, 1); sort(3, 4); sort(6, 7);
+    sort(1, 2); sort(4, 5); sort(7, 8); sort(0, 3); sort(5, 8); sort(4, 7);
+    sort(3, 6); sort(1, 4); sort(2, 5); sort(4, 7); sort(4, 2); sort(6, 4);
+    sort(4, 2);
+    return p[4];
+}
+
+template <typename Ops>
+size_t Median3x3Vectors(const uint8_t* above, const uint8_t* row, const uint8_t* below, uint8_t* output,
+                        size_t begin, size_t end, size_t stride)
+{
+    size_t i = begin;
+    for (; i + Ops::WIDTH <= end; i += Ops::WIDTH) {
+        typename Ops::Vector p[9] = {
+                Ops::Load(above + i - stride), Ops::Load(above + i), Ops::Load(above + i + stride),
+                Ops::Load(row + i - stride), Ops::Load(row + i), Ops::Load(row + i + stride),
+                Ops::Load(below + i - stride), Ops::Load(below + i), Ops::Load(below + i + stride)};
+        Ops::Store(output + i, Median9<Ops>(p));
+    }
+    return i; // Хвост короче вектора досчитывает скалярный вариант
+}
+
+struct ScalarOps
+{
+    using Vector = uint8_t;
+    static constexpr size_t WIDTH = 1;
+    static Vector Load(const uint8_t* p) { return *p; }
+    static void Store(uint8_t* p, Vector v) { *p = v; }
+    static Vector Min(Vector a, Vector b) { return std::min(a, b); }
+    static Vector Max(Vector a, Vector b) { return std::max(a, b); }
+};
+
+void AccumulateScaledScalar(float* dst, const float* src, float weight, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) dst[i] += weight * src[i];
+}
+
+#if defined(CPU_SIMD_X86)
+struct Sse2Ops
+{
+    using Vector = __m128i;
+    static constexpr size_t WIDTH = 16;
+    static Vector Load(const uint8_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static void Store(uint8_t* p, Vector v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    static Vector Min(Vector a, Vector b) { return _mm_min_epu8(a, b); }
+    static Vector Max(Vector a, Vector b) { return _mm_max_epu8(a, b); }
+};
+
+void AccumulateScaledSse2(float* dst, const float* src, float weight, size_t count)
+{
+    __m128 w = _mm_set1_ps(weight);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(w, _mm_loadu_ps(src + i))));
+    }
+    AccumulateScaledScalar(dst + i, src + i, weight, count - i);
+}
+
+CPU_TARGET_AVX2 void AccumulateScaledAvx2(float* dst, const float* src, float weight, size_t count)
+{
+    __m256 w = _mm256_set1_ps(weight);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_mul_ps(w, _mm256_loadu_ps(src + i))));
+    }
+    AccumulateScaledScalar(dst + i, src + i, weight, count - i);
+}
+
+// Сеть развернута отдельно: функции с target("avx2") не могут вызывать встраиваемые
+// обертки без этого атрибута, поэтому шаблон Ops здесь не используется
+#define AVX2_SORT(a, b) { __m256i low = _mm256_min_epu8(p[a], p[b]); p[b] = _mm256_max_epu8(p[a], p[b]); p[a] = low; }
+CPU_TARGET_AVX2 size_t Median3x3Avx2(const uint8_t* above, const uint8_t* row, const uint8_t* below, uint8_t* output,
+                                     size_t begin, size_t end, size_t stride)
+{
+    size_t i = begin;
+    for (; i + 32 <= end; i += 32) {
+        const uint8_t* rows[3] = {above, row, below};
+        __m256i p[9];
+        for (int r = 0; r < 3; ++r) {
+            p[r * 3 + 0] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[r] + i - stride));
+            p[r * 3 + 1] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[r] + i));
+            p[r * 3 + 2] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[r] + i + stride));
+        }
+        AVX2_SORT(1, 2) AVX2_SORT(4, 5) AVX2_SORT(7, 8) AVX2_SORT(0, 1) AVX2_SORT(3, 4) AVX2_SORT(6, 7)
+        AVX2_SORT(1, 2) AVX2_SORT(4, 5) AVX2_SORT(7, 8) AVX2_SORT(0, 3) AVX2_SORT(5, 8) AVX2_SORT(4, 7)
+        AVX2_SORT(3, 6) AVX2_SORT(1, 4) AVX2_SORT(2, 5) AVX2_SORT(4, 7) AVX2_SORT(4, 2) AVX2_SORT(6, 4)
+        AVX2_SORT(4, 2)
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), p[4]);
+    }
+    return i;
+}
+#undef AVX2_SORT
+#endif
+}
+
+SimdLevel GetSimdLevel()
+{
+    static const SimdLevel level = DetectSimdLevel();
+    return level;
+}
+
+const char* GetSimdLevelName(SimdLevel level)
+{
+    switch (level) {
+        case SimdLevel::AVX2: return "AVX2";
+        case SimdLevel::SSE2: return "SSE2";
+        default: return "scalar";
+    }
+}
+
+void AccumulateScaled(float* dst, const float* src, float weight, size_t count)
+{
+#if defined(CPU_SIMD_X86)
+    switch (GetSimdLevel()) {
+        case SimdLevel::AVX2: AccumulateScaledAvx2(dst, src, weight, count); return;
+        case SimdLevel::SSE2: AccumulateScaledSse2(dst, src, weight, count); return;
+        default: break;
+    }
+#endif
+    AccumulateScaledScalar(dst, src, weight, count);
+}
+
+void Median3x3Span(const uint8_t* above, const uint8_t* row, const uint8_t* below, uint8_t* output,
+                   size_t begin, size_t end, size_t stride)
+{
+    size_t done = begin;
+#if defined(CPU_SIMD_X86)
+    if (GetSimdLevel() == SimdLevel::AVX2) done = Median3x3Avx2(above, row, below, output, done, end, stride);
+    if (GetSimdLevel() != SimdLevel::SCALAR) done = Median3x3Vectors<Sse2Ops>(above, row, below, output, done, end, stride);
+#endif
+    Median3x3Vectors<ScalarOps>(above, row, below, output, done, end, stride);
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Набор инструкций для горячих циклов CPU-бэкенда. Выбирается один раз по CPUID,
+// поэтому бинарник собирается без -mavx2 и работает и на старых процессорах.
+enum class SimdLevel
+{
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+[[nodiscard]] SimdLevel GetSimdLevel();
+[[nodiscard]] const char* GetSimdLevelName(SimdLevel level);
+
+// dst[i] += weight * src[i] для i < count
+void AccumulateScaled(float* dst, const float* src, float weight, size_t count);
+
+// Медиана 3x3 для байтов [begin, end) строки: соседи по горизонтали отстоят на stride байт
+// (число каналов), above/row/below - предыдущая, текущая и следующая строки.
+// Вызывающий гарантирует, что begin >= stride и end + stride не выходит за строку.
+void Median3x3Span(const uint8_t* above, const uint8_t* row, const uint8_t* below, uint8_t* output,
+                   size_t begin, size_t end, size_t stride);
@@ -0,0 +1,150 @@
+#include "DeviceBufferPool.h"
+#include "OpenCLUtils.h"
+#include <iomanip>
+
+DeviceBufferPool::DeviceBufferPool(cl_context context, cl_mem_flags hostFlags)
+        : m_context(context), m_hostFlags(hostFlags)
+{
+}
+
+DeviceBufferPool::~DeviceBufferPool()
+{
+    // Выданные, но не возвращенные буферы тоже освобождаем: контекст вот-вот будет уничтожен
+    for (auto& [bucket, buffers] : m_idleBuffers) {
+        for (const IdleBuffer& idle : buffers) {
+            if (idle.fence) clReleaseEvent(idle.fence);
+        }
+    }
+    for (auto& [buffer, bucket] : m_bucketOf) clReleaseMemObject(buffer);
+}
+
+size_t DeviceBufferPool::BucketSize(size_t sizeBytes)
+{
+    const size_t minBucket = 4096;
+    if (sizeBytes <= minBucket) return minBucket;
+    // Старшая степень двойки, не превосходящая sizeBytes, делится на 8 корзин
+    size_t power = minBucket;
+    while (power <= sizeBytes / 2) power *= 2;
+    size_t step = power / 8;
+    return (sizeBytes + step - 1) / step * step;
+}
+
+cl_mem DeviceBufferPool::Acquire(size_t sizeBytes)
+{
+    const size_t bucket = BucketSize(sizeBytes);
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_idleBuffers.find(bucket);
+    if (it != m_idleBuffers.end()) {
+        std::vector<IdleBuffer>& buffers = it->second;
+        // С конца: последний возвращенный буфер скорее всего еще в кэше устройства
+        for (size_t i = buffers.size(); i-- > 0;) {
+            if (!IsFenceComplete(buffers[i].fence)) continue;
+            cl_mem buffer = buffers[i].buffer;
+            if (buffers[i].fence) clReleaseEvent(buffers[i].fence);
+            buffers.erase(buffers.begin() + static_cast<std::ptrdiff_t>(i));
+            m_stats.idleBytes -= bucket;
+            ++m_stats.hits;
+            return buffer;
+        }
+    }
+
+    ++m_stats.misses;
+    cl_int err;
+    cl_mem buffer = clCreateBuffer(m_context, CL_MEM_READ_WRITE | m_hostFlags, bucket, nullptr, &err);
+    if (err == CL_MEM_OBJECT_ALLOCATION_FAILURE || err == CL_OUT_OF_RESOURCES) {
+        // Память могут держать свободные буферы других размеров - отдаем их и пробуем еще раз
+        TrimLocked();
+        buffer = clCreateBuffer(m_context, CL_MEM_READ_WRITE | m_hostFlags, bucket, nullptr, &err);
+    }
+    CheckCLError(err, "DeviceBufferPool clCreateBuffer");
+
+    m_bucketOf.emplace(buffer, bucket);
+    m_stats.residentBytes += bucket;
+    return buffer;
+}
+
+void DeviceBufferPool::Release(cl_mem buffer)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_bucketOf.find(buffer);
+    if (it == m_bucketOf.end()) {
+        clReleaseMemObject(buffer); // Чужой буфер: просто освобождаем
+        return;
+    }
+    m_idleBuffers[it->second].push_back({buffer, nullptr});
+    m_stats.idleBytes += it->second;
+}
+
+void DeviceBufferPool::Release(cl_mem buffer, cl_event fence)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_bucketOf.find(buffer);
+    if (it == m_bucketOf.end()) {
+        clReleaseMemObject(buffer); // Освобождение отложит сам OpenCL, пока команды не завершатся
+        return;
+    }
+    clRetainEvent(fence);
+    m_idleBuffers[it->second].push_back({buffer, fence});
+    m_stats.idleBytes += it->second;
+}
+
+bool DeviceBufferPool::IsFenceComplete(cl_event fence)
+{
+    if (!fence) return true;
+    cl_int status = CL_QUEUED;
+    cl_int err = clGetEventInfo(fence, CL_EVENT_COMMAND_EXECUTION_STATUS, sizeof(status), &status, nullptr);
+    // Отрицательный статус - команда завершилась с ошибкой, буфер все равно больше не используется
+    return err != CL_SUCCESS || status <= CL_COMPLETE;
+}
+
+void DeviceBufferPool::Trim()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    TrimLocked();
+}
+
+void DeviceBufferPool::TrimLocked()
+{
+    for (auto& [bucket, buffers] : m_idleBuffers) {
+        for (const IdleBuffer& idle : buffers) {
+            // clReleaseMemObject безопасен и для буфера за барьером: удаление отложится до конца команд
+            if (idle.fence) clReleaseEvent(idle.fence);
+            clReleaseMemObject(idle.buffer);
+            m_bucketOf.erase(idle.buffer);
+            m_stats.residentBytes -= bucket;
+        }
+    }
+    m_idleBuffers.clear();
+    m_stats.idleBytes = 0;
+}
+
+DeviceBufferPool::Stats DeviceBufferPool::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void DeviceBufferPool::PrintStats(std::ostream& out) const
+{
+    Stats stats = GetStats();
+    out << "Buffer pool: hits=" << stats.hits << " misses=" << stats.misses
+        << " resident=" << std::fixed << std::setprecision(1) << stats.residentBytes / (1024.0 * 1024.0) << " MiB"
+        << " idle=" << stats.idleBytes / (1024.0 * 1024.0) << " MiB" << std::endl;
+}
+
+void PooledBuffer::ResetAfter(cl_command_queue queue)
+{
+    if (!m_buffer) return;
+    cl_event fence = nullptr;
+    cl_int err = clEnqueueMarkerWithWaitList(queue, 0, nullptr, &fence);
+    if (err != CL_SUCCESS) {
+        // Без маркера дожидаемся очереди, чтобы буфер не попал к другому владельцу раньше времени
+        clFinish(queue);
+        Reset();
+        return;
+    }
+    m_pool->Release(m_buffer, fence);
+    clReleaseEvent(fence);
+    m_buffer = nullptr;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <CL/cl.h>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+// Пул буферов устройства с округлением размера до корзин (8 корзин на каждую степень двойки,
+// перерасход не больше 12.5%). Повторные вызовы фильтров с теми же размерами изображения
+// получают уже выделенные cl_mem вместо clCreateBuffer/clReleaseMemObject на каждый кадр.
+// Все буферы создаются с CL_MEM_READ_WRITE (плюс hostFlags, например CL_MEM_ALLOC_HOST_PTR на
+// устройствах с общей памятью); содержимое полученного буфера не определено.
+class DeviceBufferPool
+{
+public:
+    struct Stats
+    {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t residentBytes = 0; // Все буферы пула: выданные и свободные
+        size_t idleBytes = 0;     // Свободные, ждущие повторного использования
+    };
+
+    explicit DeviceBufferPool(cl_context context, cl_mem_flags hostFlags = 0);
+    ~DeviceBufferPool();
+    DeviceBufferPool(const DeviceBufferPool&) = delete;
+    DeviceBufferPool& operator=(const DeviceBufferPool&) = delete;
+
+    // Буфер не меньше sizeBytes; вернуть его нужно через Release
+    cl_mem Acquire(size_t sizeBytes);
+    void Release(cl_mem buffer);
+    // Возврат буфера, который еще используется командами в очереди: повторно он будет выдан
+    // только после завершения fence. Пул удерживает событие (clRetainEvent) сам.
+    void Release(cl_mem buffer, cl_event fence);
+    // Освобождает все свободные буферы (выданные не трогает)
+    void Trim();
+
+    [[nodiscard]] Stats GetStats() const;
+    void PrintStats(std::ostream& out) const;
+
+private:
+    struct IdleBuffer
+    {
+        cl_mem buffer;
+        cl_event fence; // nullptr - буфер свободен сразу
+    };
+
+    static size_t BucketSize(size_t sizeBytes);
+    static bool IsFenceComplete(cl_event fence);
+    void TrimLocked();
+
+    cl_context m_context;
+    cl_mem_flags m_hostFlags;
+    std::map<size_t, std::vector<IdleBuffer>> m_idleBuffers; // Размер корзины -> свободные буферы
+    std::unordered_map<cl_mem, size_t> m_bucketOf;       // Все буферы пула -> размер корзины
+    Stats m_stats;
+    mutable std::mutex m_mutex;
+};
+
+// RAII-обертка: возвращает буфер в пул при разрушении
+class PooledBuffer
+{
+public:
+    PooledBuffer() = default;
+    PooledBuffer(DeviceBufferPool& pool, size_t sizeBytes)
+            : m_pool(&pool), m_buffer(pool.Acquire(sizeBytes)) {}
+    ~PooledBuffer() { Reset(); }
+
+    PooledBuffer(PooledBuffer&& other) noexcept
+            : m_pool(other.m_pool), m_buffer(other.m_buffer) { other.m_buffer = nullptr; }
+    PooledBuffer& operator=(PooledBuffer&& other) noexcept
+    {
+        if (this != &other) {
+            Reset();
+            m_pool = other.m_pool;
+            m_buffer = other.m_buffer;
+            other.m_buffer = nullptr;
+        }
+        return *this;
+    }
+    PooledBuffer(const PooledBuffer&) = delete;
+    PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+    [[nodiscard]] cl_mem Get() const { return m_buffer; }
+    // Указатель на хэндл - удобно передавать в clSetKernelArg
+    [[nodiscard]] const cl_mem* GetPtr() const { return &m_buffer; }
+
+    void Reset()
+    {
+        if (m_buffer) m_pool->Release(m_buffer);
+        m_buffer = nullptr;
+    }
+
+    // Возвращает буфер в пул с барьером на все команды, уже поставленные в queue
+    void ResetAfter(cl_command_queue queue);
+
+private:
+    DeviceBufferPool* m_pool = nullptr;
+    cl_mem m_buffer = nullptr;
+};
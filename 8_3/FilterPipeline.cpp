@@ -0,0 +1,402 @@
+#include "FilterPipeline.h"
+#include "CpuFilters.h"
+#include "CpuSimd.h"
+#include "GaussianFilter.h"
+#include "MedianFilter.h"
+#include "MotionBlurFilter.h"
+#include "OpenCLDevices.h"
+#include "OpenCLUtils.h"
+#include "PointOpsFilter.h"
+#include "RadialBlurFilter.h"
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+std::vector<FilterSpec> ParseFilterChain(const std::string& chain, int defaultParameter)
+{
+    std::vector<FilterSpec> specs;
+    std::stringstream chainStream(chain);
+    std::string item;
+    while (std::getline(chainStream, item, ',')) {
+        if (item.empty()) throw std::runtime_error("Empty filter in chain '" + chain + "'.");
+        FilterSpec spec;
+        std::stringstream itemStream(item);
+        std::getline(itemStream, spec.name, ':');
+        spec.parameter = defaultParameter;
+        const bool isPointOp = IsPointOp(spec.name);
+        std::string field;
+        while (std::getline(itemStream, field, ':')) {
+            size_t equalsPos = field.find('=');
+            if (equalsPos != std::string::npos) {
+                spec.options[field.substr(0, equalsPos)] = field.substr(equalsPos + 1);
+                continue;
+            }
+            spec.argument = field;
+            size_t parsed = 0;
+            try {
+                int value = std::stoi(field, &parsed);
+                if (parsed == field.size()) spec.parameter = value;
+            } catch (const std::logic_error&) {
+                parsed = 0;
+            }
+            if (!isPointOp && parsed != field.size()) {
+                throw std::runtime_error("Filter parameter must be an integer: " + item);
+            }
+        }
+        if (isPointOp) {
+            (void)ParsePointOp(spec.name, spec.argument); // Ошибки аргумента - сразу при разборе цепочки
+        } else if (spec.parameter < 0) {
+            throw std::runtime_error("Filter parameter (radius/length/intensity) must be non-negative: " + item);
+        }
+        specs.push_back(spec);
+    }
+    if (specs.empty()) throw std::runtime_error("Filter chain is empty.");
+    return specs;
+}
+
+std::unique_ptr<OpenCLImageFilter> CreateImageFilter(const FilterSpec& spec)
+{
+    std::unique_ptr<OpenCLImageFilter> filter;
+    if (IsPointOp(spec.name)) filter = std::make_unique<PointOpsFilter>(std::vector<PointOp>{ParsePointOp(spec.name, spec.argument)});
+    else if (spec.name == "gaussian") filter = std::make_unique<GaussianFilter>(spec.parameter);
+    else if (spec.name == "median") filter = std::make_unique<MedianFilter>(spec.parameter);
+    else if (spec.name == "motion") filter = std::make_unique<MotionBlurFilter>(spec.parameter);
+    else if (spec.name == "radial") filter = std::make_unique<RadialBlurFilter>(spec.parameter);
+    else throw std::runtime_error("Unsupported filter type: " + spec.name);
+
+    for (const auto& [key, value] : spec.options) filter->SetOption(key, value);
+    return filter;
+}
+
+std::unique_ptr<CpuImageFilter> CreateCpuImageFilter(const FilterSpec& spec)
+{
+    std::unique_ptr<CpuImageFilter> filter;
+    if (IsPointOp(spec.name)) filter = std::make_unique<CpuPointOpsFilter>(std::vector<PointOp>{ParsePointOp(spec.name, spec.argument)});
+    else if (spec.name == "gaussian") filter = std::make_unique<CpuGaussianFilter>(spec.parameter);
+    else if (spec.name == "median") filter = std::make_unique<CpuMedianFilter>(spec.parameter);
+    else if (spec.name == "motion") filter = std::make_unique<CpuMotionBlurFilter>(spec.parameter);
+    else if (spec.name == "radial") filter = std::make_unique<CpuRadialBlurFilter>(spec.parameter);
+    else throw std::runtime_error("Unsupported filter type: " + spec.name);
+
+    for (const auto& [key, value] : spec.options) filter->SetOption(key, value);
+    return filter;
+}
+
+FilterBackend ParseFilterBackend(const std::string& value)
+{
+    if (value.empty() || value == "auto") return FilterBackend::AUTO;
+    if (value == "opencl") return FilterBackend::OPENCL;
+    if (value == "cpu") return FilterBackend::CPU;
+    throw std::runtime_error("Unknown backend '" + value + "' (cpu, opencl, auto)");
+}
+
+FilterBackend FilterPipeline::s_backend = FilterBackend::AUTO;
+int FilterPipeline::s_stripRows = 0;
+
+FilterPipeline::FilterPipeline(std::vector<std::unique_ptr<OpenCLImageFilter>> filters)
+        : m_filters(std::move(filters))
+{
+}
+
+FilterPipeline::FilterPipeline(std::vector<std::unique_ptr<CpuImageFilter>> cpuFilters)
+        : m_cpuFilters(std::move(cpuFilters))
+{
+}
+
+void FilterPipeline::ConfigureBackend(FilterBackend backend)
+{
+    s_backend = backend;
+}
+
+void FilterPipeline::ConfigureStripRows(int rows)
+{
+    s_stripRows = std::max(0, rows);
+}
+
+FilterBackend FilterPipeline::GetResolvedBackend()
+{
+    if (s_backend != FilterBackend::AUTO) return s_backend;
+    // Без ICD clGetPlatformIDs возвращает ошибку, которую EnumerateOpenCLDevices бросает исключением
+    static const FilterBackend resolved = [] {
+        try {
+            if (!EnumerateOpenCLDevices().empty()) return FilterBackend::OPENCL;
+        } catch (const std::exception&) {
+        }
+        std::cout << "No OpenCL devices found, using the CPU backend (" << GetSimdLevelName(GetSimdLevel()) << ")." << std::endl;
+        return FilterBackend::CPU;
+    }();
+    return resolved;
+}
+
+FilterPipeline FilterPipeline::FromSpecs(const std::vector<FilterSpec>& specs)
+{
+    const bool onCpu = GetResolvedBackend() == FilterBackend::CPU;
+    std::vector<std::unique_ptr<CpuImageFilter>> cpuFilters;
+    std::vector<std::unique_ptr<OpenCLImageFilter>> filters;
+    for (size_t i = 0; i < specs.size();) {
+        if (!IsPointOp(specs[i].name)) {
+            if (onCpu) cpuFilters.push_back(CreateCpuImageFilter(specs[i]));
+            else filters.push_back(CreateImageFilter(specs[i]));
+            ++i;
+            continue;
+        }
+        // Подряд идущие операции - одно ядро: программа генерируется по их списку
+        std::vector<PointOp> ops;
+        for (; i < specs.size() && IsPointOp(specs[i].name); ++i) {
+            if (!specs[i].options.empty()) throw std::runtime_error(specs[i].name + " has no options");
+            ops.push_back(ParsePointOp(specs[i].name, specs[i].argument));
+        }
+        if (onCpu) {
+            cpuFilters.push_back(std::make_unique<CpuPointOpsFilter>(std::move(ops)));
+        } else if (!filters.empty() && filters.back()->SupportsEpilogue() && !filters.back()->HasEpilogue()) {
+            // Операции выполняются в последнем ядре фильтра перед записью: без лишнего прохода по памяти
+            filters.back()->SetEpilogue(std::move(ops));
+        } else {
+            filters.push_back(std::make_unique<PointOpsFilter>(std::move(ops)));
+        }
+    }
+    if (onCpu) return FilterPipeline(std::move(cpuFilters));
+    return FilterPipeline(std::move(filters));
+}
+
+void FilterPipeline::ApplyOnCpu(PixelBuffer& imageData, int width, int height, int channels)
+{
+    for (const auto& filter : m_cpuFilters) {
+        if (!filter->IsIdentity()) filter->ApplyFilter(imageData, width, height, channels);
+    }
+}
+
+void FilterPipeline::Apply(PixelBuffer& imageData, int width, int height, int channels, ElementType elementType)
+{
+    if (!m_cpuFilters.empty()) {
+        if (elementType != ElementType::UCHAR) {
+            throw std::runtime_error(std::string("The CPU backend supports only 8-bit values, got ") +
+                                     GetElementTypeName(elementType) + "; use --element u8 or an OpenCL device.");
+        }
+        ApplyOnCpu(imageData, width, height, channels);
+        return;
+    }
+
+    std::vector<OpenCLImageFilter*> activeFilters;
+    for (const auto& filter : m_filters) {
+        if (!filter->IsIdentity()) activeFilters.push_back(filter.get());
+    }
+    if (activeFilters.empty()) return;
+
+    // Все фильтры берут рантайм через OpenCLRuntime::Acquire(), так что он у них общий
+    OpenCLRuntime& runtime = *activeFilters.front()->GetRuntime();
+    size_t imageSizeBytes = static_cast<size_t>(width) * height * channels * GetElementSize(elementType);
+
+    // Поля полос складываются: каждый следующий фильтр читает уже размытые поля предыдущего
+    int haloRows = 0;
+    for (OpenCLImageFilter* filter : activeFilters) {
+        int filterHalo = filter->GetHaloRows();
+        haloRows = filterHalo < 0 || haloRows < 0 ? -1 : haloRows + filterHalo;
+    }
+    // Память полосы из rows строк: два буфера ping-pong и временные буферы фильтров (GetScratchBytes).
+    // Каждое выделение - не больше maxAllocBytes, все полосы в полете вместе - не больше половины памяти устройства.
+    // Ядра считают индекс значения в int, поэтому в полосе не больше INT_MAX значений, даже если
+    // устройство (CPU-рантаймы с maxAllocBytes в несколько ГБ) выделило бы больше
+    const OpenCLDeviceInfo& device = runtime.GetDeviceInfo();
+    const size_t rowBytes = static_cast<size_t>(width) * channels * GetElementSize(elementType);
+    const size_t rowValues = static_cast<size_t>(width) * channels;
+    const int maxIndexedRows = static_cast<int>(std::min<size_t>(height, std::numeric_limits<int>::max() / rowValues));
+    auto fitsDevice = [&](int rows, size_t stripsInFlight) {
+        if (rows > maxIndexedRows) return false;
+        size_t stripBytes = static_cast<size_t>(rows) * rowBytes;
+        size_t scratchBytes = 0;
+        for (OpenCLImageFilter* filter : activeFilters) {
+            size_t filterScratch = filter->GetScratchBytes(width, rows, channels, elementType);
+            if (filterScratch > device.maxAllocBytes) return false;
+            scratchBytes += filterScratch; // Пул может не успеть вернуть буфер одного фильтра до следующего
+        }
+        return stripBytes <= device.maxAllocBytes && stripsInFlight * (2 * stripBytes + scratchBytes) <= device.globalMemBytes / 2;
+    };
+    int stripRows = s_stripRows;
+    if (stripRows == 0 && !fitsDevice(height, 1)) {
+        if (haloRows < 0) {
+            stripRows = 1; // Ниже - предупреждение и попытка целиком
+        } else {
+            // Самое высокое ядро полосы, при котором STRIP_SLOTS полос с полями помещаются на устройство
+            auto stripFits = [&](int coreRows) { return fitsDevice(std::min(height, coreRows + 2 * haloRows), STRIP_SLOTS); };
+            if (!stripFits(1)) {
+                throw std::runtime_error("Image rows are too wide for the device: " + std::to_string(2 * haloRows + 1) +
+                                         " rows of " + std::to_string(rowBytes) + " bytes with filter buffers exceed device memory" +
+                                         " or the 32-bit index range of the kernels.");
+            }
+            int fittingRows = 1;
+            int tooManyRows = height;
+            while (tooManyRows - fittingRows > 1) {
+                int rows = fittingRows + (tooManyRows - fittingRows) / 2;
+                if (stripFits(rows)) fittingRows = rows;
+                else tooManyRows = rows;
+            }
+            stripRows = fittingRows;
+        }
+    }
+    if (stripRows > 0 && haloRows >= 0 && std::min(height, stripRows + 2 * haloRows) > maxIndexedRows) {
+        // Заданная --strip-rows высота тоже не выходит за диапазон индексов
+        stripRows = maxIndexedRows - 2 * haloRows;
+        if (stripRows < 1) {
+            throw std::runtime_error("Image rows are too wide for 32-bit kernel indices: " + std::to_string(2 * haloRows + 1) +
+                                     " rows of " + std::to_string(rowValues) + " values.");
+        }
+    }
+    if (stripRows > 0 && stripRows < height) {
+        if (haloRows < 0) {
+            // Радиальное размытие зависит от центра всего изображения; пробуем целиком
+            std::cerr << "Warning: the chain cannot be split into strips, processing the image as a whole." << std::endl;
+        } else {
+            ApplyInStrips(activeFilters, imageData, width, height, channels, elementType, haloRows, stripRows);
+            return;
+        }
+    }
+
+    if (height > maxIndexedRows) {
+        throw std::runtime_error("The image has more values than 32-bit kernel indices address and the chain "
+                                 "cannot be split into strips (radial blur depends on the whole image).");
+    }
+
+    if (runtime.UsesZeroCopy()) {
+        ApplyZeroCopy(activeFilters, imageData, width, height, channels, elementType);
+        return;
+    }
+
+    cl_command_queue queue = runtime.GetQueue();
+
+    PooledBuffer currentBuffer(runtime.GetBufferPool(), imageSizeBytes);
+    PooledBuffer nextBuffer(runtime.GetBufferPool(), imageSizeBytes);
+    cl_int err = clEnqueueWriteBuffer(queue, currentBuffer.Get(), CL_FALSE, 0, imageSizeBytes, imageData.data(), 0, nullptr,
+                                      runtime.GetProfiler().Track("Pipeline write", ProfileCategory::TRANSFER));
+    CheckCLError(err, "FilterPipeline clEnqueueWriteBuffer");
+
+    for (OpenCLImageFilter* filter : activeFilters) {
+        filter->EnqueueOnDevice(queue, currentBuffer.Get(), nextBuffer.Get(), width, height, channels, elementType);
+        std::swap(currentBuffer, nextBuffer); // Результат фильтра - вход следующего
+    }
+
+    err = clEnqueueReadBuffer(queue, currentBuffer.Get(), CL_TRUE, 0, imageSizeBytes, imageData.data(), 0, nullptr,
+                              runtime.GetProfiler().Track("Pipeline read", ProfileCategory::TRANSFER));
+    CheckCLError(err, "FilterPipeline clEnqueueReadBuffer");
+    clFinish(queue);
+}
+
+void FilterPipeline::ApplyZeroCopy(const std::vector<OpenCLImageFilter*>& filters, PixelBuffer& imageData,
+                                   int width, int height, int channels, ElementType elementType)
+{
+    OpenCLRuntime& runtime = *filters.front()->GetRuntime();
+    cl_command_queue queue = runtime.GetQueue();
+    size_t imageSizeBytes = static_cast<size_t>(width) * height * channels * GetElementSize(elementType);
+
+    // Ping-pong между imageData и вторым вектором хоста: загрузки и чтения нет, ядра работают с ними напрямую
+    PixelBuffer otherImage(imageData.size());
+    HostMappedBuffer currentBuffer(runtime.GetContext(), CL_MEM_READ_WRITE, imageData.data(), imageSizeBytes);
+    HostMappedBuffer nextBuffer(runtime.GetContext(), CL_MEM_READ_WRITE, otherImage.data(), imageSizeBytes);
+    for (OpenCLImageFilter* filter : filters) {
+        filter->EnqueueOnDevice(queue, currentBuffer.Get(), nextBuffer.Get(), width, height, channels, elementType);
+        std::swap(currentBuffer, nextBuffer);
+    }
+
+    currentBuffer.SyncToHost(queue, runtime.GetProfiler().Track("Pipeline map", ProfileCategory::TRANSFER));
+    clFinish(queue);
+    // После нечетного числа фильтров результат лежит во втором векторе
+    if (filters.size() % 2 == 1) imageData.swap(otherImage);
+}
+
+void FilterPipeline::ApplyInStrips(const std::vector<OpenCLImageFilter*>& filters, PixelBuffer& imageData,
+                                   int width, int height, int channels, ElementType elementType, int haloRows, int stripRows)
+{
+    OpenCLRuntime& runtime = *filters.front()->GetRuntime();
+    const size_t rowBytes = static_cast<size_t>(width) * channels * GetElementSize(elementType);
+    // Поля следующих полос читаются из исходного изображения, поэтому результат пишется отдельно
+    PixelBuffer result(imageData.size());
+
+    struct StripSlot
+    {
+        cl_event readEvent = nullptr;
+    };
+    std::vector<StripSlot> slots(STRIP_SLOTS);
+    auto waitSlot = [](StripSlot& slot) {
+        if (!slot.readEvent) return;
+        cl_int err = clWaitForEvents(1, &slot.readEvent);
+        clReleaseEvent(slot.readEvent);
+        slot.readEvent = nullptr;
+        CheckCLError(err, "FilterPipeline clWaitForEvents (strip)");
+    };
+
+    try {
+        size_t stripIndex = 0;
+        for (int coreBegin = 0; coreBegin < height; coreBegin += stripRows, ++stripIndex) {
+            int coreEnd = std::min(height, coreBegin + stripRows);
+            int stripBegin = std::max(0, coreBegin - haloRows);
+            int stripEnd = std::min(height, coreEnd + haloRows);
+            int stripHeight = stripEnd - stripBegin;
+            size_t stripBytes = static_cast<size_t>(stripHeight) * rowBytes;
+
+            // Не больше STRIP_SLOTS полос в полете: иначе пул выделил бы буферы под все полосы сразу
+            StripSlot& slot = slots[stripIndex % STRIP_SLOTS];
+            waitSlot(slot);
+            cl_command_queue queue = runtime.GetQueue(stripIndex % STRIP_SLOTS);
+
+            PooledBuffer currentBuffer(runtime.GetBufferPool(), stripBytes);
+            PooledBuffer nextBuffer(runtime.GetBufferPool(), stripBytes);
+            cl_int err = clEnqueueWriteBuffer(queue, currentBuffer.Get(), CL_FALSE, 0, stripBytes,
+                                              imageData.data() + static_cast<size_t>(stripBegin) * rowBytes, 0, nullptr,
+                                              runtime.GetProfiler().Track("Pipeline strip write", ProfileCategory::TRANSFER));
+            CheckCLError(err, "FilterPipeline clEnqueueWriteBuffer (strip)");
+
+            for (OpenCLImageFilter* filter : filters) {
+                filter->SetRowOrigin(stripBegin);
+                filter->EnqueueOnDevice(queue, currentBuffer.Get(), nextBuffer.Get(), width, stripHeight, channels, elementType);
+                std::swap(currentBuffer, nextBuffer);
+            }
+
+            // Назад читаются только строки ядра полосы; поля пересчитает соседняя полоса
+            size_t coreOffset = static_cast<size_t>(coreBegin - stripBegin) * rowBytes;
+            size_t coreBytes = static_cast<size_t>(coreEnd - coreBegin) * rowBytes;
+            err = clEnqueueReadBuffer(queue, currentBuffer.Get(), CL_FALSE, coreOffset, coreBytes,
+                                      result.data() + static_cast<size_t>(coreBegin) * rowBytes, 0, nullptr, &slot.readEvent);
+            CheckCLError(err, "FilterPipeline clEnqueueReadBuffer (strip)");
+            runtime.GetProfiler().Record("Pipeline strip read", ProfileCategory::TRANSFER, slot.readEvent);
+            currentBuffer.ResetAfter(queue);
+            nextBuffer.ResetAfter(queue);
+            clFlush(queue);
+        }
+        for (StripSlot& slot : slots) waitSlot(slot);
+        for (OpenCLImageFilter* filter : filters) filter->SetRowOrigin(0);
+    } catch (...) {
+        for (OpenCLImageFilter* filter : filters) filter->SetRowOrigin(0);
+        for (size_t i = 0; i < STRIP_SLOTS; ++i) clFinish(runtime.GetQueue(i));
+        for (StripSlot& slot : slots) {
+            if (slot.readEvent) clReleaseEvent(slot.readEvent);
+        }
+        throw;
+    }
+    imageData.swap(result);
+}
+
+int FilterPipeline::GetRequiredChannels() const
+{
+    int required = 0;
+    for (const auto& filter : m_filters) required = std::max(required, filter->GetRequiredChannels());
+    for (const auto& filter : m_cpuFilters) required = std::max(required, filter->GetRequiredChannels());
+    return required;
+}
+
+std::string FilterPipeline::GetDescription() const
+{
+    std::string description;
+    auto append = [&description](const IImageFilter& filter) {
+        if (!description.empty()) description += " -> ";
+        description += filter.GetName();
+    };
+    for (const auto& filter : m_filters) {
+        append(*filter);
+        if (filter->HasEpilogue()) description += " + " + DescribePointOps(filter->GetEpilogue());
+    }
+    for (const auto& filter : m_cpuFilters) append(*filter);
+    return description;
+}
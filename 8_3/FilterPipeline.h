@@ -0,0 +1,83 @@
+#pragma once
+#include "CpuImageFilter.h"
+#include "OpenCLImageFilter.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Один элемент цепочки фильтров из командной строки: "median:3:algo=tiled" -> {"median", 3, {algo: tiled}}
+struct FilterSpec
+{
+    std::string name;
+    int parameter = 5; // Радиус / длина / интенсивность - смысл зависит от фильтра
+    std::string argument; // Поле без '=' как есть: "2.2" для gamma, "bgr" для swizzle
+    std::map<std::string, std::string> options; // Передаются в OpenCLImageFilter::SetOption
+};
+
+// Разбирает "median:3,gaussian:5,motion:algo=x". Поля после имени разделяются ':';
+// поле с '=' - опция, без него - параметр. Фильтр без параметра получает defaultParameter.
+// У поэлементных операций (IsPointOp) параметр - число или строка: "gamma:2.2,swizzle:bgr".
+std::vector<FilterSpec> ParseFilterChain(const std::string& chain, int defaultParameter);
+
+// Фабрика фильтров по имени: gaussian, median, motion, radial и поэлементные операции (PointOps.h)
+std::unique_ptr<OpenCLImageFilter> CreateImageFilter(const FilterSpec& spec);
+// То же для CPU-бэкенда
+std::unique_ptr<CpuImageFilter> CreateCpuImageFilter(const FilterSpec& spec);
+
+enum class FilterBackend
+{
+    AUTO,   // OpenCL, если есть хотя бы одно устройство, иначе CPU
+    OPENCL,
+    CPU
+};
+
+// "cpu" | "opencl" | "auto"
+FilterBackend ParseFilterBackend(const std::string& value);
+
+// Цепочка фильтров, выполняемая целиком на устройстве: изображение загружается один раз,
+// фильтры по очереди пишут в один из двух буферов (ping-pong), на хост читается только
+// итоговый результат. Изображение, которое вместе с временными буферами фильтров не помещается
+// на устройство, проходит цепочку горизонтальными полосами с полями (см. OpenCLImageFilter::GetHaloRows
+// и GetScratchBytes).
+// На устройстве с общей памятью (OpenCLRuntime::UsesZeroCopy) загрузки и чтения нет вовсе.
+class FilterPipeline
+{
+public:
+    explicit FilterPipeline(std::vector<std::unique_ptr<OpenCLImageFilter>> filters);
+    explicit FilterPipeline(std::vector<std::unique_ptr<CpuImageFilter>> cpuFilters);
+    // Фильтры создаются на бэкенде, выбранном ConfigureBackend. Подряд идущие поэлементные
+    // операции собираются в одно ядро и по возможности сливаются с предыдущим фильтром (эпилог).
+    static FilterPipeline FromSpecs(const std::vector<FilterSpec>& specs);
+
+    // Действует на цепочки, созданные FromSpecs после вызова
+    static void ConfigureBackend(FilterBackend backend);
+    // AUTO разрешается проверкой наличия устройств OpenCL
+    [[nodiscard]] static FilterBackend GetResolvedBackend();
+    // Высота полосы (без полей) для любого размера изображения; 0 - полосы только при нехватке памяти
+    static void ConfigureStripRows(int rows);
+
+    // Значения типа elementType; CPU-бэкенд поддерживает только ElementType::UCHAR
+    void Apply(PixelBuffer& imageData, int width, int height, int channels, ElementType elementType = ElementType::UCHAR);
+
+    // Максимальное из требований фильтров (0 - подходит любое количество каналов)
+    [[nodiscard]] int GetRequiredChannels() const;
+    [[nodiscard]] std::string GetDescription() const;
+    [[nodiscard]] bool IsEmpty() const { return m_filters.empty() && m_cpuFilters.empty(); }
+
+private:
+    void ApplyOnCpu(PixelBuffer& imageData, int width, int height, int channels);
+    void ApplyZeroCopy(const std::vector<OpenCLImageFilter*>& filters, PixelBuffer& imageData,
+                       int width, int height, int channels, ElementType elementType);
+    void ApplyInStrips(const std::vector<OpenCLImageFilter*>& filters, PixelBuffer& imageData,
+                       int width, int height, int channels, ElementType elementType, int haloRows, int stripRows);
+
+    static constexpr size_t STRIP_SLOTS = 3; // Полос в работе одновременно: загрузка / вычисление / чтение
+
+    // Заполнен только один из списков, в зависимости от бэкенда
+    std::vector<std::unique_ptr<OpenCLImageFilter>> m_filters;
+    std::vector<std::unique_ptr<CpuImageFilter>> m_cpuFilters;
+
+    static FilterBackend s_backend;
+    static int s_stripRows;
+};
@@ -0,0 +1,534 @@
+#include "FilterVerification.h"
+#include "FilterPipeline.h"
+#include "GaussianFilter.h"
+#include "OpenCLDevices.h"
+#include "OpenCLRuntime.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+
+using Clock = std::chrono::high_resolution_clock;
+using Milliseconds = std::chrono::duration<double, std::milli>;
+
+namespace
+{
+const int TIMED_RUNS = 3;
+const int NO_MAX_ERROR = -1; // Максимальное отличие не проверяется, только среднее
+
+struct ImageSize
+{
+    int width;
+    int height;
+};
+
+// Нечетные размеры ловят ошибки на неполных рабочих группах и краях
+const ImageSize IMAGE_SIZES[] = {{67, 45}, {512, 384}};
+const int CHANNEL_COUNTS[] = {1, 3, 4};
+// Вход пересчитывается в тип, результат - обратно в 8 бит и сравнивается с тем же эталоном
+const ElementType WIDE_ELEMENT_TYPES[] = {ElementType::USHORT, ElementType::HALF, ElementType::FLOAT};
+// Полосы против изображения целиком: высота не делит 384, так что последняя полоса неполная
+const int STRIP_CHECK_ROWS = 37;
+const int STRIP_CHECK_LENGTH = 25;
+const int STRIP_CHECK_ANGLES[] = {30, 45, 80};
+// ApplyMedianFilter: массив окна рассчитан на 21x21 (MedianFilter::MAX_SORT_RADIUS)
+const int MEDIAN_SORT_MAX_RADIUS = 10;
+// Наклонный motion против среднего по точной линии: линии ядра идут с шагом 1/8 пикселя, и на резких
+// границах тестового изображения это до 4 уровней, в среднем меньше 0.1 (плюс округление float на устройстве)
+const int ANGLED_MAX = 5;
+const double ANGLED_MEAN = 0.15;
+// Box-приближение гауссианы на радиусах, где его выбирает auto (box_from = 16): три бокса против
+// точного ядра дают до 6 уровней на резких границах, в среднем меньше 0.6; прижатие к краю у обоих одинаковое
+const int BOX_MAX_ERROR = 7;
+const double BOX_MEAN_ERROR = 1.0;
+
+using Image = PixelBuffer;
+using ReferenceFilter = std::function<Image(const Image&, int width, int height, int channels, int parameter)>;
+
+using SupportPredicate = std::function<bool(int channels, ElementType elementType, int parameter)>;
+
+// Вариант реализации и допуск: точные варианты отличаются от эталона не больше чем на округление,
+// приближенные (box, image, polar) проверяются по среднему отличию
+struct Variant
+{
+    std::string algorithm; // Значение "algo" для OpenCL; "" - по умолчанию
+    int maxError;
+    double meanError;
+    // Заявленные ограничения варианта: вне них запуск пропускается. Пустой - поддерживается все;
+    // исключение в поддерживаемом сочетании - ошибка, а не пропуск
+    SupportPredicate supports = nullptr;
+};
+
+struct FilterCase
+{
+    std::string name;
+    std::vector<int> parameters;
+    ReferenceFilter reference;
+    std::vector<Variant> openclVariants;
+    Variant cpuVariant;
+    std::map<std::string, std::string> options = {}; // Опции фильтра кроме algo, общие для всех вариантов
+};
+
+struct Result
+{
+    std::string backend;
+    std::string device;
+    std::string filter;
+    std::string algorithm;
+    std::string options; // Опции фильтра кроме algo: "angle=30"
+    std::string element; // Тип значений на устройстве ("u8", "u16", "f16", "f32")
+    int parameter;
+    int width;
+    int height;
+    int channels;
+    int maxError;
+    double meanError;
+    bool passed;
+    double megapixelsPerSecond;
+    std::string skipReason; // Не пусто - вариант не запускался
+    std::string error;      // Не пусто - исключение в поддерживаемом сочетании (считается провалом)
+};
+
+unsigned char At(const Image& image, int width, int height, int channels, int x, int y, int c)
+{
+    x = std::clamp(x, 0, width - 1);
+    y = std::clamp(y, 0, height - 1);
+    return image[(static_cast<size_t>(y) * width + x) * channels + c];
+}
+
+Image ReferenceGaussian(const Image& image, int width, int height, int channels, int radius)
+{
+    std::vector<float> weights = GaussianFilter::CreateGaussianKernelValues(radius, GaussianFilter::SigmaForRadius(radius));
+    std::vector<double> rows(image.size());
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x)
+            for (int c = 0; c < channels; ++c) {
+                double sum = 0.0;
+                for (int k = -radius; k <= radius; ++k) sum += weights[k + radius] * At(image, width, height, channels, x + k, y, c);
+                rows[(static_cast<size_t>(y) * width + x) * channels + c] = sum;
+            }
+    Image result(image.size());
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x)
+            for (int c = 0; c < channels; ++c) {
+                double sum = 0.0;
+                for (int k = -radius; k <= radius; ++k) {
+                    int sourceY = std::clamp(y + k, 0, height - 1);
+                    sum += weights[k + radius] * rows[(static_cast<size_t>(sourceY) * width + x) * channels + c];
+                }
+                result[(static_cast<size_t>(y) * width + x) * channels + c] = static_cast<unsigned char>(std::clamp(std::lround(sum), 0L, 255L));
+            }
+    return result;
+}
+
+Image ReferenceMedian(const Image& image, int width, int height, int channels, int radius)
+{
+    Image result(image.size());
+    std::vector<unsigned char> window;
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x)
+            for (int c = 0; c < channels; ++c) {
+                window.clear();
+                for (int dy = -radius; dy <= radius; ++dy)
+                    for (int dx = -radius; dx <= radius; ++dx) window.push_back(At(image, width, height, channels, x + dx, y + dy, c));
+                std::nth_element(window.begin(), window.begin() + window.size() / 2, window.end());
+                result[(static_cast<size_t>(y) * width + x) * channels + c] = window[window.size() / 2];
+            }
+    return result;
+}
+
+// Горизонтальное размытие (angle = 0) с окном как в ApplyMotionBlur
+Image ReferenceMotion(const Image& image, int width, int height, int channels, int length)
+{
+    int start = -length / 2;
+    int end = length % 2 == 0 ? length / 2 - 1 : length / 2;
+    Image result(image.size());
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x)
+            for (int c = 0; c < channels; ++c) {
+                double sum = 0.0;
+                for (int k = start; k <= end; ++k) sum += At(image, width, height, channels, x + k, y, c);
+                result[(static_cast<size_t>(y) * width + x) * channels + c] = static_cast<unsigned char>(std::lround(sum / (end - start + 1)));
+            }
+    return result;
+}
+
+// Размытие вдоль направления (cos, -sin): среднее по отрезку линии через сам пиксель. Шаг - один пиксель
+// по основной оси (той, вдоль которой направление ближе), по второй оси - линейная интерполяция;
+// основная координата прижимается к краю, вторая берется на линии в этой точке. Ядро интерполирует
+// между линиями с шагом 1/8 пикселя (MotionBlurGeometry.h), поэтому отличается на резких границах
+ReferenceFilter ReferenceAngledMotion(int angleDegrees)
+{
+    return [angleDegrees](const Image& image, int width, int height, int channels, int length) {
+        const double angle = angleDegrees * 3.14159265358979323846 / 180.0;
+        const double dx = std::cos(angle);
+        const double dy = -std::sin(angle);
+        const bool horizontal = std::abs(dx) >= std::abs(dy);
+        const double slope = horizontal ? dy / dx : dx / dy;
+        const int majorLength = horizontal ? width : height;
+        const int minorLength = horizontal ? height : width;
+        const int samples = std::max(1, static_cast<int>(std::lround(length / std::sqrt(1.0 + slope * slope))));
+        const int start = -samples / 2;
+        const int end = samples % 2 == 0 ? samples / 2 - 1 : samples / 2;
+        auto sample = [&](int major, int minor, int c) {
+            return horizontal ? At(image, width, height, channels, major, minor, c) : At(image, width, height, channels, minor, major, c);
+        };
+
+        Image result(image.size());
+        for (int y = 0; y < height; ++y)
+            for (int x = 0; x < width; ++x) {
+                const int pixelMajor = horizontal ? x : y;
+                const int pixelMinor = horizontal ? y : x;
+                for (int c = 0; c < channels; ++c) {
+                    double sum = 0.0;
+                    for (int k = start; k <= end; ++k) {
+                        int major = std::clamp(pixelMajor + k, 0, majorLength - 1);
+                        double minor = pixelMinor + (major - pixelMajor) * slope;
+                        int minor0 = static_cast<int>(std::floor(minor));
+                        double weight = minor - minor0;
+                        double a = sample(major, std::clamp(minor0, 0, minorLength - 1), c);
+                        double b = sample(major, std::clamp(minor0 + 1, 0, minorLength - 1), c);
+                        sum += a + (b - a) * weight;
+                    }
+                    result[(static_cast<size_t>(y) * width + x) * channels + c] = static_cast<unsigned char>(std::lround(sum / (end - start + 1)));
+                }
+            }
+        return result;
+    };
+}
+
+// ApplyRadialBlur с центром в середине: сэмплы к центру, координаты отбрасыванием дробной части
+Image ReferenceRadial(const Image& image, int width, int height, int channels, int intensity)
+{
+    Image result(image.size());
+    double centerX = width / 2.0;
+    double centerY = height / 2.0;
+    double maxDistance = std::max(1.0, std::sqrt(centerX * centerX + centerY * centerY));
+    int samples = std::max(1, intensity / 2 + 1);
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x) {
+            double deltaX = x - centerX;
+            double deltaY = y - centerY;
+            double distance = std::sqrt(deltaX * deltaX + deltaY * deltaY);
+            for (int c = 0; c < channels; ++c) {
+                size_t index = (static_cast<size_t>(y) * width + x) * channels + c;
+                if (distance < 1.0) {
+                    result[index] = image[index];
+                    continue;
+                }
+                double step = std::max(1.0, 1.0 + distance / maxDistance * 0.005 * intensity * intensity);
+                double sum = 0.0;
+                for (int s = 0; s < samples; ++s) {
+                    int sampleX = static_cast<int>(x - deltaX / distance * s * step);
+                    int sampleY = static_cast<int>(y - deltaY / distance * s * step);
+                    sum += At(image, width, height, channels, sampleX, sampleY, c);
+                }
+                result[index] = static_cast<unsigned char>(sum / samples);
+            }
+        }
+    return result;
+}
+
+// Поэлементная гамма (PointOps.h): альфа четырехканальных изображений не меняется
+Image ReferenceGamma(const Image& image, int /*width*/, int /*height*/, int channels, int gamma)
+{
+    Image result(image.size());
+    for (size_t i = 0; i < image.size(); ++i) {
+        bool isAlpha = channels == 4 && i % 4 == 3;
+        double value = std::pow(image[i] / 255.0, 1.0 / gamma) * 255.0;
+        result[i] = isAlpha ? image[i] : static_cast<unsigned char>(std::clamp(std::lround(value), 0L, 255L));
+    }
+    return result;
+}
+
+std::vector<FilterCase> CreateFilterCases()
+{
+    const SupportPredicate sortWindowFits = [](int, ElementType, int radius) { return radius <= MEDIAN_SORT_MAX_RADIUS; };
+    std::vector<FilterCase> cases = {
+            {"gaussian", {1, 4, 12}, ReferenceGaussian,
+             {{"separable", 1, 0.5}, {"transpose", 1, 0.5}, {"planar", 1, 0.5}, {"box", NO_MAX_ERROR, 3.0}},
+             {"", 1, 0.5}},
+            // На малых радиусах box берется только явно, и несколько боксов там грубо приближают ядро
+            {"gaussian", {16, 32}, ReferenceGaussian,
+             {{"separable", 1, 0.5}, {"box", BOX_MAX_ERROR, BOX_MEAN_ERROR}, {"", BOX_MAX_ERROR, BOX_MEAN_ERROR}},
+             {"", 1, 0.5}},
+            {"median", {1, 2, 7}, ReferenceMedian,
+             {{"sort", 0, 0.0, sortWindowFits}, {"network", 0, 0.0}, {"tiled", 0, 0.0}, {"histogram", 0, 0.0}, {"radix", 0, 0.0}},
+             {"", 0, 0.0}},
+            {"motion", {3, 10, 25}, ReferenceMotion,
+             {{"running", 1, 0.5}, {"direct", 1, 0.5}},
+             {"", 1, 0.5}},
+            // Выборка по float-координатам на устройстве может сдвинуть отдельные сэмплы на пиксель
+            {"radial", {4, 12}, ReferenceRadial,
+             {{"buffer", NO_MAX_ERROR, 0.5}, {"image", NO_MAX_ERROR, 4.0}, {"polar", NO_MAX_ERROR, 8.0}},
+             {"", NO_MAX_ERROR, 0.5}},
+            {"gamma", {2, 3}, ReferenceGamma, {{"", 1, 0.5}}, {"", 1, 0.5}},
+    };
+    // Наклонное размытие: direct только горизонтальный, поэтому здесь лишь running
+    for (int angle : STRIP_CHECK_ANGLES) {
+        cases.push_back({"motion", {10, 25}, ReferenceAngledMotion(angle), {{"running", ANGLED_MAX, ANGLED_MEAN}},
+                         {"", ANGLED_MAX, ANGLED_MEAN}, {{"angle", std::to_string(angle)}}});
+    }
+    return cases;
+}
+
+std::string FormatOptions(const std::map<std::string, std::string>& options)
+{
+    std::string text;
+    for (const auto& [key, value] : options) text += (text.empty() ? "" : ":") + key + "=" + value;
+    return text;
+}
+
+void Compare(const Image& result, const Image& reference, const Variant& variant, Result& record)
+{
+    long long totalError = 0;
+    record.maxError = 0;
+    for (size_t i = 0; i < result.size(); ++i) {
+        int error = std::abs(static_cast<int>(result[i]) - static_cast<int>(reference[i]));
+        record.maxError = std::max(record.maxError, error);
+        totalError += error;
+    }
+    record.meanError = result.empty() ? 0.0 : static_cast<double>(totalError) / static_cast<double>(result.size());
+    record.passed = (variant.maxError == NO_MAX_ERROR || record.maxError <= variant.maxError) &&
+                    record.meanError <= variant.meanError;
+}
+
+// Лучшее время apply (ApplyFilter с передачами для OpenCL), первый запуск - прогрев
+Image RunTimed(const std::function<void(Image&)>& apply, const Image& input, int width, int height, double& megapixelsPerSecond)
+{
+    Image result;
+    double bestMs = std::numeric_limits<double>::infinity();
+    for (int run = 0; run <= TIMED_RUNS; ++run) {
+        result = input;
+        auto startTime = Clock::now();
+        apply(result);
+        if (run > 0) bestMs = std::min(bestMs, Milliseconds(Clock::now() - startTime).count());
+    }
+    megapixelsPerSecond = static_cast<double>(width) * height / bestMs / 1000.0;
+    return result;
+}
+
+std::string EscapeJson(const std::string& text)
+{
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+void WriteJson(const std::string& path, const std::vector<Result>& results)
+{
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Warning: cannot write verification JSON to " << path << std::endl;
+        return;
+    }
+    file << "{\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        file << "    {\"backend\": \"" << r.backend << "\", \"device\": \"" << EscapeJson(r.device)
+             << "\", \"filter\": \"" << r.filter << "\", \"algo\": \"" << r.algorithm << "\", \"options\": \"" << r.options
+             << "\", \"element\": \"" << r.element
+             << "\", \"param\": " << r.parameter
+             << ", \"width\": " << r.width << ", \"height\": " << r.height << ", \"channels\": " << r.channels;
+        if (!r.error.empty()) {
+            file << ", \"error\": \"" << EscapeJson(r.error) << "\", \"passed\": false";
+        } else if (r.skipReason.empty()) {
+            file << ", \"max_error\": " << r.maxError << ", \"mean_error\": " << r.meanError
+                 << ", \"passed\": " << (r.passed ? "true" : "false") << ", \"mpix_per_s\": " << r.megapixelsPerSecond;
+        } else {
+            file << ", \"skipped\": \"" << EscapeJson(r.skipReason) << "\"";
+        }
+        file << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+}
+
+void PrintResult(const Result& r)
+{
+    std::cout << "  " << std::left << std::setw(7) << r.backend << std::setw(9) << r.filter << std::setw(10)
+              << (r.algorithm.empty() ? "default" : r.algorithm) << std::setw(4) << r.element << std::right
+              << " p=" << std::setw(2) << r.parameter << (r.options.empty() ? "" : " " + r.options)
+              << " " << r.width << "x" << r.height << "x" << r.channels;
+    if (!r.skipReason.empty()) {
+        std::cout << "  skipped: " << r.skipReason << std::endl;
+        return;
+    }
+    if (!r.error.empty()) {
+        std::cout << "  FAIL: " << r.error << std::endl;
+        return;
+    }
+    std::cout << std::fixed << std::setprecision(3) << "  max " << r.maxError << " mean " << r.meanError
+              << std::setprecision(1) << "  " << r.megapixelsPerSecond << " MPix/s  " << (r.passed ? "OK" : "FAIL") << std::endl;
+}
+
+// Цепочка из одного motion под углом по полосам (FilterPipeline::ApplyInStrips) против того же
+// изображения целиком на текущем устройстве. Сетка линий в полосе считается от начала изображения;
+// допуск - только округление: скользящие суммы у краев полос накапливают другую ошибку float
+void CheckStripsAgainstWhole(const std::string& device, std::vector<Result>& results, int& failures)
+{
+    const ImageSize size = IMAGE_SIZES[1];
+    const Variant variant{"strips", 1, 0.01};
+    for (int channels : CHANNEL_COUNTS) {
+        const Image input = CreateTestImage(size.width, size.height, channels);
+        for (int angle : STRIP_CHECK_ANGLES) {
+            FilterSpec spec;
+            spec.name = "motion";
+            spec.parameter = STRIP_CHECK_LENGTH;
+            spec.argument = std::to_string(STRIP_CHECK_LENGTH);
+            spec.options["angle"] = std::to_string(angle);
+            Result record{"opencl", device, spec.name, variant.algorithm, "angle=" + std::to_string(angle),
+                          GetElementTypeName(ElementType::UCHAR), spec.parameter, size.width, size.height, channels,
+                          0, 0.0, false, 0.0, "", ""};
+            auto apply = [&](Image& image) {
+                std::vector<std::unique_ptr<OpenCLImageFilter>> filters;
+                filters.push_back(CreateImageFilter(spec));
+                FilterPipeline(std::move(filters)).Apply(image, size.width, size.height, channels);
+            };
+            try {
+                FilterPipeline::ConfigureStripRows(0); // Тестовое изображение помещается целиком
+                Image whole = input;
+                apply(whole);
+                FilterPipeline::ConfigureStripRows(STRIP_CHECK_ROWS);
+                Image strips = RunTimed(apply, input, size.width, size.height, record.megapixelsPerSecond);
+                FilterPipeline::ConfigureStripRows(0);
+                Compare(strips, whole, variant, record);
+                if (!record.passed) ++failures;
+            } catch (const std::exception& e) {
+                FilterPipeline::ConfigureStripRows(0);
+                record.error = e.what();
+                ++failures;
+            }
+            PrintResult(record);
+            results.push_back(record);
+        }
+    }
+}
+}
+
+PixelBuffer CreateTestImage(int width, int height, int channels)
+{
+    PixelBuffer image(static_cast<size_t>(width) * height * channels);
+    unsigned int state = 2024;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            for (int c = 0; c < channels; ++c) {
+                state = state * 1103515245u + 12345u;
+                int value = x * 255 / std::max(1, width - 1) + static_cast<int>((state >> 16) % 48);
+                if (((x / 16) + (y / 16) + c) % 3 == 0) value = 255 - value;
+                image[(static_cast<size_t>(y) * width + x) * channels + c] = static_cast<unsigned char>(std::clamp(value, 0, 255));
+            }
+        }
+    }
+    return image;
+}
+
+bool RunFilterVerification(const std::string& jsonPath, bool includeOpenCL)
+{
+    std::vector<OpenCLDeviceInfo> devices;
+    try {
+        if (includeOpenCL) devices = EnumerateOpenCLDevices();
+    } catch (const std::exception& e) {
+        std::cout << "OpenCL unavailable (" << e.what() << "), checking the CPU backend only." << std::endl;
+    }
+
+    std::vector<Result> results;
+    int failures = 0;
+    for (const FilterCase& filterCase : CreateFilterCases()) {
+        for (const ImageSize& size : IMAGE_SIZES) {
+            for (int channels : CHANNEL_COUNTS) {
+                const Image input = CreateTestImage(size.width, size.height, channels);
+                for (int parameter : filterCase.parameters) {
+                    const Image reference = filterCase.reference(input, size.width, size.height, channels, parameter);
+                    FilterSpec spec;
+                    spec.name = filterCase.name;
+                    spec.parameter = parameter;
+                    spec.argument = std::to_string(parameter);
+                    spec.options = filterCase.options;
+
+                    auto run = [&](const std::string& backend, const std::string& device, const Variant& variant,
+                                   ElementType elementType, const std::function<std::unique_ptr<IImageFilter>()>& create) {
+                        Result record{backend, device, filterCase.name, variant.algorithm, FormatOptions(filterCase.options),
+                                      GetElementTypeName(elementType), parameter, size.width, size.height, channels,
+                                      0, 0.0, false, 0.0, "", ""};
+                        if (variant.supports && !variant.supports(channels, elementType, parameter)) {
+                            record.skipReason = "outside the declared support of the variant";
+                            PrintResult(record);
+                            results.push_back(record);
+                            return;
+                        }
+                        try {
+                            std::unique_ptr<IImageFilter> filter = create();
+                            Image result;
+                            if (elementType == ElementType::UCHAR) {
+                                result = RunTimed([&](Image& image) { filter->ApplyFilter(image, size.width, size.height, channels); },
+                                                  input, size.width, size.height, record.megapixelsPerSecond);
+                            } else {
+                                // Широкие типы есть только у фильтров OpenCL
+                                auto& openclFilter = dynamic_cast<OpenCLImageFilter&>(*filter);
+                                Image wideResult = RunTimed([&](Image& image) {
+                                    openclFilter.ApplyFilter(image, size.width, size.height, channels, elementType);
+                                }, ConvertElements(input, ElementType::UCHAR, elementType), size.width, size.height,
+                                                            record.megapixelsPerSecond);
+                                result = ConvertElements(wideResult, elementType, ElementType::UCHAR);
+                            }
+                            Compare(result, reference, variant, record);
+                            if (!record.passed) ++failures;
+                        } catch (const std::exception& e) {
+                            record.error = e.what();
+                            ++failures;
+                        }
+                        PrintResult(record);
+                        results.push_back(record);
+                    };
+
+                    run("cpu", "host", filterCase.cpuVariant, ElementType::UCHAR, [&] { return CreateCpuImageFilter(spec); });
+                    for (const OpenCLDeviceInfo& device : devices) {
+                        DeviceSelectionPolicy policy;
+                        policy.mode = DeviceSelectionMode::INDEX;
+                        policy.index = device.index;
+                        OpenCLRuntime::Configure(policy);
+                        for (const Variant& variant : filterCase.openclVariants) {
+                            FilterSpec variantSpec = spec;
+                            if (!variant.algorithm.empty()) variantSpec.options["algo"] = variant.algorithm;
+                            run("opencl", device.deviceName, variant, ElementType::UCHAR,
+                                [&] { return CreateImageFilter(variantSpec); });
+                        }
+                        // Алгоритм по умолчанию на широких типах: вычисления во float дают то же, что и 8 бит,
+                        // до округления при обратном пересчете в 8 бит. Допуск - как у алгоритма по умолчанию на OpenCL,
+                        // если он проверяется отдельно (gaussian с большим радиусом - это box), иначе как у CPU
+                        Variant wideVariant = filterCase.cpuVariant;
+                        for (const Variant& variant : filterCase.openclVariants) {
+                            if (variant.algorithm.empty()) wideVariant = variant;
+                        }
+                        if (wideVariant.maxError != NO_MAX_ERROR) wideVariant.maxError += 1;
+                        wideVariant.meanError += 0.5;
+                        for (ElementType elementType : WIDE_ELEMENT_TYPES) {
+                            run("opencl", device.deviceName, wideVariant, elementType, [&] { return CreateImageFilter(spec); });
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    for (const OpenCLDeviceInfo& device : devices) {
+        DeviceSelectionPolicy policy;
+        policy.mode = DeviceSelectionMode::INDEX;
+        policy.index = device.index;
+        OpenCLRuntime::Configure(policy);
+        CheckStripsAgainstWhole(device.deviceName, results, failures);
+    }
+
+    WriteJson(jsonPath, results);
+    std::cout << "Verification: " << results.size() << " runs, " << failures << " failed. Results written to: "
+              << jsonPath << std::endl;
+    return failures == 0;
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include "HostMemory.h"
+#include <string>
+
+// Проверка фильтров (режим verify): синтетические изображения нескольких размеров и чисел каналов,
+// каждый фильтр на нескольких параметрах на CPU-бэкенде и на каждом устройстве OpenCL (все варианты
+// "algo"), сравнение с простой эталонной реализацией на хосте с допусками для каждого фильтра
+// и замер пропускной способности. Пропускаются только сочетания вне заявленной поддержки варианта,
+// исключение в остальных считается провалом. Результаты пишутся в JSON; true, если все проверки прошли.
+// includeOpenCL == false - только CPU-бэкенд (--backend cpu).
+bool RunFilterVerification(const std::string& jsonPath, bool includeOpenCL);
+
+// Синтетическое 8-битное изображение проверки и сравнения вариантов (bench): градиент, шум и резкие
+// границы, чтобы размытиям и медиане было что менять. Одно и то же для одинаковых размеров.
+PixelBuffer CreateTestImage(int width, int height, int channels);
@@ -3,16 +3,17 @@
 #include <cmath>
 #include <iostream>
 #include <algorithm> // For std::clamp, std::max
+#include <limits>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
 const std::string GaussianFilter::m_blurPassKernelSource = R"CLC(
-// Работает с uchar4, т.е. 4 канала на пиксель.
+// Собирается после m_pixelTypesSource: Pixel - вектор из CHANNELS значений типа Value по -DELEMENT.
 __kernel void BlurPass(
-    __global const uchar4* inputImage, // Ожидает данные в формате RGBA
-    __global uchar4* outputImage,
+    __global const Element* inputImage, // Каналы чередуются (RGBRGB...)
+    __global Element* outputImage,
     __constant float* filterKernel,
     const int kernelRadius,
     const int imageWidth, // Ширина текущего измерения (может быть height после transpose)
@@ -24,36 +25,191 @@ __kernel void BlurPass(
     int currentX = gid % imageWidth; // Координата вдоль размываемого направления
     int currentY = gid / imageWidth; // Координата перпендикулярная размываемому направлению
 
-    float4 sum = (float4)(0.0f, 0.0f, 0.0f, 0.0f);
+    PixelF sum = (PixelF)(0.0f);
 
     for (int offset = -kernelRadius; offset <= kernelRadius; ++offset)
     {
         int sampleCoord = clamp(currentX + offset, 0, imageWidth - 1);
-        uchar4 pixelColor = inputImage[currentY * imageWidth + sampleCoord];
+        Pixel pixelColor = LOAD_PIXEL(currentY * imageWidth + sampleCoord, inputImage);
 
-        float4 floatPixelColor = convert_float4(pixelColor);
+        PixelF floatPixelColor = TO_FLOAT(pixelColor);
 
         float weight = filterKernel[offset + kernelRadius];
         sum += floatPixelColor * weight;
     }
-    // sum.w = (float)inputImage[gid].s3; // Вариант: сохранить исходную альфу
-    outputImage[gid] = convert_uchar4_sat_rte(sum);
+    STORE_PIXEL(TO_PIXEL(sum), gid, outputImage);
 }
 )CLC";
 
 const std::string GaussianFilter::m_transposeKernelSource = R"CLC(
 __kernel void TransposeImage(
-    __global const uchar4* inputImage,
-    __global uchar4* outputImage,
+    __global const Element* inputImage,
+    __global Element* outputImage,
     const int imageWidth, // Оригинальная ширина
-    const int imageHeight) // Оригинальная высота
+    const int imageHeight, // Оригинальная высота
+    const int applyEpilogue) // Обратное транспонирование - последняя запись пути, с эпилогом
 {
     int currentX = get_global_id(0); // Становится новой Y координатой
     int currentY = get_global_id(1); // Становится новой X координатой
 
     if (currentX >= imageWidth || currentY >= imageHeight) return;
 
-    outputImage[currentX * imageHeight + currentY] = inputImage[currentY * imageWidth + currentX];
+    Pixel pixel = LOAD_PIXEL(currentY * imageWidth + currentX, inputImage);
+    if (applyEpilogue) pixel = EPILOGUE_PIXEL(pixel);
+    STORE_PIXEL(pixel, currentX * imageHeight + currentY, outputImage);
+}
+)CLC";
+
+const std::string GaussianFilter::m_columnKernelSource = R"CLC(
+// Вертикальный проход без транспонирования. Рабочая группа загружает в tile столбцы своего
+// блока вместе с полями по kernelRadius строк сверху и снизу; чтения строк из глобальной
+// памяти идут подряд, а каждый пиксель загружается один раз вместо 2r+1.
+// Третье измерение - номер плоскости для планарного RGB (плоскости лежат подряд).
+__kernel void BlurColumns(
+    __global const Element* inputImage,
+    __global Element* outputImage,
+    __constant float* filterKernel,
+    const int kernelRadius,
+    const int imageWidth,
+    const int imageHeight,
+    __local Pixel* tile) // (tileHeight + 2 * kernelRadius) x tileWidth
+{
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+    int planeOffset = get_global_id(2) * imageWidth * imageHeight;
+    int localX = get_local_id(0);
+    int localY = get_local_id(1);
+    int tileWidth = get_local_size(0);
+    int tileHeight = get_local_size(1);
+
+    int originY = get_group_id(1) * tileHeight - kernelRadius;
+    int columnX = min(x, imageWidth - 1); // Лишние элементы справа грузят крайний столбец
+    for (int row = localY; row < tileHeight + 2 * kernelRadius; row += tileHeight) {
+        int sampleY = clamp(originY + row, 0, imageHeight - 1);
+        tile[row * tileWidth + localX] = LOAD_PIXEL(planeOffset + sampleY * imageWidth + columnX, inputImage);
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    if (x >= imageWidth || y >= imageHeight) return;
+
+    PixelF sum = (PixelF)(0.0f);
+    for (int offset = 0; offset <= 2 * kernelRadius; ++offset) {
+        sum += TO_FLOAT(tile[(localY + offset) * tileWidth + localX]) * filterKernel[offset];
+    }
+    // EPILOGUE - поэлементные операции следующих фильтров цепочки (-DPOINT_OPS), без него sum как есть
+    STORE_PIXEL(TO_PIXEL(EPILOGUE(sum)), planeOffset + y * imageWidth + x, outputImage);
+}
+)CLC";
+
+const std::string GaussianFilter::m_planesKernelSource = R"CLC(
+// Перестановка RGBRGB... <-> RRR...GGG...BBB... для планарного пути 3-канальных изображений
+__kernel void SplitPlanes(__global const Element* inputImage, __global Element* outputPlanes, const int numPixels)
+{
+    int gid = get_global_id(0);
+    if (gid >= numPixels) return;
+    for (int channel = 0; channel < 3; ++channel) {
+        STORE_VALUE(LOAD_VALUE(3 * gid + channel, inputImage), channel * numPixels + gid, outputPlanes);
+    }
+}
+
+// Сборка - последняя запись планарного пути: в программе с CHANNELS=3 пиксель собирается целиком,
+// чтобы применить эпилог (EPILOGUE)
+__kernel void MergePlanes(__global const Element* inputPlanes, __global Element* outputImage, const int numPixels)
+{
+    int gid = get_global_id(0);
+    if (gid >= numPixels) return;
+#if CHANNELS == 3
+    PixelF pixel = (PixelF)(VALUE_TO_FLOAT(LOAD_VALUE(gid, inputPlanes)), VALUE_TO_FLOAT(LOAD_VALUE(numPixels + gid, inputPlanes)),
+                            VALUE_TO_FLOAT(LOAD_VALUE(2 * numPixels + gid, inputPlanes)));
+    STORE_PIXEL(TO_PIXEL(EPILOGUE(pixel)), gid, outputImage);
+#else
+    for (int channel = 0; channel < 3; ++channel) {
+        STORE_VALUE(LOAD_VALUE(channel * numPixels + gid, inputPlanes), 3 * gid + channel, outputImage);
+    }
+#endif
+}
+)CLC";
+
+const std::string GaussianFilter::m_boxKernelSource = R"CLC(
+// Один проход box-фильтра скользящей суммой: стоимость на пиксель не зависит от радиуса.
+// Рабочий элемент ведет одну линию (строку одного канала или столбец одного канала);
+// начало линии = offset + (line / lineGroup) * groupStride + line % lineGroup, шаг между элементами
+// elementStride - отдельно для входа и выхода: промежуточные float-буферы шире изображения на поля.
+// Края прижимаются один раз, к исходному изображению: проход пишет позиции [-outMargin, length + outMargin),
+// которые понадобятся следующим проходам, а читает вход в пределах его полей [-inMargin, length + inMargin).
+// Первый проход читает значения изображения (Element), промежуточные результаты хранятся во float,
+// последний проход - BoxColumnsToImage. LOAD(index, line) / STORE(value, index, line) - доступ к линии.
+#define BOX_PASS(NAME, IN_TYPE, OUT_TYPE, LOAD, STORE) \
+__kernel void NAME( \
+    __global const IN_TYPE* input, \
+    __global OUT_TYPE* output, \
+    const int boxRadius, \
+    const int length, \
+    const int inMargin, \
+    const int outMargin, \
+    const int lineGroup, \
+    const int lineCount, \
+    const int inOffset, \
+    const int inElementStride, \
+    const int inGroupStride, \
+    const int outOffset, \
+    const int outElementStride, \
+    const int outGroupStride) \
+{ \
+    int line = get_global_id(0); \
+    if (line >= lineCount) return; \
+    __global const IN_TYPE* in = input + inOffset + (line / lineGroup) * inGroupStride + line % lineGroup; \
+    __global OUT_TYPE* out = output + outOffset + (line / lineGroup) * outGroupStride + line % lineGroup; \
+    int low = -inMargin; \
+    int high = length - 1 + inMargin; \
+    float scale = 1.0f / (2 * boxRadius + 1); \
+    float sum = 0.0f; \
+    for (int k = -boxRadius; k <= boxRadius; ++k) sum += LOAD(clamp(k - outMargin, low, high) * inElementStride, in); \
+    for (int i = -outMargin; i < length + outMargin; ++i) { \
+        STORE(sum * scale, i * outElementStride, out); \
+        sum += LOAD(clamp(i + boxRadius + 1, low, high) * inElementStride, in) - \
+               LOAD(clamp(i - boxRadius, low, high) * inElementStride, in); \
+    } \
+}
+
+#define LOAD_FLOAT(index, line) ((line)[index])
+#define STORE_FLOAT(value, index, line) ((line)[index] = (value))
+#define LOAD_IMAGE(index, line) VALUE_TO_FLOAT(LOAD_VALUE(index, line))
+BOX_PASS(BoxPassFromImage, Element, float, LOAD_IMAGE, STORE_FLOAT)
+BOX_PASS(BoxPass, float, float, LOAD_FLOAT, STORE_FLOAT)
+
+#if CHANNELS == 1
+#define LOAD_FLOAT_PIXEL(index, line) ((line)[index])
+#else
+#define LOAD_FLOAT_PIXEL(index, line) PASTE(vload, CHANNELS)(0, (line) + (index))
+#endif
+
+// Последний проход по столбцам: рабочий элемент ведет все каналы столбца x, чтобы применить эпилог
+// (EPILOGUE) к пикселю целиком при записи в изображение. Вход - float-буфер с полями, как у BoxPass;
+// строки за [0, imageHeight) берутся из полей шириной inMargin
+__kernel void BoxColumnsToImage(
+    __global const float* input,
+    __global Element* output,
+    const int boxRadius,
+    const int imageWidth,
+    const int imageHeight,
+    const int inMargin,
+    const int inOffset,
+    const int inRowStride)
+{
+    int x = get_global_id(0);
+    if (x >= imageWidth) return;
+    __global const float* in = input + inOffset + x * CHANNELS;
+    int low = -inMargin;
+    int high = imageHeight - 1 + inMargin;
+    float scale = 1.0f / (2 * boxRadius + 1);
+    PixelF sum = (PixelF)(0.0f);
+    for (int k = -boxRadius; k <= boxRadius; ++k) sum += LOAD_FLOAT_PIXEL(clamp(k, low, high) * inRowStride, in);
+    for (int y = 0; y < imageHeight; ++y) {
+        STORE_PIXEL(TO_PIXEL(EPILOGUE(sum * scale)), y * imageWidth + x, output);
+        sum += LOAD_FLOAT_PIXEL(clamp(y + boxRadius + 1, low, high) * inRowStride, in) -
+               LOAD_FLOAT_PIXEL(clamp(y - boxRadius, low, high) * inRowStride, in);
+    }
 }
 )CLC";
 
@@ -61,9 +217,6 @@ __kernel void TransposeImage(
 GaussianFilter::GaussianFilter(int initialRadius)
         : m_effectRadius(initialRadius)
 {
-    InitializeOpenCl();
-    m_program = CreateProgramWithSource(m_context, m_deviceId, m_blurPassKernelSource + m_transposeKernelSource);
-    CreateKernels();
 }
 
 GaussianFilter::~GaussianFilter()
@@ -71,54 +224,78 @@ GaussianFilter::~GaussianFilter()
     ReleaseOpenCl();
 }
 
-void GaussianFilter::InitializeOpenCl()
+GaussianFilter::ChannelKernels GaussianFilter::GetKernels(int channels, ElementType elementType, bool fuseEpilogue)
 {
-    cl_int err;
-    cl_uint numPlatforms;
-    err = clGetPlatformIDs(1, nullptr, &numPlatforms); // Проверяем, есть ли хотя бы одна
-    if (numPlatforms == 0) clGetPlatformIDs(0, nullptr, &numPlatforms); // Если нет, получаем точное число
-    CheckCLError(err, "clGetPlatformIDs (count)");
-    if (numPlatforms == 0) throw std::runtime_error("GaussianFilter: No OpenCL platforms found.");
-
-    std::vector<cl_platform_id> platforms(numPlatforms);
-    err = clGetPlatformIDs(numPlatforms, platforms.data(), nullptr);
-    CheckCLError(err, "clGetPlatformIDs (list)");
-
-    cl_platform_id platform = platforms[0];
-    err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_GPU, 1, &m_deviceId, nullptr);
-    if (err == CL_DEVICE_NOT_FOUND) {
-        err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_CPU, 1, &m_deviceId, nullptr);
-        CheckCLError(err, "clGetDeviceIDs (CPU)");
-    } else {
-        CheckCLError(err, "clGetDeviceIDs (GPU)");
+    // Программа собирается под число каналов и тип значения при первом изображении с ними;
+    // сами ядра кэширует OpenCLImageFilter::GetKernel
+    std::string programSource = m_blurPassKernelSource + m_transposeKernelSource + m_columnKernelSource +
+                                m_planesKernelSource + m_boxKernelSource;
+    std::string buildOptions = PixelBuildOptions(channels, elementType);
+    if (fuseEpilogue) {
+        programSource = GetEpilogueSource() + programSource;
+        buildOptions += GetEpilogueBuildOptions(channels);
     }
+    ChannelKernels kernels;
+    kernels.blurPass = GetKernel(programSource, "BlurPass", buildOptions);
+    kernels.transpose = GetKernel(programSource, "TransposeImage", buildOptions);
+    kernels.columns = GetKernel(programSource, "BlurColumns", buildOptions);
+    kernels.splitPlanes = GetKernel(programSource, "SplitPlanes", buildOptions);
+    kernels.mergePlanes = GetKernel(programSource, "MergePlanes", buildOptions);
+    kernels.boxFromImage = GetKernel(programSource, "BoxPassFromImage", buildOptions);
+    kernels.box = GetKernel(programSource, "BoxPass", buildOptions);
+    kernels.boxColumnsToImage = GetKernel(programSource, "BoxColumnsToImage", buildOptions);
+    return kernels;
+}
 
-    m_context = clCreateContext(nullptr, 1, &m_deviceId, nullptr, nullptr, &err);
-    CheckCLError(err, "clCreateContext");
-
-#if defined(CL_VERSION_2_0)
-    m_commandQueue = clCreateCommandQueueWithProperties(m_context, m_deviceId, nullptr, &err);
-#else
-    m_commandQueue = clCreateCommandQueue(m_context, m_deviceId, 0, &err);
-#endif
-    CheckCLError(err, "clCreateCommandQueue");
+void GaussianFilter::ReleaseOpenCl()
+{
+    if (m_weightsBuffer) clReleaseMemObject(m_weightsBuffer);
 }
 
-void GaussianFilter::CreateKernels() {
+cl_mem GaussianFilter::GetWeightsBuffer()
+{
+    // Веса зависят только от радиуса, поэтому пересоздаем буфер лишь при его смене
+    if (m_weightsBuffer && m_weightsRadius == m_effectRadius) return m_weightsBuffer;
+    if (m_weightsBuffer) clReleaseMemObject(m_weightsBuffer);
+    m_weightsBuffer = nullptr;
+
+    std::vector<float> gaussianKernelVec = CreateGaussianKernelValues(m_effectRadius, SigmaForRadius(m_effectRadius));
+    size_t kernelSizeBytes = gaussianKernelVec.size() * sizeof(float);
+
     cl_int err;
-    m_blurPassKernel = clCreateKernel(m_program, "BlurPass", &err);
-    CheckCLError(err, "clCreateKernel (BlurPass)");
-    m_transposeKernel = clCreateKernel(m_program, "TransposeImage", &err);
-    CheckCLError(err, "clCreateKernel (TransposeImage)");
+    m_weightsBuffer = clCreateBuffer(m_runtime->GetContext(), CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                     kernelSizeBytes, gaussianKernelVec.data(), &err);
+    CheckCLError(err, "clCreateBuffer (kernelCLBuffer)");
+    m_weightsRadius = m_effectRadius;
+    return m_weightsBuffer;
 }
 
-void GaussianFilter::ReleaseOpenCl()
+float GaussianFilter::SigmaForRadius(int radius)
+{
+    return std::max(1.0f, static_cast<float>(radius) / 2.0f);
+}
+
+std::vector<int> GaussianFilter::CreateBoxRadii(const std::vector<float>& weights, int passes)
 {
-    if (m_blurPassKernel) clReleaseKernel(m_blurPassKernel);
-    if (m_transposeKernel) clReleaseKernel(m_transposeKernel);
-    if (m_program) clReleaseProgram(m_program);
-    if (m_commandQueue) clReleaseCommandQueue(m_commandQueue);
-    if (m_context) clReleaseContext(m_context);
+    // Ширины box-фильтров подбираются так, чтобы дисперсия их свертки совпала с дисперсией
+    // точного (обрезанного на радиусе) ядра: n боксов шириной wl и wu = wl + 2 (Kovesi).
+    int radius = static_cast<int>(weights.size() / 2);
+    float variance = 0.0f;
+    for (int i = -radius; i <= radius; ++i) variance += weights[i + radius] * static_cast<float>(i * i);
+
+    float idealWidth = std::sqrt(12.0f * variance / static_cast<float>(passes) + 1.0f);
+    int lowerWidth = static_cast<int>(std::floor(idealWidth));
+    if (lowerWidth % 2 == 0) --lowerWidth;
+    float lowerCount = (12.0f * variance - static_cast<float>(passes * lowerWidth * lowerWidth + 4 * passes * lowerWidth + 3 * passes))
+                       / static_cast<float>(-4 * lowerWidth - 4);
+    int lowerPasses = static_cast<int>(std::lround(lowerCount));
+
+    std::vector<int> radii;
+    for (int i = 0; i < passes; ++i) {
+        int width = i < lowerPasses ? lowerWidth : lowerWidth + 2;
+        radii.push_back(std::max(0, (width - 1) / 2));
+    }
+    return radii;
 }
 
 std::vector<float> GaussianFilter::CreateGaussianKernelValues(int radius, float sigma)
@@ -140,95 +317,364 @@ std::vector<float> GaussianFilter::CreateGaussianKernelValues(int radius, float
     return kernel;
 }
 
-void GaussianFilter::ApplyFilter(std::vector<unsigned char>& imageData, int width, int height, int channels)
+void GaussianFilter::EnqueueOnDevice(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                                     ElementType elementType)
 {
-    if (m_effectRadius == 0) return;
-    // Фильтр ожидает 4 канала (uchar4). Если на входе 3, нужно преобразовать.
-    // Для простоты, сейчас будем предполагать, что channels == 4.
-    if (channels != 4) {
-        std::cerr << "GaussianFilter current implementation expects 4 channels (RGBA)." << std::endl;
-        // Можно добавить конвертацию RGB -> RGBA здесь или выбросить исключение
-        // Например, создать новый std::vector<unsigned char> с 4 каналами.
-        // Пока просто выйдем.
+    if (m_effectRadius == 0) {
+        EnqueueEpilogue(queue, input, output, width, height, channels, elementType);
         return;
     }
+    if (channels < 1 || channels > 4) {
+        throw std::runtime_error("GaussianFilter supports 1-4 channels, got " + std::to_string(channels));
+    }
 
+    // Эпилог слит с последней записью каждого пути: BlurColumns, обратное транспонирование,
+    // MergePlanes и BoxColumnsToImage
+    if (UsesStackedBoxes()) {
+        EnqueueStackedBoxes(queue, input, output, width, height, channels, elementType);
+    } else if (m_algorithm == GaussianAlgorithm::TRANSPOSE || !FitsColumnTile(channels, elementType)) {
+        EnqueueTransposed(queue, input, output, width, height, channels, elementType);
+    } else if (m_algorithm == GaussianAlgorithm::PLANAR && channels == 3) {
+        EnqueuePlanar(queue, input, output, width, height, elementType);
+    } else {
+        EnqueueRowsAndColumns(queue, GetKernels(channels, elementType, HasEpilogue()), input, output, width, height, 1,
+                              channels, elementType);
+    }
+}
+
+void GaussianFilter::EnqueueRowsAndColumns(cl_command_queue queue, const ChannelKernels& kernels, cl_mem input, cl_mem output,
+                                           int width, int height, int planes, int channels, ElementType elementType)
+{
     cl_int err;
-    size_t numPixels = static_cast<size_t>(width) * height;
-    size_t imageSizeBytes = numPixels * channels * sizeof(unsigned char); // channels здесь всегда 4
+    size_t numPixels = static_cast<size_t>(width) * height * planes;
+    size_t imageSizeBytes = numPixels * channels * GetElementSize(elementType);
+
+    // Два прохода вместо четырех: строки input -> tempBuffer, столбцы tempBuffer -> output.
+    // Плоскости лежат подряд, поэтому для строк это просто изображение высотой height * planes.
+    PooledBuffer tempBuffer(m_runtime->GetBufferPool(), imageSizeBytes);
+    cl_mem kernelCLBuffer = GetWeightsBuffer();
+    int stackedHeight = height * planes;
+
+    err = clSetKernelArg(kernels.blurPass, 0, sizeof(cl_mem), &input);             CheckCLError(err, "SetArg Blur 0");
+    err = clSetKernelArg(kernels.blurPass, 1, sizeof(cl_mem), tempBuffer.GetPtr()); CheckCLError(err, "SetArg Blur 1");
+    err = clSetKernelArg(kernels.blurPass, 2, sizeof(cl_mem), &kernelCLBuffer);     CheckCLError(err, "SetArg Blur 2");
+    err = clSetKernelArg(kernels.blurPass, 3, sizeof(int), &m_effectRadius);        CheckCLError(err, "SetArg Blur 3");
+    err = clSetKernelArg(kernels.blurPass, 4, sizeof(int), &width);                 CheckCLError(err, "SetArg Blur 4");
+    err = clSetKernelArg(kernels.blurPass, 5, sizeof(int), &stackedHeight);         CheckCLError(err, "SetArg Blur 5");
+
+    size_t globalWorkSizeRows[1] = { numPixels };
+    err = m_runtime->EnqueueTunedKernel(queue, kernels.blurPass, 1, globalWorkSizeRows,
+                                        m_runtime->GetProfiler().Track("Gaussian BlurPass H", ProfileCategory::COMPUTE));
+    CheckCLError(err, "EnqueueNDRangeKernel (BlurPass Horizontal)");
 
-    float sigma = std::max(1.0f, static_cast<float>(m_effectRadius) / 2.0f);
-    std::vector<float> gaussianKernelVec = CreateGaussianKernelValues(m_effectRadius, sigma);
-    size_t kernelSizeBytes = gaussianKernelVec.size() * sizeof(float);
+    const size_t tileWidth = COLUMN_TILE_WIDTH;
+    const size_t tileHeight = GetColumnTileHeight();
+    size_t localTileBytes = (tileHeight + 2 * m_effectRadius) * tileWidth * PixelStorageBytes(channels, elementType);
+    err = clSetKernelArg(kernels.columns, 0, sizeof(cl_mem), tempBuffer.GetPtr()); CheckCLError(err, "SetArg Columns 0");
+    err = clSetKernelArg(kernels.columns, 1, sizeof(cl_mem), &output);             CheckCLError(err, "SetArg Columns 1");
+    err = clSetKernelArg(kernels.columns, 2, sizeof(cl_mem), &kernelCLBuffer);     CheckCLError(err, "SetArg Columns 2");
+    err = clSetKernelArg(kernels.columns, 3, sizeof(int), &m_effectRadius);        CheckCLError(err, "SetArg Columns 3");
+    err = clSetKernelArg(kernels.columns, 4, sizeof(int), &width);                 CheckCLError(err, "SetArg Columns 4");
+    err = clSetKernelArg(kernels.columns, 5, sizeof(int), &height);                CheckCLError(err, "SetArg Columns 5");
+    err = clSetKernelArg(kernels.columns, 6, localTileBytes, nullptr);             CheckCLError(err, "SetArg Columns 6");
+
+    size_t localWorkSize[3] = {tileWidth, tileHeight, 1};
+    size_t globalWorkSize[3] = {
+            (static_cast<size_t>(width) + tileWidth - 1) / tileWidth * tileWidth,
+            (static_cast<size_t>(height) + tileHeight - 1) / tileHeight * tileHeight,
+            static_cast<size_t>(planes)
+    };
+    err = clEnqueueNDRangeKernel(queue, kernels.columns, 3, nullptr, globalWorkSize, localWorkSize, 0, nullptr,
+                                 m_runtime->GetProfiler().Track("Gaussian BlurColumns", ProfileCategory::COMPUTE));
+    CheckCLError(err, "EnqueueNDRangeKernel (BlurColumns)");
+    tempBuffer.ResetAfter(queue);
+}
 
-    cl_mem inputOutputBuffer = clCreateBuffer(m_context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
-                                              imageSizeBytes, imageData.data(), &err);
-    CheckCLError(err, "clCreateBuffer (inputOutputBuffer)");
-    cl_mem tempBuffer = clCreateBuffer(m_context, CL_MEM_READ_WRITE, imageSizeBytes, nullptr, &err);
-    CheckCLError(err, "clCreateBuffer (tempBuffer)");
-    cl_mem kernelCLBuffer = clCreateBuffer(m_context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
-                                           kernelSizeBytes, gaussianKernelVec.data(), &err);
-    CheckCLError(err, "clCreateBuffer (kernelCLBuffer)");
+void GaussianFilter::EnqueuePlanar(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height,
+                                   ElementType elementType)
+{
+    // RGB раскладывается на три плоскости, каждая размывается одноканальными ядрами
+    // (выровненные поэлементные чтения вместо vload3), затем каналы собираются обратно - ядром
+    // из программы с CHANNELS=3, которое применяет эпилог к собранному пикселю
+    const ChannelKernels planeKernels = GetKernels(1, elementType);
+    cl_kernel mergePlanes = GetKernels(3, elementType, HasEpilogue()).mergePlanes;
+    cl_int err;
+    int numPixels = width * height;
+    size_t imageSizeBytes = static_cast<size_t>(numPixels) * 3 * GetElementSize(elementType);
+    PooledBuffer planesBuffer(m_runtime->GetBufferPool(), imageSizeBytes);
+    PooledBuffer blurredPlanesBuffer(m_runtime->GetBufferPool(), imageSizeBytes);
+    size_t globalWorkSize[1] = {static_cast<size_t>(numPixels)};
+
+    err = clSetKernelArg(planeKernels.splitPlanes, 0, sizeof(cl_mem), &input);               CheckCLError(err, "SetArg Split 0");
+    err = clSetKernelArg(planeKernels.splitPlanes, 1, sizeof(cl_mem), planesBuffer.GetPtr()); CheckCLError(err, "SetArg Split 1");
+    err = clSetKernelArg(planeKernels.splitPlanes, 2, sizeof(int), &numPixels);              CheckCLError(err, "SetArg Split 2");
+    err = m_runtime->EnqueueTunedKernel(queue, planeKernels.splitPlanes, 1, globalWorkSize,
+                                        m_runtime->GetProfiler().Track("Gaussian SplitPlanes", ProfileCategory::COMPUTE));
+    CheckCLError(err, "EnqueueNDRangeKernel (SplitPlanes)");
+
+    EnqueueRowsAndColumns(queue, planeKernels, planesBuffer.Get(), blurredPlanesBuffer.Get(), width, height, 3, 1, elementType);
+
+    err = clSetKernelArg(mergePlanes, 0, sizeof(cl_mem), blurredPlanesBuffer.GetPtr()); CheckCLError(err, "SetArg Merge 0");
+    err = clSetKernelArg(mergePlanes, 1, sizeof(cl_mem), &output);                      CheckCLError(err, "SetArg Merge 1");
+    err = clSetKernelArg(mergePlanes, 2, sizeof(int), &numPixels);                      CheckCLError(err, "SetArg Merge 2");
+    err = m_runtime->EnqueueTunedKernel(queue, mergePlanes, 1, globalWorkSize,
+                                        m_runtime->GetProfiler().Track("Gaussian MergePlanes", ProfileCategory::COMPUTE));
+    CheckCLError(err, "EnqueueNDRangeKernel (MergePlanes)");
+    planesBuffer.ResetAfter(queue);
+    blurredPlanesBuffer.ResetAfter(queue);
+}
+
+bool GaussianFilter::UsesStackedBoxes() const
+{
+    return m_algorithm == GaussianAlgorithm::BOX ||
+           (m_algorithm == GaussianAlgorithm::AUTO && m_boxRadiusThreshold > 0 && m_effectRadius >= m_boxRadiusThreshold);
+}
+
+size_t GaussianFilter::GetScratchBytes(int width, int rows, int channels, ElementType elementType) const
+{
+    if (IsIdentity()) return 0;
+    // Худший из алгоритмов: planar держит две плоскости и промежуточный буфер, box - два float-буфера с полями
+    size_t numValues = static_cast<size_t>(width) * rows * channels;
+    int margin = UsesStackedBoxes() ? GetBoxSupport() : 0;
+    size_t paddedValues = static_cast<size_t>(width + 2 * margin) * (rows + 2 * margin) * channels;
+    return std::max(3 * numValues * GetElementSize(elementType), 2 * paddedValues * sizeof(float));
+}
+
+int GaussianFilter::GetBoxSupport() const
+{
+    std::vector<int> radii = CreateBoxRadii(CreateGaussianKernelValues(m_effectRadius, SigmaForRadius(m_effectRadius)), BOX_PASSES);
+    int support = 0;
+    for (int radius : radii) support += radius;
+    return support;
+}
+
+int GaussianFilter::GetHaloRows() const
+{
+    if (!UsesStackedBoxes()) return m_effectRadius;
+    // Носитель свертки боксов может быть чуть шире точного ядра
+    return std::max(GetBoxSupport(), m_effectRadius);
+}
+
+void GaussianFilter::EnqueueStackedBoxes(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                                         ElementType elementType)
+{
+    const ChannelKernels kernels = GetKernels(channels, elementType, HasEpilogue());
+    if (m_boxRadiiForRadius != m_effectRadius) {
+        m_boxRadii = CreateBoxRadii(CreateGaussianKernelValues(m_effectRadius, SigmaForRadius(m_effectRadius)), BOX_PASSES);
+        m_boxRadiiForRadius = m_effectRadius;
+    }
 
-    // --- Горизонтальный проход ---
-    err = clSetKernelArg(m_blurPassKernel, 0, sizeof(cl_mem), &inputOutputBuffer); CheckCLError(err, "SetArg Blur 0");
-    err = clSetKernelArg(m_blurPassKernel, 1, sizeof(cl_mem), &tempBuffer);        CheckCLError(err, "SetArg Blur 1");
-    err = clSetKernelArg(m_blurPassKernel, 2, sizeof(cl_mem), &kernelCLBuffer);    CheckCLError(err, "SetArg Blur 2");
-    err = clSetKernelArg(m_blurPassKernel, 3, sizeof(int), &m_effectRadius);       CheckCLError(err, "SetArg Blur 3");
-    err = clSetKernelArg(m_blurPassKernel, 4, sizeof(int), &width);                CheckCLError(err, "SetArg Blur 4");
-    err = clSetKernelArg(m_blurPassKernel, 5, sizeof(int), &height);               CheckCLError(err, "SetArg Blur 5");
+    // Строки: input -> floatA -> floatB -> floatA, столбцы: floatA -> floatB -> floatA -> output.
+    // Float-буферы шире изображения на support с каждой стороны: проход j досчитывает поля шириной
+    // в сумму радиусов следующих проходов, поэтому у края результат совпадает со сверткой боксов
+    // изображения, продолженного краевыми пикселями, как у точного ядра
+    int support = 0;
+    for (int radius : m_boxRadii) support += radius;
+    const int paddedWidth = width + 2 * support;
+    const size_t paddedValues = static_cast<size_t>(paddedWidth) * (height + 2 * support) * channels;
+    if (paddedValues > static_cast<size_t>(std::numeric_limits<int>::max()))
+        throw std::runtime_error("Gaussian box: padded buffer exceeds 32-bit indexing, use smaller strips");
+    PooledBuffer floatBufferA(m_runtime->GetBufferPool(), paddedValues * sizeof(float));
+    PooledBuffer floatBufferB(m_runtime->GetBufferPool(), paddedValues * sizeof(float));
+    const int rowStride = width * channels;
+    const int paddedRowStride = paddedWidth * channels;
+    const int paddedOrigin = (support * paddedWidth + support) * channels;
+
+    std::vector<int> margins(BOX_PASSES, 0); // Поля, которые пишет проход: сумма радиусов следующих
+    for (int pass = BOX_PASSES - 2; pass >= 0; --pass) margins[pass] = margins[pass + 1] + m_boxRadii[pass + 1];
+
+    struct BoxPassParams
+    {
+        cl_kernel kernel;
+        cl_mem input;
+        cl_mem output;
+        int boxRadius;
+        int length;
+        int inMargin;
+        int outMargin;
+        int lineGroup;
+        int lineCount;
+        int inOffset;
+        int inElementStride;
+        int inGroupStride;
+        int outOffset;
+        int outElementStride;
+        int outGroupStride;
+        const char* profileName;
+    };
+    std::vector<BoxPassParams> passes;
+    for (int pass = 0; pass < BOX_PASSES; ++pass) {
+        // Линия строк - один канал одной строки: lineGroup = channels
+        bool first = pass == 0;
+        passes.push_back({first ? kernels.boxFromImage : kernels.box,
+                          first ? input : (pass % 2 == 1 ? floatBufferA.Get() : floatBufferB.Get()),
+                          pass % 2 == 0 ? floatBufferA.Get() : floatBufferB.Get(),
+                          m_boxRadii[pass], width, first ? 0 : margins[pass - 1], margins[pass], channels, height * channels,
+                          first ? 0 : paddedOrigin, channels, first ? rowStride : paddedRowStride,
+                          paddedOrigin, channels, paddedRowStride, "Gaussian BoxPass H"});
+    }
+    for (int pass = 0; pass < BOX_PASSES - 1; ++pass) {
+        // Линия столбцов - один канал одного столбца; соседние элементы читают соседние значения.
+        // Строки посчитаны только в [0, height): первый проход по столбцам прижимает к ним
+        bool first = pass == 0;
+        cl_mem passInput = passes.back().output;
+        cl_mem passOutput = passInput == floatBufferA.Get() ? floatBufferB.Get() : floatBufferA.Get();
+        passes.push_back({kernels.box, passInput, passOutput,
+                          m_boxRadii[pass], height, first ? 0 : margins[pass - 1], margins[pass], rowStride, rowStride,
+                          paddedOrigin, paddedRowStride, 0, paddedOrigin, paddedRowStride, 0, "Gaussian BoxPass V"});
+    }
+
+    cl_int err;
+    for (const BoxPassParams& pass : passes) {
+        err = clSetKernelArg(pass.kernel, 0, sizeof(cl_mem), &pass.input);             CheckCLError(err, "SetArg Box 0");
+        err = clSetKernelArg(pass.kernel, 1, sizeof(cl_mem), &pass.output);            CheckCLError(err, "SetArg Box 1");
+        err = clSetKernelArg(pass.kernel, 2, sizeof(int), &pass.boxRadius);            CheckCLError(err, "SetArg Box 2");
+        err = clSetKernelArg(pass.kernel, 3, sizeof(int), &pass.length);               CheckCLError(err, "SetArg Box 3");
+        err = clSetKernelArg(pass.kernel, 4, sizeof(int), &pass.inMargin);             CheckCLError(err, "SetArg Box 4");
+        err = clSetKernelArg(pass.kernel, 5, sizeof(int), &pass.outMargin);            CheckCLError(err, "SetArg Box 5");
+        err = clSetKernelArg(pass.kernel, 6, sizeof(int), &pass.lineGroup);            CheckCLError(err, "SetArg Box 6");
+        err = clSetKernelArg(pass.kernel, 7, sizeof(int), &pass.lineCount);            CheckCLError(err, "SetArg Box 7");
+        err = clSetKernelArg(pass.kernel, 8, sizeof(int), &pass.inOffset);             CheckCLError(err, "SetArg Box 8");
+        err = clSetKernelArg(pass.kernel, 9, sizeof(int), &pass.inElementStride);      CheckCLError(err, "SetArg Box 9");
+        err = clSetKernelArg(pass.kernel, 10, sizeof(int), &pass.inGroupStride);       CheckCLError(err, "SetArg Box 10");
+        err = clSetKernelArg(pass.kernel, 11, sizeof(int), &pass.outOffset);           CheckCLError(err, "SetArg Box 11");
+        err = clSetKernelArg(pass.kernel, 12, sizeof(int), &pass.outElementStride);    CheckCLError(err, "SetArg Box 12");
+        err = clSetKernelArg(pass.kernel, 13, sizeof(int), &pass.outGroupStride);      CheckCLError(err, "SetArg Box 13");
+
+        size_t globalWorkSize[1] = {static_cast<size_t>(pass.lineCount)};
+        err = m_runtime->EnqueueTunedKernel(queue, pass.kernel, 1, globalWorkSize,
+                                            m_runtime->GetProfiler().Track(pass.profileName, ProfileCategory::COMPUTE));
+        CheckCLError(err, "EnqueueNDRangeKernel (BoxPass)");
+    }
+
+    // Последний проход по столбцам пишет изображение: элемент на столбец, все каналы пикселя
+    cl_kernel lastKernel = kernels.boxColumnsToImage;
+    cl_mem lastInput = passes.back().output;
+    const int lastRadius = m_boxRadii[BOX_PASSES - 1];
+    const int lastMargin = margins[BOX_PASSES - 2];
+    err = clSetKernelArg(lastKernel, 0, sizeof(cl_mem), &lastInput);        CheckCLError(err, "SetArg BoxColumns 0");
+    err = clSetKernelArg(lastKernel, 1, sizeof(cl_mem), &output);           CheckCLError(err, "SetArg BoxColumns 1");
+    err = clSetKernelArg(lastKernel, 2, sizeof(int), &lastRadius);          CheckCLError(err, "SetArg BoxColumns 2");
+    err = clSetKernelArg(lastKernel, 3, sizeof(int), &width);               CheckCLError(err, "SetArg BoxColumns 3");
+    err = clSetKernelArg(lastKernel, 4, sizeof(int), &height);              CheckCLError(err, "SetArg BoxColumns 4");
+    err = clSetKernelArg(lastKernel, 5, sizeof(int), &lastMargin);          CheckCLError(err, "SetArg BoxColumns 5");
+    err = clSetKernelArg(lastKernel, 6, sizeof(int), &paddedOrigin);        CheckCLError(err, "SetArg BoxColumns 6");
+    err = clSetKernelArg(lastKernel, 7, sizeof(int), &paddedRowStride);     CheckCLError(err, "SetArg BoxColumns 7");
+    size_t columnsWorkSize[1] = {static_cast<size_t>(width)};
+    err = m_runtime->EnqueueTunedKernel(queue, lastKernel, 1, columnsWorkSize,
+                                        m_runtime->GetProfiler().Track("Gaussian BoxColumnsToImage", ProfileCategory::COMPUTE));
+    CheckCLError(err, "EnqueueNDRangeKernel (BoxColumnsToImage)");
+    floatBufferA.ResetAfter(queue);
+    floatBufferB.ResetAfter(queue);
+}
+
+size_t GaussianFilter::GetColumnTileHeight() const
+{
+    // 16x16 почти везде; на устройствах с маленькой рабочей группой блок ниже
+    size_t maxWorkGroupSize = m_runtime->GetDeviceInfo().maxWorkGroupSize;
+    return std::clamp<size_t>(maxWorkGroupSize / COLUMN_TILE_WIDTH, 1, 16);
+}
+
+bool GaussianFilter::FitsColumnTile(int channels, ElementType elementType) const
+{
+    size_t localTileBytes = (GetColumnTileHeight() + 2 * m_effectRadius) * COLUMN_TILE_WIDTH *
+                            PixelStorageBytes(channels, elementType);
+    return localTileBytes <= m_runtime->GetDeviceInfo().localMemBytes;
+}
+
+void GaussianFilter::EnqueueTransposed(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                                       ElementType elementType)
+{
+    // Исходная схема: одно ядро BlurPass для строк, столбцы - через два транспонирования
+    const ChannelKernels kernels = GetKernels(channels, elementType, HasEpilogue());
+    cl_kernel blurPassKernel = kernels.blurPass;
+    cl_kernel transposeKernel = kernels.transpose;
+    cl_int err;
+    size_t numPixels = static_cast<size_t>(width) * height;
+    size_t imageSizeBytes = numPixels * channels * GetElementSize(elementType);
+
+    // Промежуточный буфер; input только читается, все проходы идут через tempBuffer и output
+    PooledBuffer tempBuffer(m_runtime->GetBufferPool(), imageSizeBytes);
+    cl_mem kernelCLBuffer = GetWeightsBuffer();
+
+    // --- Горизонтальный проход (input -> tempBuffer) ---
+    err = clSetKernelArg(blurPassKernel, 0, sizeof(cl_mem), &input);             CheckCLError(err, "SetArg Blur 0");
+    err = clSetKernelArg(blurPassKernel, 1, sizeof(cl_mem), tempBuffer.GetPtr()); CheckCLError(err, "SetArg Blur 1");
+    err = clSetKernelArg(blurPassKernel, 2, sizeof(cl_mem), &kernelCLBuffer);     CheckCLError(err, "SetArg Blur 2");
+    err = clSetKernelArg(blurPassKernel, 3, sizeof(int), &m_effectRadius);        CheckCLError(err, "SetArg Blur 3");
+    err = clSetKernelArg(blurPassKernel, 4, sizeof(int), &width);                 CheckCLError(err, "SetArg Blur 4");
+    err = clSetKernelArg(blurPassKernel, 5, sizeof(int), &height);                CheckCLError(err, "SetArg Blur 5");
 
     size_t globalWorkSizePass1[1] = { numPixels }; // Одномерное ядро
-    err = clEnqueueNDRangeKernel(m_commandQueue, m_blurPassKernel, 1, nullptr, globalWorkSizePass1, nullptr, 0, nullptr, nullptr);
+    err = m_runtime->EnqueueTunedKernel(queue, blurPassKernel, 1, globalWorkSizePass1,
+                                        m_runtime->GetProfiler().Track("Gaussian BlurPass H", ProfileCategory::COMPUTE));
     CheckCLError(err, "EnqueueNDRangeKernel (BlurPass Horizontal)");
 
-    // --- Транспонирование 1 (tempBuffer -> inputOutputBuffer) ---
-    err = clSetKernelArg(m_transposeKernel, 0, sizeof(cl_mem), &tempBuffer);         CheckCLError(err, "SetArg Transpose1 0");
-    err = clSetKernelArg(m_transposeKernel, 1, sizeof(cl_mem), &inputOutputBuffer);  CheckCLError(err, "SetArg Transpose1 1");
-    err = clSetKernelArg(m_transposeKernel, 2, sizeof(int), &width);                 CheckCLError(err, "SetArg Transpose1 2");
-    err = clSetKernelArg(m_transposeKernel, 3, sizeof(int), &height);                CheckCLError(err, "SetArg Transpose1 3");
+    // --- Транспонирование 1 (tempBuffer -> output) ---
+    err = clSetKernelArg(transposeKernel, 0, sizeof(cl_mem), tempBuffer.GetPtr()); CheckCLError(err, "SetArg Transpose1 0");
+    err = clSetKernelArg(transposeKernel, 1, sizeof(cl_mem), &output);             CheckCLError(err, "SetArg Transpose1 1");
+    err = clSetKernelArg(transposeKernel, 2, sizeof(int), &width);                 CheckCLError(err, "SetArg Transpose1 2");
+    err = clSetKernelArg(transposeKernel, 3, sizeof(int), &height);                CheckCLError(err, "SetArg Transpose1 3");
+    const int noEpilogue = 0;
+    err = clSetKernelArg(transposeKernel, 4, sizeof(int), &noEpilogue);            CheckCLError(err, "SetArg Transpose1 4");
 
     size_t globalWorkSizeTranspose[2] = {static_cast<size_t>(width), static_cast<size_t>(height)};
-    err = clEnqueueNDRangeKernel(m_commandQueue, m_transposeKernel, 2, nullptr, globalWorkSizeTranspose, nullptr, 0, nullptr, nullptr);
+    err = m_runtime->EnqueueTunedKernel(queue, transposeKernel, 2, globalWorkSizeTranspose,
+                                        m_runtime->GetProfiler().Track("Gaussian TransposeImage", ProfileCategory::COMPUTE));
     CheckCLError(err, "EnqueueNDRangeKernel (Transpose1)");
 
-    // --- Вертикальный проход (на транспонированном изображении, inputOutputBuffer -> tempBuffer) ---
+    // --- Вертикальный проход (на транспонированном изображении, output -> tempBuffer) ---
     // Размеры для ядра размытия теперь height (новая ширина) и width (новая высота)
     int transposedWidth = height;
     int transposedHeight = width;
-    err = clSetKernelArg(m_blurPassKernel, 0, sizeof(cl_mem), &inputOutputBuffer); CheckCLError(err, "SetArg BlurV 0");
-    err = clSetKernelArg(m_blurPassKernel, 1, sizeof(cl_mem), &tempBuffer);        CheckCLError(err, "SetArg BlurV 1");
+    err = clSetKernelArg(blurPassKernel, 0, sizeof(cl_mem), &output);             CheckCLError(err, "SetArg BlurV 0");
+    err = clSetKernelArg(blurPassKernel, 1, sizeof(cl_mem), tempBuffer.GetPtr()); CheckCLError(err, "SetArg BlurV 1");
     // Arg 2 (kernelCLBuffer) и 3 (m_effectRadius) остаются теми же
-    err = clSetKernelArg(m_blurPassKernel, 4, sizeof(int), &transposedWidth);      CheckCLError(err, "SetArg BlurV 4");
-    err = clSetKernelArg(m_blurPassKernel, 5, sizeof(int), &transposedHeight);     CheckCLError(err, "SetArg BlurV 5");
+    err = clSetKernelArg(blurPassKernel, 4, sizeof(int), &transposedWidth);       CheckCLError(err, "SetArg BlurV 4");
+    err = clSetKernelArg(blurPassKernel, 5, sizeof(int), &transposedHeight);      CheckCLError(err, "SetArg BlurV 5");
 
     // globalWorkSizePass1 (numPixels) остается тем же, т.к. количество пикселей не изменилось
-    err = clEnqueueNDRangeKernel(m_commandQueue, m_blurPassKernel, 1, nullptr, globalWorkSizePass1, nullptr, 0, nullptr, nullptr);
+    err = m_runtime->EnqueueTunedKernel(queue, blurPassKernel, 1, globalWorkSizePass1,
+                                        m_runtime->GetProfiler().Track("Gaussian BlurPass V", ProfileCategory::COMPUTE));
     CheckCLError(err, "EnqueueNDRangeKernel (BlurPass Vertical)");
 
-    // --- Транспонирование 2 (обратно, tempBuffer -> inputOutputBuffer) ---
+    // --- Транспонирование 2 (обратно, tempBuffer -> output) ---
     // Размеры для ядра транспонирования теперь transposedWidth=height, transposedHeight=width
-    err = clSetKernelArg(m_transposeKernel, 0, sizeof(cl_mem), &tempBuffer);         CheckCLError(err, "SetArg Transpose2 0");
-    err = clSetKernelArg(m_transposeKernel, 1, sizeof(cl_mem), &inputOutputBuffer);  CheckCLError(err, "SetArg Transpose2 1");
-    err = clSetKernelArg(m_transposeKernel, 2, sizeof(int), &transposedWidth);       CheckCLError(err, "SetArg Transpose2 2"); // Старая ширина транспонированного = новая высота исходного
-    err = clSetKernelArg(m_transposeKernel, 3, sizeof(int), &transposedHeight);      CheckCLError(err, "SetArg Transpose2 3"); // Старая высота транспонированного = новая ширина исходного
+    err = clSetKernelArg(transposeKernel, 0, sizeof(cl_mem), tempBuffer.GetPtr()); CheckCLError(err, "SetArg Transpose2 0");
+    err = clSetKernelArg(transposeKernel, 1, sizeof(cl_mem), &output);             CheckCLError(err, "SetArg Transpose2 1");
+    err = clSetKernelArg(transposeKernel, 2, sizeof(int), &transposedWidth);       CheckCLError(err, "SetArg Transpose2 2"); // Старая ширина транспонированного = новая высота исходного
+    err = clSetKernelArg(transposeKernel, 3, sizeof(int), &transposedHeight);      CheckCLError(err, "SetArg Transpose2 3"); // Старая высота транспонированного = новая ширина исходного
+    const int finalEpilogue = 1;
+    err = clSetKernelArg(transposeKernel, 4, sizeof(int), &finalEpilogue);         CheckCLError(err, "SetArg Transpose2 4");
 
     size_t globalWorkSizeTransposeBack[2] = {static_cast<size_t>(transposedWidth), static_cast<size_t>(transposedHeight)}; // (height, width)
-    err = clEnqueueNDRangeKernel(m_commandQueue, m_transposeKernel, 2, nullptr, globalWorkSizeTransposeBack, nullptr, 0, nullptr, nullptr);
+    err = m_runtime->EnqueueTunedKernel(queue, transposeKernel, 2, globalWorkSizeTransposeBack,
+                                        m_runtime->GetProfiler().Track("Gaussian TransposeImage", ProfileCategory::COMPUTE));
     CheckCLError(err, "EnqueueNDRangeKernel (Transpose2)");
-
-    // Чтение результата
-    err = clEnqueueReadBuffer(m_commandQueue, inputOutputBuffer, CL_TRUE, 0, imageSizeBytes, imageData.data(), 0, nullptr, nullptr);
-    CheckCLError(err, "clEnqueueReadBuffer (GaussianResult)");
-
-    clFinish(m_commandQueue);
-
-    clReleaseMemObject(inputOutputBuffer);
-    clReleaseMemObject(tempBuffer);
-    clReleaseMemObject(kernelCLBuffer);
+    // Очередей может быть несколько, поэтому tempBuffer снова выдается из пула только после этих ядер
+    tempBuffer.ResetAfter(queue);
 }
 
 void GaussianFilter::SetEffectRadius(int radius)
 {
     m_effectRadius = std::max(0, radius);
+}
+
+void GaussianFilter::SetOption(const std::string& key, const std::string& value)
+{
+    if (key == "box_from") {
+        // Радиус, начиная с которого auto переключается на box-фильтры; 0 - никогда
+        m_boxRadiusThreshold = std::max(0, std::stoi(value));
+        return;
+    }
+    if (key != "algo") {
+        OpenCLImageFilter::SetOption(key, value);
+        return;
+    }
+    if (value == "auto") m_algorithm = GaussianAlgorithm::AUTO;
+    else if (value == "box") m_algorithm = GaussianAlgorithm::BOX;
+    else if (value == "separable") m_algorithm = GaussianAlgorithm::SEPARABLE;
+    else if (value == "transpose") m_algorithm = GaussianAlgorithm::TRANSPOSE;
+    else if (value == "planar") m_algorithm = GaussianAlgorithm::PLANAR;
+    else throw std::runtime_error("Unknown gaussian algo '" + value + "' (auto, separable, transpose, planar, box)");
 }
\ No newline at end of file
@@ -1,34 +1,87 @@
 #pragma once
-#include "IImageFilter.h"
+#include "OpenCLImageFilter.h"
 #include <CL/cl.h> // C API
 #include <string>
 #include <vector>
 
-class GaussianFilter : public IImageFilter
+enum class GaussianAlgorithm
+{
+    AUTO,      // SEPARABLE, а начиная с радиуса box_from - BOX
+    SEPARABLE, // Строки BlurPass + столбцы BlurColumns: два прохода по изображению
+    TRANSPOSE, // BlurPass, транспонирование, BlurPass, транспонирование: четыре прохода
+    PLANAR,    // Для 3 каналов: RGB раскладывается на плоскости и размывается одноканальными ядрами
+    BOX        // BOX_PASSES box-фильтров скользящей суммой: стоимость не зависит от радиуса
+};
+
+class GaussianFilter : public OpenCLImageFilter
 {
 public:
     explicit GaussianFilter(int initialRadius); // Контекст OpenCL будет создан внутри
     ~GaussianFilter() override;
 
-    void ApplyFilter(std::vector<unsigned char>& imageData, int width, int height, int channels) override;
+    void EnqueueOnDevice(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                         ElementType elementType) override;
     void SetEffectRadius(int radius) override;
+    // "algo": auto | separable | transpose | planar | box; "box_from": радиус для auto
+    void SetOption(const std::string& key, const std::string& value) override;
     [[nodiscard]] std::string GetName() const override { return "Gaussian Blur"; }
+    [[nodiscard]] bool IsIdentity() const override { return m_effectRadius == 0 && !HasEpilogue(); }
+    [[nodiscard]] bool SupportsEpilogue() const override { return true; }
+    [[nodiscard]] int GetHaloRows() const override;
+    [[nodiscard]] size_t GetScratchBytes(int width, int rows, int channels, ElementType elementType) const override;
+
+    // Нормированные веса 2 * radius + 1; общие с CPU-бэкендом, чтобы результаты совпадали
+    static std::vector<float> CreateGaussianKernelValues(int radius, float sigma);
+    static float SigmaForRadius(int radius);
 
 private:
-    void InitializeOpenCl();
     void ReleaseOpenCl();
-    void CreateKernels(); // Создает оба ядра
-    static std::vector<float> CreateGaussianKernelValues(int radius, float sigma);
+    // Ядра, собранные с -DCHANNELS=N -DELEMENT=T (и с эпилогом в последней записи путей, если fuseEpilogue)
+    struct ChannelKernels
+    {
+        cl_kernel blurPass = nullptr;
+        cl_kernel transpose = nullptr;
+        cl_kernel columns = nullptr;
+        cl_kernel splitPlanes = nullptr;
+        cl_kernel mergePlanes = nullptr;
+        cl_kernel boxFromImage = nullptr;
+        cl_kernel box = nullptr;
+        cl_kernel boxColumnsToImage = nullptr;
+    };
+
+    ChannelKernels GetKernels(int channels, ElementType elementType, bool fuseEpilogue = false);
+    [[nodiscard]] bool UsesStackedBoxes() const;
+    // Носитель свертки боксов - сумма их радиусов; на столько же расширены промежуточные буферы
+    [[nodiscard]] int GetBoxSupport() const;
+    // Строки и столбцы для planes плоскостей, лежащих в буфере подряд
+    void EnqueueRowsAndColumns(cl_command_queue queue, const ChannelKernels& kernels, cl_mem input, cl_mem output,
+                               int width, int height, int planes, int channels, ElementType elementType);
+    void EnqueuePlanar(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, ElementType elementType);
+    void EnqueueTransposed(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                           ElementType elementType);
+    void EnqueueStackedBoxes(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                             ElementType elementType);
+    [[nodiscard]] size_t GetColumnTileHeight() const;
+    // Блок BlurColumns с полями помещается в локальную память (иначе - схема с транспонированием)
+    [[nodiscard]] bool FitsColumnTile(int channels, ElementType elementType) const;
+    // Радиусы box-фильтров, свертка которых приближает ядро weights
+    static std::vector<int> CreateBoxRadii(const std::vector<float>& weights, int passes);
+    cl_mem GetWeightsBuffer(); // Буфер весов для текущего радиуса
 
     int m_effectRadius;
+    GaussianAlgorithm m_algorithm = GaussianAlgorithm::AUTO;
+    int m_boxRadiusThreshold = 16;
+    static constexpr int BOX_PASSES = 3;
+    static constexpr size_t COLUMN_TILE_WIDTH = 16;
 
-    cl_device_id m_deviceId = nullptr;
-    cl_context m_context = nullptr;
-    cl_command_queue m_commandQueue = nullptr;
-    cl_program m_program = nullptr;
-    cl_kernel m_blurPassKernel = nullptr;
-    cl_kernel m_transposeKernel = nullptr;
+    std::vector<int> m_boxRadii;
+    int m_boxRadiiForRadius = -1;
+    cl_mem m_weightsBuffer = nullptr;
+    int m_weightsRadius = -1; // Радиус, для которого посчитан m_weightsBuffer
 
     static const std::string m_blurPassKernelSource;
     static const std::string m_transposeKernelSource;
+    static const std::string m_columnKernelSource;
+    static const std::string m_planesKernelSource;
+    static const std::string m_boxKernelSource;
 };
\ No newline at end of file
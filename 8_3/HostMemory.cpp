@@ -0,0 +1,47 @@
+#include "HostMemory.h"
+#include "OpenCLUtils.h"
+#include <cstring>
+
+HostMappedBuffer::HostMappedBuffer(cl_context context, cl_mem_flags access, void* hostPtr, size_t sizeBytes)
+        : m_hostPtr(hostPtr), m_sizeBytes(sizeBytes)
+{
+    cl_int err;
+    m_buffer = clCreateBuffer(context, access | CL_MEM_USE_HOST_PTR, sizeBytes, hostPtr, &err);
+    CheckCLError(err, "HostMappedBuffer clCreateBuffer");
+}
+
+HostMappedBuffer::~HostMappedBuffer()
+{
+    // Буфер, еще используемый командами в очереди, OpenCL удалит после их завершения
+    if (m_buffer) clReleaseMemObject(m_buffer);
+}
+
+HostMappedBuffer::HostMappedBuffer(HostMappedBuffer&& other) noexcept
+        : m_buffer(other.m_buffer), m_hostPtr(other.m_hostPtr), m_sizeBytes(other.m_sizeBytes)
+{
+    other.m_buffer = nullptr;
+}
+
+HostMappedBuffer& HostMappedBuffer::operator=(HostMappedBuffer&& other) noexcept
+{
+    if (this != &other) {
+        if (m_buffer) clReleaseMemObject(m_buffer);
+        m_buffer = other.m_buffer;
+        m_hostPtr = other.m_hostPtr;
+        m_sizeBytes = other.m_sizeBytes;
+        other.m_buffer = nullptr;
+    }
+    return *this;
+}
+
+void HostMappedBuffer::SyncToHost(cl_command_queue queue, cl_event* profilingEvent)
+{
+    cl_int err;
+    void* mapped = clEnqueueMapBuffer(queue, m_buffer, CL_TRUE, CL_MAP_READ, 0, m_sizeBytes, 0, nullptr,
+                                      profilingEvent, &err);
+    CheckCLError(err, "HostMappedBuffer clEnqueueMapBuffer");
+    // Реализация без общей памяти (или с невыровненным hostPtr) отдает собственную копию
+    if (mapped != m_hostPtr) std::memcpy(m_hostPtr, mapped, m_sizeBytes);
+    err = clEnqueueUnmapMemObject(queue, m_buffer, mapped, 0, nullptr, nullptr);
+    CheckCLError(err, "HostMappedBuffer clEnqueueUnmapMemObject");
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <CL/cl.h>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// Память хоста, выровненная по странице. Реализации OpenCL с общей с хостом памятью (CPU,
+// встроенные GPU) используют такую память как хранилище буфера CL_MEM_USE_HOST_PTR без копии;
+// невыровненный указатель они молча копируют во внутренний буфер.
+constexpr size_t HOST_PAGE_SIZE = 4096;
+
+template <typename T>
+class PageAlignedAllocator
+{
+public:
+    using value_type = T;
+
+    PageAlignedAllocator() noexcept = default;
+    template <typename U>
+    PageAlignedAllocator(const PageAlignedAllocator<U>&) noexcept {}
+
+    T* allocate(size_t count)
+    {
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(HOST_PAGE_SIZE)));
+    }
+    void deallocate(T* pointer, size_t) noexcept
+    {
+        ::operator delete(pointer, std::align_val_t(HOST_PAGE_SIZE));
+    }
+
+    template <typename U>
+    bool operator==(const PageAlignedAllocator<U>&) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const PageAlignedAllocator<U>&) const noexcept { return false; }
+};
+
+// Пиксели изображения на хосте (см. HostImage::pixels)
+using PixelBuffer = std::vector<unsigned char, PageAlignedAllocator<unsigned char>>;
+
+// Буфер OpenCL поверх существующей памяти хоста (CL_MEM_USE_HOST_PTR): на устройствах с общей
+// памятью ядра работают прямо с ней, без clEnqueueWriteBuffer/clEnqueueReadBuffer.
+// Память хоста должна жить дольше буфера, а пока буфер используется командами, трогать ее нельзя.
+class HostMappedBuffer
+{
+public:
+    HostMappedBuffer(cl_context context, cl_mem_flags access, void* hostPtr, size_t sizeBytes);
+    ~HostMappedBuffer();
+
+    HostMappedBuffer(HostMappedBuffer&& other) noexcept;
+    HostMappedBuffer& operator=(HostMappedBuffer&& other) noexcept;
+    HostMappedBuffer(const HostMappedBuffer&) = delete;
+    HostMappedBuffer& operator=(const HostMappedBuffer&) = delete;
+
+    [[nodiscard]] cl_mem Get() const { return m_buffer; }
+    [[nodiscard]] const cl_mem* GetPtr() const { return &m_buffer; }
+
+    // Дожидается команд queue и делает результат видимым по hostPtr: блокирующий clEnqueueMapBuffer
+    // на чтение и unmap. При общей памяти map возвращает сам hostPtr и ничего не копирует.
+    void SyncToHost(cl_command_queue queue, cl_event* profilingEvent = nullptr);
+
+private:
+    cl_mem m_buffer = nullptr;
+    void* m_hostPtr = nullptr;
+    size_t m_sizeBytes = 0;
+};
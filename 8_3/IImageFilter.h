@@ -1,4 +1,5 @@
 #pragma once
+#include "HostMemory.h"
 #include <vector>
 #include <string>
 #include <CL/cl.h> // Используем C API
@@ -9,15 +10,17 @@ public:
     virtual ~IImageFilter() = default;
     // Применяет фильтр к imageData. imageData может быть изменена по месту.
     virtual void ApplyFilter(
-            std::vector<unsigned char>& imageData,
+            PixelBuffer& imageData,
             int width,
             int height,
             int channels) = 0;
 
     virtual void SetEffectRadius(int radius) = 0;
     virtual std::string GetName() const = 0;
+    // Сколько каналов фильтр умеет обрабатывать; 0 - любое количество (1..4)
+    virtual int GetRequiredChannels() const { return 0; }
 
 protected:
-    // Общие ресурсы OpenCL для фильтров (можно инициализировать в базовом классе или в каждом наследнике)
-    // Для простоты, каждый фильтр будет управлять своими ресурсами
+    // Контекст, очереди и программы OpenCL фильтры берут из общего OpenCLRuntime,
+    // а собственными у каждого фильтра остаются только ядра (cl_kernel).
 };
\ No newline at end of file
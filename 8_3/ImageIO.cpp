@@ -0,0 +1,148 @@
+#include "ImageIO.h"
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+namespace
+{
+uint32_t Crc32(const unsigned char* data, size_t size, uint32_t crc = 0)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; ++bit) crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1u)));
+    }
+    return ~crc;
+}
+
+void AppendBigEndian(std::vector<unsigned char>& out, uint32_t value)
+{
+    for (int shift = 24; shift >= 0; shift -= 8) out.push_back(static_cast<unsigned char>(value >> shift));
+}
+
+void AppendChunk(std::vector<unsigned char>& out, const char* type, const unsigned char* data, size_t size)
+{
+    AppendBigEndian(out, static_cast<uint32_t>(size));
+    size_t typeOffset = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data, data + size);
+    AppendBigEndian(out, Crc32(out.data() + typeOffset, size + 4));
+}
+
+// stb_image_write пишет только 8-битный PNG: 16-битный собирается здесь же, сжатие - его zlib
+bool WritePng16(const std::string& path, int width, int height, int channels, const PixelBuffer& samples)
+{
+    static const unsigned char colorTypes[] = {0, 0, 4, 2, 6}; // Gray, Gray+Alpha, RGB, RGBA
+    // Строка: байт фильтра (0 - без фильтра) и значения в порядке big-endian
+    const size_t rowValues = static_cast<size_t>(width) * channels;
+    std::vector<unsigned char> raw((rowValues * 2 + 1) * height);
+    for (int y = 0; y < height; ++y) {
+        unsigned char* row = raw.data() + (rowValues * 2 + 1) * y;
+        row[0] = 0;
+        for (size_t i = 0; i < rowValues; ++i) {
+            uint16_t value;
+            std::memcpy(&value, samples.data() + (y * rowValues + i) * sizeof(value), sizeof(value));
+            row[1 + 2 * i] = static_cast<unsigned char>(value >> 8);
+            row[2 + 2 * i] = static_cast<unsigned char>(value & 0xff);
+        }
+    }
+    int compressedSize = 0;
+    unsigned char* compressed = stbi_zlib_compress(raw.data(), static_cast<int>(raw.size()), &compressedSize, 8);
+    if (!compressed) return false;
+
+    std::vector<unsigned char> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    std::vector<unsigned char> header;
+    AppendBigEndian(header, static_cast<uint32_t>(width));
+    AppendBigEndian(header, static_cast<uint32_t>(height));
+    header.insert(header.end(), {16, colorTypes[channels], 0, 0, 0}); // Глубина, тип, сжатие, фильтр, без interlace
+    AppendChunk(png, "IHDR", header.data(), header.size());
+    AppendChunk(png, "IDAT", compressed, static_cast<size_t>(compressedSize));
+    AppendChunk(png, "IEND", nullptr, 0);
+    STBIW_FREE(compressed);
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(png.data()), static_cast<std::streamsize>(png.size()));
+    return static_cast<bool>(file);
+}
+}
+
+HostImage LoadImageFile(const std::string& path, int desiredChannels)
+{
+    HostImage image;
+    void* loadedPixels = nullptr;
+    // Значения сохраняют исходную точность файла: HDR - float, 16-битный PNG - ushort
+    if (stbi_is_hdr(path.c_str())) {
+        image.elementType = ElementType::FLOAT;
+        loadedPixels = stbi_loadf(path.c_str(), &image.width, &image.height, &image.channelsInFile, desiredChannels);
+    } else if (stbi_is_16_bit(path.c_str())) {
+        image.elementType = ElementType::USHORT;
+        loadedPixels = stbi_load_16(path.c_str(), &image.width, &image.height, &image.channelsInFile, desiredChannels);
+    } else {
+        loadedPixels = stbi_load(path.c_str(), &image.width, &image.height, &image.channelsInFile, desiredChannels);
+    }
+    if (!loadedPixels) {
+        throw std::runtime_error("Failed to load image: " + path + ". Reason: " + stbi_failure_reason());
+    }
+    image.channels = (desiredChannels == 0) ? image.channelsInFile : desiredChannels;
+    auto* bytes = static_cast<const unsigned char*>(loadedPixels);
+    image.pixels.assign(bytes, bytes + static_cast<size_t>(image.width) * image.height * image.channels *
+                                       GetElementSize(image.elementType));
+    stbi_image_free(loadedPixels);
+    return image;
+}
+
+std::string SaveImageFile(const std::string& path, const HostImage& image)
+{
+    std::string savedPath = path;
+    int success = 0;
+    std::string ext;
+    size_t dotPos = path.rfind('.');
+    if (dotPos != std::string::npos) {
+        ext = path.substr(dotPos);
+        for (char& c : ext) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c))); // в нижний регистр
+    }
+
+    const int width = image.width;
+    const int height = image.height;
+    const int channels = image.channels;
+    const bool wide = image.elementType != ElementType::UCHAR;
+    // 8-битные форматы получают значения, пересчитанные в uchar (без копии, если они уже такие)
+    PixelBuffer converted;
+    auto bytes = [&]() -> const unsigned char* {
+        if (!wide) return image.pixels.data();
+        converted = ConvertElements(image.pixels, image.elementType, ElementType::UCHAR);
+        return converted.data();
+    };
+    auto writePng = [&](const std::string& pngPath) {
+        if (!wide) return stbi_write_png(pngPath.c_str(), width, height, channels, image.pixels.data(), width * channels);
+        PixelBuffer samples = ConvertElements(image.pixels, image.elementType, ElementType::USHORT);
+        return WritePng16(pngPath, width, height, channels, samples) ? 1 : 0;
+    };
+    if (ext == ".png") {
+        success = writePng(path);
+    } else if (ext == ".hdr") {
+        PixelBuffer values = ConvertElements(image.pixels, image.elementType, ElementType::FLOAT);
+        success = stbi_write_hdr(path.c_str(), width, height, channels, reinterpret_cast<const float*>(values.data()));
+    } else if (ext == ".jpg" || ext == ".jpeg") {
+        success = stbi_write_jpg(path.c_str(), width, height, channels, bytes(), 90);
+    } else if (ext == ".bmp") {
+        success = stbi_write_bmp(path.c_str(), width, height, channels, bytes());
+    } else {
+        std::cerr << "Warning: Unsupported output file extension '" << ext << "'. Attempting to save as PNG to " << path << ".png" << std::endl;
+        savedPath = (dotPos != std::string::npos ? path.substr(0, dotPos) : path) + ".png";
+        success = writePng(savedPath);
+    }
+
+    if (!success) {
+        throw std::runtime_error("Failed to save image to: " + savedPath);
+    }
+    return savedPath;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include "HostMemory.h"
+#include "PixelFormat.h"
+#include <string>
+#include <vector>
+
+// Изображение в памяти хоста: пиксели построчно, каналы чередуются (RGBRGB...).
+// Пиксели выровнены по странице, чтобы фильтры OpenCL на общей памяти работали с ними без копий.
+struct HostImage
+{
+    PixelBuffer pixels; // width * height * channels значений типа elementType
+    int width = 0;
+    int height = 0;
+    int channels = 0;       // Каналы для обработки
+    int channelsInFile = 0; // Каналы в исходном файле
+    ElementType elementType = ElementType::UCHAR;
+};
+
+// Загрузка через stb_image; desiredChannels = 0 - столько каналов, сколько в файле. Бросает исключение при ошибке.
+// Radiance HDR загружается как FLOAT, 16-битный PNG - как USHORT, остальное - как UCHAR.
+HostImage LoadImageFile(const std::string& path, int desiredChannels);
+
+// Формат выбирается по расширению (.png, .jpg/.jpeg, .bmp, .hdr); для неизвестного расширения
+// пишется PNG рядом. PNG из значений шире 8 бит сохраняется 16-битным, .hdr - во float;
+// JPEG и BMP всегда 8-битные. Возвращает путь, по которому файл реально сохранен.
+std::string SaveImageFile(const std::string& path, const HostImage& image);
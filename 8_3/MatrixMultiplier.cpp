@@ -1,15 +1,34 @@
 #include "MatrixMultiplier.h"
 #include "OpenCLUtils.h" // Для CheckCLError
 #include <iostream>
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <sstream>
 #include <stdexcept>
 #include <iomanip>
 
 using Clock = std::chrono::high_resolution_clock;
 using Seconds = std::chrono::duration<double>;
 
+namespace
+{
+const char* const TUNING_NAME = "MultiplyMatrices"; // Ключ варианта ядра в базе настройки
+
+double GflopsPerSecond(int numRows1, int numColumns1, int numColumns2, double seconds)
+{
+    return 2.0 * numRows1 * numColumns1 * numColumns2 / seconds / 1e9;
+}
+}
+
 const std::string MatrixMultiplier::m_kernelSource = R"CLC(
+// Размер блока задается при сборке (-DTILE_SIZE) и совпадает с локальным размером TILE_SIZE x TILE_SIZE
+#ifndef TILE_SIZE
 #define TILE_SIZE 16
+#endif
 
 __kernel void MultiplyMatricesTiled(
     const int numRows1, const int numColumns1, const int numColumns2,
@@ -65,13 +84,113 @@ __kernel void MultiplyMatricesTiled(
 }
 )CLC";
 
+const std::string MatrixMultiplier::m_blockedKernelSource = R"CLC(
+// Каждый work-item считает блок WPT_M x WPT_N элементов результата в регистрах: на одно чтение
+// из локальной памяти приходится WPT_M (или WPT_N) умножений вместо одного.
+// Рабочая группа RTS_N x RTS_M (измерение 0 - столбцы, чтобы запись результата шла подряд)
+// совместно загружает блоки TILE_M x TILE_K из A и TILE_K x TILE_N из B чтениями float4.
+// Строки и столбцы одного work-item идут с шагом RTS_M / RTS_N: соседние work-item читают
+// соседние адреса локальной памяти. Блок A хранится транспонированным (tileA[k][row]), и запись
+// в него идет с шагом по строке; лишний столбец PAD сдвигает строки по банкам памяти.
+#define RTS_M (TILE_M / WPT_M)
+#define RTS_N (TILE_N / WPT_N)
+#define PAD 1
+
+__kernel __attribute__((reqd_work_group_size(RTS_N, RTS_M, 1)))
+void MultiplyMatricesBlocked(
+    const int numRows1, const int numColumns1, const int numColumns2,
+    __global const float* matrix1,
+    __global const float* matrix2,
+    __global float* resultMatrix) {
+
+    __local float tileA[TILE_K][TILE_M + PAD];
+    __local float tileB[TILE_K][TILE_N + PAD];
+
+    const int localCol = get_local_id(0);
+    const int localRow = get_local_id(1);
+    const int localIndex = localRow * RTS_N + localCol;
+    const int groupRow = get_group_id(1) * TILE_M;
+    const int groupCol = get_group_id(0) * TILE_N;
+
+    float accumulator[WPT_M][WPT_N];
+    for (int i = 0; i < WPT_M; ++i)
+        for (int j = 0; j < WPT_N; ++j) accumulator[i][j] = 0.0f;
+
+    const int numTiles = (numColumns1 + TILE_K - 1) / TILE_K;
+    for (int tileIdx = 0; tileIdx < numTiles; ++tileIdx) {
+        const int tileK = tileIdx * TILE_K;
+
+        // A: TILE_M строк по TILE_K / 4 векторов; на краю матрицы - поэлементно с нулями
+        for (int index = localIndex; index < TILE_M * TILE_K / 4; index += RTS_M * RTS_N) {
+            const int row = index / (TILE_K / 4);
+            const int k = index % (TILE_K / 4) * 4;
+            const int globalRow = groupRow + row;
+            const int globalK = tileK + k;
+            float4 value = (float4)(0.0f);
+            if (globalRow < numRows1) {
+                const __global float* source = matrix1 + (size_t)globalRow * numColumns1 + globalK;
+                if (globalK + 3 < numColumns1) {
+                    value = vload4(0, source);
+                } else {
+                    if (globalK < numColumns1) value.x = source[0];
+                    if (globalK + 1 < numColumns1) value.y = source[1];
+                    if (globalK + 2 < numColumns1) value.z = source[2];
+                }
+            }
+            tileA[k][row] = value.x;
+            tileA[k + 1][row] = value.y;
+            tileA[k + 2][row] = value.z;
+            tileA[k + 3][row] = value.w;
+        }
+        // B: TILE_K строк по TILE_N / 4 векторов
+        for (int index = localIndex; index < TILE_K * TILE_N / 4; index += RTS_M * RTS_N) {
+            const int k = index / (TILE_N / 4);
+            const int col = index % (TILE_N / 4) * 4;
+            const int globalK = tileK + k;
+            const int globalCol = groupCol + col;
+            float4 value = (float4)(0.0f);
+            if (globalK < numColumns1) {
+                const __global float* source = matrix2 + (size_t)globalK * numColumns2 + globalCol;
+                if (globalCol + 3 < numColumns2) {
+                    value = vload4(0, source);
+                } else {
+                    if (globalCol < numColumns2) value.x = source[0];
+                    if (globalCol + 1 < numColumns2) value.y = source[1];
+                    if (globalCol + 2 < numColumns2) value.z = source[2];
+                }
+            }
+            tileB[k][col] = value.x;
+            tileB[k][col + 1] = value.y;
+            tileB[k][col + 2] = value.z;
+            tileB[k][col + 3] = value.w;
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        for (int k = 0; k < TILE_K; ++k) {
+            float a[WPT_M];
+            float b[WPT_N];
+            for (int i = 0; i < WPT_M; ++i) a[i] = tileA[k][localRow + i * RTS_M];
+            for (int j = 0; j < WPT_N; ++j) b[j] = tileB[k][localCol + j * RTS_N];
+            for (int i = 0; i < WPT_M; ++i)
+                for (int j = 0; j < WPT_N; ++j) accumulator[i][j] += a[i] * b[j];
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    for (int i = 0; i < WPT_M; ++i) {
+        const int globalRow = groupRow + localRow + i * RTS_M;
+        if (globalRow >= numRows1) break;
+        for (int j = 0; j < WPT_N; ++j) {
+            const int globalCol = groupCol + localCol + j * RTS_N;
+            if (globalCol < numColumns2) resultMatrix[(size_t)globalRow * numColumns2 + globalCol] = accumulator[i][j];
+        }
+    }
+}
+)CLC";
+
 MatrixMultiplier::MatrixMultiplier()
 {
-    InitializeOpenCl();
-    m_program = CreateProgramWithSource(m_context, m_deviceId, m_kernelSource);
-    cl_int err;
-    m_kernel = clCreateKernel(m_program, "MultiplyMatricesTiled", &err);
-    CheckCLError(err, "clCreateKernel (MultiplyMatricesTiled)");
+    m_runtime = OpenCLRuntime::Acquire();
 }
 
 MatrixMultiplier::~MatrixMultiplier()
@@ -79,63 +198,148 @@ MatrixMultiplier::~MatrixMultiplier()
     ReleaseOpenCl();
 }
 
-void MatrixMultiplier::InitializeOpenCl()
+void MatrixMultiplier::ReleaseOpenCl()
 {
-    cl_int err;
-    cl_uint numPlatforms;
-    err = clGetPlatformIDs(0, nullptr, &numPlatforms);
-    CheckCLError(err, "clGetPlatformIDs (count)");
-    if (numPlatforms == 0) throw std::runtime_error("No OpenCL platforms found.");
-
-    std::vector<cl_platform_id> platforms(numPlatforms);
-    err = clGetPlatformIDs(numPlatforms, platforms.data(), nullptr);
-    CheckCLError(err, "clGetPlatformIDs (list)");
-
-    // Просто берем первую платформу и первое GPU устройство на ней
-    cl_platform_id platform = platforms[0]; // Упрощение, может потребоваться выбор
-
-    cl_uint numDevices;
-    err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_GPU, 0, nullptr, &numDevices);
-    if (err == CL_DEVICE_NOT_FOUND) { // Попробуем CPU, если GPU нет
-        err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_CPU, 0, nullptr, &numDevices);
-        if (err == CL_DEVICE_NOT_FOUND) throw std::runtime_error("No GPU or CPU OpenCL devices found.");
-        CheckCLError(err, "clGetDeviceIDs (CPU count)");
-        err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_CPU, 1, &m_deviceId, nullptr);
-        CheckCLError(err, "clGetDeviceIDs (CPU device)");
-        std::cout << "Using OpenCL CPU device." << std::endl;
+    for (auto& [tileSize, kernel] : m_kernels) clReleaseKernel(kernel);
+    m_kernels.clear();
+}
+
+cl_kernel MatrixMultiplier::GetKernel(const KernelConfig& config)
+{
+    const std::string buildOptions = GetBuildOptions(config);
+    auto it = m_kernels.find(buildOptions);
+    if (it != m_kernels.end()) return it->second;
+    cl_kernel kernel = config.blocked
+            ? m_runtime->CreateKernel(m_blockedKernelSource, "MultiplyMatricesBlocked", buildOptions)
+            : m_runtime->CreateKernel(m_kernelSource, "MultiplyMatricesTiled", buildOptions);
+    m_kernels.emplace(buildOptions, kernel);
+    return kernel;
+}
+
+std::string MatrixMultiplier::GetBuildOptions(const KernelConfig& config)
+{
+    if (!config.blocked) return "-DTILE_SIZE=" + std::to_string(config.tileM);
+    return "-DTILE_M=" + std::to_string(config.tileM) + " -DTILE_N=" + std::to_string(config.tileN) +
+           " -DTILE_K=" + std::to_string(config.tileK) + " -DWPT_M=" + std::to_string(config.rowsPerItem) +
+           " -DWPT_N=" + std::to_string(config.columnsPerItem);
+}
+
+std::string MatrixMultiplier::FormatConfig(const KernelConfig& config)
+{
+    if (!config.blocked) return "tiled " + std::to_string(config.tileM);
+    return "blocked " + std::to_string(config.tileM) + "x" + std::to_string(config.tileN) + "x" + std::to_string(config.tileK) +
+           " " + std::to_string(config.rowsPerItem) + "x" + std::to_string(config.columnsPerItem);
+}
+
+bool MatrixMultiplier::ParseConfig(const std::string& text, KernelConfig& config)
+{
+    std::istringstream stream(text);
+    std::string kind;
+    char separator = 0;
+    KernelConfig parsed;
+    if (!(stream >> kind)) return false;
+    if (kind == "tiled") {
+        if (!(stream >> parsed.tileM) || parsed.tileM <= 0) return false;
+        parsed.tileN = parsed.tileK = parsed.tileM;
+    } else if (kind == "blocked") {
+        parsed.blocked = true;
+        if (!(stream >> parsed.tileM >> separator >> parsed.tileN >> separator >> parsed.tileK >>
+              parsed.rowsPerItem >> separator >> parsed.columnsPerItem)) return false;
+        // Ядро требует делимости блока на число элементов work-item и векторов float4
+        if (parsed.rowsPerItem <= 0 || parsed.columnsPerItem <= 0 || parsed.tileM % parsed.rowsPerItem != 0 ||
+            parsed.tileN % parsed.columnsPerItem != 0 || parsed.tileN % 4 != 0 || parsed.tileK % 4 != 0) return false;
     } else {
-        CheckCLError(err, "clGetDeviceIDs (GPU count)");
-        if (numDevices == 0) throw std::runtime_error("No GPU devices found on selected platform.");
-        err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_GPU, 1, &m_deviceId, nullptr);
-        CheckCLError(err, "clGetDeviceIDs (GPU device)");
-        std::cout << "Using OpenCL GPU device." << std::endl;
+        return false;
     }
+    config = parsed;
+    return true;
+}
 
+bool MatrixMultiplier::Fits(const KernelConfig& config) const
+{
+    const OpenCLDeviceInfo& device = m_runtime->GetDeviceInfo();
+    size_t groupSize = static_cast<size_t>(config.tileM / config.rowsPerItem) * (config.tileN / config.columnsPerItem);
+    // У BLOCKED строки блоков дополнены одним столбцом (PAD)
+    size_t padding = config.blocked ? 1 : 0;
+    size_t localBytes = sizeof(float) * config.tileK * (config.tileM + config.tileN + 2 * padding);
+    return groupSize <= device.maxWorkGroupSize && localBytes <= device.localMemBytes;
+}
 
-    // Выведем имя устройства для информации
-    char deviceName[128];
-    clGetDeviceInfo(m_deviceId, CL_DEVICE_NAME, sizeof(deviceName), deviceName, nullptr);
-    std::cout << "Selected device: " << deviceName << std::endl;
-
-    m_context = clCreateContext(nullptr, 1, &m_deviceId, nullptr, nullptr, &err);
-    CheckCLError(err, "clCreateContext");
+void MatrixMultiplier::GetWorkSizes(const KernelConfig& config, int numRows1, int numColumns2,
+                                    size_t* globalWorkSize, size_t* localWorkSize)
+{
+    if (!config.blocked) {
+        // MultiplyMatricesTiled: измерение 0 - строки, 1 - столбцы
+        const size_t tileSize = config.tileM;
+        globalWorkSize[0] = (numRows1 + tileSize - 1) / tileSize * tileSize;
+        globalWorkSize[1] = (numColumns2 + tileSize - 1) / tileSize * tileSize;
+        localWorkSize[0] = localWorkSize[1] = tileSize;
+        return;
+    }
+    // MultiplyMatricesBlocked: измерение 0 - столбцы, 1 - строки; группа на блок tileM x tileN
+    localWorkSize[0] = config.tileN / config.columnsPerItem;
+    localWorkSize[1] = config.tileM / config.rowsPerItem;
+    globalWorkSize[0] = (numColumns2 + config.tileN - 1) / config.tileN * localWorkSize[0];
+    globalWorkSize[1] = (numRows1 + config.tileM - 1) / config.tileM * localWorkSize[1];
+}
 
-    // Используем clCreateCommandQueueWithProperties если доступно, иначе старый clCreateCommandQueue
-#if defined(CL_VERSION_2_0)
-    m_commandQueue = clCreateCommandQueueWithProperties(m_context, m_deviceId, nullptr, &err);
-#else
-    m_commandQueue = clCreateCommandQueue(m_context, m_deviceId, 0, &err);
-#endif
-    CheckCLError(err, "clCreateCommandQueue");
+void MatrixMultiplier::SetKernelArguments(cl_kernel kernel, int numRows1, int numColumns1, int numColumns2,
+                                          cl_mem bufferA, cl_mem bufferB, cl_mem bufferResult)
+{
+    cl_int err;
+    err = clSetKernelArg(kernel, 0, sizeof(int), &numRows1); CheckCLError(err, "clSetKernelArg 0");
+    err = clSetKernelArg(kernel, 1, sizeof(int), &numColumns1); CheckCLError(err, "clSetKernelArg 1");
+    err = clSetKernelArg(kernel, 2, sizeof(int), &numColumns2); CheckCLError(err, "clSetKernelArg 2");
+    err = clSetKernelArg(kernel, 3, sizeof(cl_mem), &bufferA); CheckCLError(err, "clSetKernelArg 3");
+    err = clSetKernelArg(kernel, 4, sizeof(cl_mem), &bufferB); CheckCLError(err, "clSetKernelArg 4");
+    err = clSetKernelArg(kernel, 5, sizeof(cl_mem), &bufferResult); CheckCLError(err, "clSetKernelArg 5");
 }
 
-void MatrixMultiplier::ReleaseOpenCl()
+MatrixMultiplier::KernelConfig MatrixMultiplier::SelectKernel(cl_command_queue queue, int numRows1, int numColumns1,
+                                                              int numColumns2, cl_mem bufferA, cl_mem bufferB,
+                                                              cl_mem bufferResult)
 {
-    if (m_kernel) clReleaseKernel(m_kernel);
-    if (m_program) clReleaseProgram(m_program);
-    if (m_commandQueue) clReleaseCommandQueue(m_commandQueue);
-    if (m_context) clReleaseContext(m_context);
-    // clReleaseDevice не нужен для m_deviceId, он получен, а не создан
+    const size_t problemSize[3] = {static_cast<size_t>(numRows1), static_cast<size_t>(numColumns2), static_cast<size_t>(numColumns1)};
+    const std::string sizeClass = TuningDatabase::MakeSizeClass(3, problemSize);
+    KernelConfig config;
+    if (std::optional<std::string> tuned = m_runtime->FindTuned(TUNING_NAME, sizeClass)) {
+        if (ParseConfig(*tuned, config) && Fits(config)) return config;
+    }
+    auto untuned = m_untunedConfigs.find(sizeClass);
+    if (untuned != m_untunedConfigs.end()) return untuned->second;
+
+    // Исходное ядро и блочное с 4x4 элементами на work-item; --tune добавляет размеры блоков
+    std::vector<std::string> candidates = {"tiled 16", "blocked 64x64x16 4x4", "blocked 32x32x16 4x4"};
+    if (m_runtime->IsTuning()) {
+        candidates.insert(candidates.end(), {"tiled 8", "tiled 32", "blocked 64x32x16 8x4", "blocked 128x64x16 8x4",
+                                             "blocked 64x64x8 4x4", "blocked 128x128x16 8x8"});
+    }
+
+    // Матрицы уже на устройстве: каждый кандидат считает настоящее произведение
+    clFinish(queue);
+    KernelConfig best;
+    double bestMs = std::numeric_limits<double>::infinity();
+    for (const std::string& candidate : candidates) {
+        if (!ParseConfig(candidate, config) || !Fits(config)) continue;
+        cl_kernel kernel = GetKernel(config);
+        SetKernelArguments(kernel, numRows1, numColumns1, numColumns2, bufferA, bufferB, bufferResult);
+        size_t globalWorkSize[2];
+        size_t localWorkSize[2];
+        GetWorkSizes(config, numRows1, numColumns2, globalWorkSize, localWorkSize);
+        double candidateMs = m_runtime->MeasureKernelMs(queue, kernel, 2, globalWorkSize, localWorkSize);
+        std::cout << "  " << candidate << ": ";
+        if (std::isinf(candidateMs)) std::cout << "does not run" << std::endl;
+        else std::cout << candidateMs << " ms, " << GflopsPerSecond(numRows1, numColumns1, numColumns2, candidateMs / 1000.0)
+                       << " GFLOP/s" << std::endl;
+        if (candidateMs < bestMs) {
+            bestMs = candidateMs;
+            best = config;
+        }
+    }
+    std::cout << "Selected GEMM kernel [" << sizeClass << "]: " << FormatConfig(best) << std::endl;
+    if (m_runtime->IsTuning()) m_runtime->StoreTuned(TUNING_NAME, sizeClass, FormatConfig(best));
+    else m_untunedConfigs[sizeClass] = best;
+    return best;
 }
 
 void MatrixMultiplier::RunBenchmark(int numRows1, int numColumns1, int numColumns2)
@@ -143,8 +347,8 @@ void MatrixMultiplier::RunBenchmark(int numRows1, int numColumns1, int numColumn
     std::cout << "Matrix dimensions: A(" << numRows1 << "x" << numColumns1
               << "), B(" << numColumns1 << "x" << numColumns2 << ")" << std::endl;
 
-    std::vector<float> matrix1(numRows1 * numColumns1);
-    std::vector<float> matrix2(numColumns1 * numColumns2);
+    Matrix matrix1(numRows1 * numColumns1);
+    Matrix matrix2(numColumns1 * numColumns2);
 
     for (size_t i = 0; i < matrix1.size(); ++i) matrix1[i] = static_cast<float>(i % 100) + 0.1f;
     for (size_t i = 0; i < matrix2.size(); ++i) matrix2[i] = static_cast<float>(i % 50) + 0.2f;
@@ -157,24 +361,34 @@ void MatrixMultiplier::RunBenchmark(int numRows1, int numColumns1, int numColumn
     auto gpuResult = MultiplyOnGpu(numRows1, numColumns1, numColumns2, matrix1, matrix2);
     PrintMatrixSample(gpuResult, "GPU Result Sample"); // НОВЫЙ ПРАВИЛЬНЫЙ ВЫЗОВ
 
-    bool verified = true;
-    if (cpuResult.empty() || gpuResult.empty() || cpuResult.size() != gpuResult.size()) {
-        verified = false;
-    } else {
-        const float epsilon = 1e-3f;
-        if (std::abs(cpuResult.front() - gpuResult.front()) > epsilon ||
-            std::abs(cpuResult.back() - gpuResult.back()) > epsilon) {
+    // Сравнивается вся матрица: ошибка блочного ядра может затронуть только часть блоков.
+    // Порядок суммирования на устройстве другой, поэтому допуск относительный
+    bool verified = !cpuResult.empty() && cpuResult.size() == gpuResult.size();
+    if (verified) {
+        const float relativeEpsilon = 1e-3f;
+        size_t mismatches = 0;
+        size_t firstMismatch = 0;
+        for (size_t i = 0; i < cpuResult.size(); ++i) {
+            float tolerance = relativeEpsilon * std::max(1.0f, std::abs(cpuResult[i]));
+            if (!(std::abs(cpuResult[i] - gpuResult[i]) <= tolerance)) {
+                if (mismatches++ == 0) firstMismatch = i;
+            }
+        }
+        if (mismatches > 0) {
             verified = false;
+            std::cout << mismatches << " mismatched elements, first at (" << firstMismatch / numColumns2 << ", "
+                      << firstMismatch % numColumns2 << "): CPU " << cpuResult[firstMismatch]
+                      << ", GPU " << gpuResult[firstMismatch] << std::endl;
         }
     }
     std::cout << "Verification: " << (verified ? "PASSED" : "FAILED") << std::endl;
 }
 
-std::vector<float> MatrixMultiplier::MultiplyOnCpu(
+Matrix MatrixMultiplier::MultiplyOnCpu(
         int numRows1, int numColumns1, int numColumns2,
-        const std::vector<float>& matrix1, const std::vector<float>& matrix2)
+        const Matrix& matrix1, const Matrix& matrix2)
 {
-    std::vector<float> resultMatrix(numRows1 * numColumns2, 0.0f);
+    Matrix resultMatrix(numRows1 * numColumns2, 0.0f);
 
     auto startTime = Clock::now();
     for (int i = 0; i < numRows1; ++i)
@@ -190,53 +404,91 @@ std::vector<float> MatrixMultiplier::MultiplyOnCpu(
         }
     }
     auto endTime = Clock::now();
-    std::cout << "CPU multiplication time: " << Seconds(endTime - startTime).count() << " seconds" << std::endl;
+    double seconds = Seconds(endTime - startTime).count();
+    std::cout << "CPU multiplication time: " << seconds << " seconds, "
+              << GflopsPerSecond(numRows1, numColumns1, numColumns2, seconds) << " GFLOP/s" << std::endl;
     return resultMatrix;
 }
 
-std::vector<float> MatrixMultiplier::MultiplyOnGpu(
+Matrix MatrixMultiplier::MultiplyOnGpu(
         int numRows1, int numColumns1, int numColumns2,
-        const std::vector<float>& matrix1, const std::vector<float>& matrix2)
+        const Matrix& matrix1, const Matrix& matrix2)
 {
     cl_int err;
-    std::vector<float> resultMatrix(numRows1 * numColumns2, 0.0f);
+    cl_context context = m_runtime->GetContext();
+    cl_command_queue queue = m_runtime->GetQueue();
+    Matrix resultMatrix(numRows1 * numColumns2, 0.0f);
 
     auto startTime = Clock::now();
 
-    cl_mem bufferA = clCreateBuffer(m_context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
-                                    sizeof(float) * matrix1.size(), (void*)matrix1.data(), &err);
+    CommandProfiler& profiler = m_runtime->GetProfiler();
+    // На общей с хостом памяти буферы создаются поверх самих матриц: ни загрузки, ни чтения
+    const bool zeroCopy = m_runtime->UsesZeroCopy();
+    const cl_mem_flags hostFlags = zeroCopy ? CL_MEM_USE_HOST_PTR : 0;
+    cl_mem bufferA = clCreateBuffer(context, CL_MEM_READ_ONLY | hostFlags, sizeof(float) * matrix1.size(),
+                                    zeroCopy ? const_cast<float*>(matrix1.data()) : nullptr, &err);
     CheckCLError(err, "clCreateBuffer (bufferA)");
-    cl_mem bufferB = clCreateBuffer(m_context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
-                                    sizeof(float) * matrix2.size(), (void*)matrix2.data(), &err);
+    cl_mem bufferB = clCreateBuffer(context, CL_MEM_READ_ONLY | hostFlags, sizeof(float) * matrix2.size(),
+                                    zeroCopy ? const_cast<float*>(matrix2.data()) : nullptr, &err);
     CheckCLError(err, "clCreateBuffer (bufferB)");
-    cl_mem bufferResult = clCreateBuffer(m_context, CL_MEM_WRITE_ONLY,
-                                         sizeof(float) * resultMatrix.size(), nullptr, &err);
+    if (!zeroCopy) {
+        // Загрузка отдельными командами, а не CL_MEM_COPY_HOST_PTR: так ее видно в профиле
+        err = clEnqueueWriteBuffer(queue, bufferA, CL_FALSE, 0, sizeof(float) * matrix1.size(), matrix1.data(), 0, nullptr,
+                                   profiler.Track("Matrix write A", ProfileCategory::TRANSFER));
+        CheckCLError(err, "clEnqueueWriteBuffer (bufferA)");
+        err = clEnqueueWriteBuffer(queue, bufferB, CL_FALSE, 0, sizeof(float) * matrix2.size(), matrix2.data(), 0, nullptr,
+                                   profiler.Track("Matrix write B", ProfileCategory::TRANSFER));
+        CheckCLError(err, "clEnqueueWriteBuffer (bufferB)");
+    }
+    cl_mem bufferResult = clCreateBuffer(context, CL_MEM_WRITE_ONLY | hostFlags, sizeof(float) * resultMatrix.size(),
+                                         zeroCopy ? resultMatrix.data() : nullptr, &err);
     CheckCLError(err, "clCreateBuffer (bufferResult)");
 
-    err = clSetKernelArg(m_kernel, 0, sizeof(int), &numRows1); CheckCLError(err, "clSetKernelArg 0");
-    err = clSetKernelArg(m_kernel, 1, sizeof(int), &numColumns1); CheckCLError(err, "clSetKernelArg 1");
-    err = clSetKernelArg(m_kernel, 2, sizeof(int), &numColumns2); CheckCLError(err, "clSetKernelArg 2");
-    err = clSetKernelArg(m_kernel, 3, sizeof(cl_mem), &bufferA); CheckCLError(err, "clSetKernelArg 3");
-    err = clSetKernelArg(m_kernel, 4, sizeof(cl_mem), &bufferB); CheckCLError(err, "clSetKernelArg 4");
-    err = clSetKernelArg(m_kernel, 5, sizeof(cl_mem), &bufferResult); CheckCLError(err, "clSetKernelArg 5");
-
-    size_t globalWorkSize[2] = {
-            static_cast<size_t>((numRows1 + m_tileSize - 1) / m_tileSize * m_tileSize),
-            static_cast<size_t>((numColumns2 + m_tileSize - 1) / m_tileSize * m_tileSize)
-    };
-    size_t localWorkSize[2] = {static_cast<size_t>(m_tileSize), static_cast<size_t>(m_tileSize)};
-
-    err = clEnqueueNDRangeKernel(m_commandQueue, m_kernel, 2, nullptr, globalWorkSize, localWorkSize, 0, nullptr, nullptr);
+    // Выбор ядра (с замерами кандидатов) в общее время не входит: загрузка дожидается здесь,
+    // и отсчет начинается заново после выбора
+    clFinish(queue);
+    double setupSeconds = Seconds(Clock::now() - startTime).count();
+    const KernelConfig config = SelectKernel(queue, numRows1, numColumns1, numColumns2, bufferA, bufferB, bufferResult);
+    startTime = Clock::now();
+    cl_kernel kernel = GetKernel(config);
+    SetKernelArguments(kernel, numRows1, numColumns1, numColumns2, bufferA, bufferB, bufferResult);
+
+    size_t globalWorkSize[2];
+    size_t localWorkSize[2];
+    GetWorkSizes(config, numRows1, numColumns2, globalWorkSize, localWorkSize);
+
+    // Загрузка завершается до замера, чтобы GFLOP/s относились только к ядру
+    clFinish(queue);
+    auto kernelStartTime = Clock::now();
+    err = clEnqueueNDRangeKernel(queue, kernel, 2, nullptr, globalWorkSize, localWorkSize, 0, nullptr,
+                                 profiler.Track(config.blocked ? "MultiplyMatricesBlocked" : "MultiplyMatricesTiled",
+                                                ProfileCategory::COMPUTE));
     CheckCLError(err, "clEnqueueNDRangeKernel");
+    err = clFinish(queue);
+    CheckCLError(err, "clFinish (kernel)");
+    double kernelSeconds = Seconds(Clock::now() - kernelStartTime).count();
+    std::cout << "GPU kernel (" << FormatConfig(config) << "): " << kernelSeconds << " seconds, "
+              << GflopsPerSecond(numRows1, numColumns1, numColumns2, kernelSeconds) << " GFLOP/s" << std::endl;
+
+    if (zeroCopy) {
+        // Map на общей памяти возвращает resultMatrix.data(), иначе - копию реализации
+        void* mapped = clEnqueueMapBuffer(queue, bufferResult, CL_TRUE, CL_MAP_READ, 0, sizeof(float) * resultMatrix.size(),
+                                          0, nullptr, profiler.Track("Matrix map", ProfileCategory::TRANSFER), &err);
+        CheckCLError(err, "clEnqueueMapBuffer");
+        if (mapped != resultMatrix.data()) std::memcpy(resultMatrix.data(), mapped, sizeof(float) * resultMatrix.size());
+        err = clEnqueueUnmapMemObject(queue, bufferResult, mapped, 0, nullptr, nullptr);
+        CheckCLError(err, "clEnqueueUnmapMemObject");
+    } else {
+        err = clEnqueueReadBuffer(queue, bufferResult, CL_TRUE, 0,
+                                  sizeof(float) * resultMatrix.size(), resultMatrix.data(), 0, nullptr,
+                                  profiler.Track("Matrix read", ProfileCategory::TRANSFER));
+        CheckCLError(err, "clEnqueueReadBuffer");
+    }
 
-    err = clEnqueueReadBuffer(m_commandQueue, bufferResult, CL_TRUE, 0,
-                              sizeof(float) * resultMatrix.size(), resultMatrix.data(), 0, nullptr, nullptr);
-    CheckCLError(err, "clEnqueueReadBuffer");
-
-    clFinish(m_commandQueue); // Убедимся, что все выполнено
+    clFinish(queue); // Убедимся, что все выполнено
 
     auto endTime = Clock::now();
-    std::cout << "GPU multiplication time: " << Seconds(endTime - startTime).count() << " seconds" << std::endl;
+    std::cout << "GPU multiplication time: " << setupSeconds + Seconds(endTime - startTime).count() << " seconds" << std::endl;
 
     clReleaseMemObject(bufferA);
     clReleaseMemObject(bufferB);
@@ -245,7 +497,7 @@ std::vector<float> MatrixMultiplier::MultiplyOnGpu(
     return resultMatrix;
 }
 
-void MatrixMultiplier::PrintMatrixSample(const std::vector<float>& matrix, const std::string& name) { // Новая версия
+void MatrixMultiplier::PrintMatrixSample(const Matrix& matrix, const std::string& name) { // Новая версия
     if (matrix.empty()) {
         std::cout << name << " is empty." << std::endl;
         return;
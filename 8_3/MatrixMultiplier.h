@@ -1,7 +1,14 @@
 #pragma once
+#include <map>
 #include <vector>
 #include <string>
 #include <CL/cl.h> // C API
+#include <memory>
+#include "HostMemory.h"
+#include "OpenCLRuntime.h"
+
+// Матрица построчно; выровнена по странице, чтобы на общей памяти буферы OpenCL обходились без копий
+using Matrix = std::vector<float, PageAlignedAllocator<float>>;
 
 class MatrixMultiplier
 {
@@ -11,24 +18,53 @@ public:
     void RunBenchmark(int numRows1, int numColumns1, int numColumns2);
 
 private:
-    std::vector<float> MultiplyOnCpu(
+    // Вариант ядра умножения. TILED - один элемент результата на work-item (MultiplyMatricesTiled,
+    // блок tileM x tileM); BLOCKED - блок rowsPerItem x columnsPerItem в регистрах на work-item
+    // (MultiplyMatricesBlocked): блок результата tileM x tileN, шаг по общей размерности tileK.
+    struct KernelConfig
+    {
+        bool blocked = false;
+        int tileM = 16;
+        int tileN = 16;
+        int tileK = 16;
+        int rowsPerItem = 1;
+        int columnsPerItem = 1;
+    };
+
+    Matrix MultiplyOnCpu(
             int numRows1, int numColumns1, int numColumns2,
-            const std::vector<float>& matrix1, const std::vector<float>& matrix2);
+            const Matrix& matrix1, const Matrix& matrix2);
 
-    std::vector<float> MultiplyOnGpu(
+    Matrix MultiplyOnGpu(
             int numRows1, int numColumns1, int numColumns2,
-            const std::vector<float>& matrix1, const std::vector<float>& matrix2);
+            const Matrix& matrix1, const Matrix& matrix2);
+
+    // Ядро варианта config (опции сборки -DTILE_*); принадлежит объекту
+    cl_kernel GetKernel(const KernelConfig& config);
+    static std::string GetBuildOptions(const KernelConfig& config);
+    // "tiled 16" / "blocked 64x64x16 4x4" - значение в базе настройки и в отчете
+    static std::string FormatConfig(const KernelConfig& config);
+    static bool ParseConfig(const std::string& text, KernelConfig& config);
+    // Рабочая группа помещается в устройство (размер группы и локальная память)
+    [[nodiscard]] bool Fits(const KernelConfig& config) const;
+    static void GetWorkSizes(const KernelConfig& config, int numRows1, int numColumns2,
+                             size_t* globalWorkSize, size_t* localWorkSize);
+    void SetKernelArguments(cl_kernel kernel, int numRows1, int numColumns1, int numColumns2,
+                            cl_mem bufferA, cl_mem bufferB, cl_mem bufferResult);
+    // Вариант из базы настройки для класса размера задачи. Без записи варианты замеряются на уже
+    // загруженных матрицах (по одному TILED и BLOCKED, в режиме --tune - все). Быстрейший пишется в базу
+    // только в режиме --tune, иначе запоминается в объекте: непустая база отключила бы у остальных
+    // ядер быстрый путь EnqueueTunedKernel
+    KernelConfig SelectKernel(cl_command_queue queue, int numRows1, int numColumns1, int numColumns2,
+                              cl_mem bufferA, cl_mem bufferB, cl_mem bufferResult);
 
-    void InitializeOpenCl();
     void ReleaseOpenCl();
-    void PrintMatrixSample(const std::vector<float>& matrix, const std::string& name); // Новая версия
+    void PrintMatrixSample(const Matrix& matrix, const std::string& name); // Новая версия
 
-    cl_device_id m_deviceId = nullptr;
-    cl_context m_context = nullptr;
-    cl_command_queue m_commandQueue = nullptr;
-    cl_program m_program = nullptr;
-    cl_kernel m_kernel = nullptr;
+    std::shared_ptr<OpenCLRuntime> m_runtime;
+    std::map<std::string, cl_kernel> m_kernels; // Опции сборки -> ядро
+    std::map<std::string, KernelConfig> m_untunedConfigs; // Класс размера -> выбор без --tune
 
-    static const int m_tileSize = 16;
     static const std::string m_kernelSource;
-};
\ No newline at end of file
+    static const std::string m_blockedKernelSource;
+};
@@ -2,15 +2,17 @@
 #include "OpenCLUtils.h"
 #include <iostream>
 #include <algorithm> // For std::min, std::max
+#include <stdexcept>
 
 
 const std::string MedianFilter::m_kernelSource = R"CLC(
+// Собирается после m_pixelTypesSource: значения типа Value по -DELEMENT.
 // Простая пузырьковая сортировка для небольшого массива
-void SortWindowSegment(uchar* segment, int count) {
+void SortWindowSegment(Value* segment, int count) {
     for (int i = 0; i < count - 1; ++i) {
         for (int j = 0; j < count - i - 1; ++j) {
             if (segment[j] > segment[j + 1]) {
-                uchar temp = segment[j];
+                Value temp = segment[j];
                 segment[j] = segment[j + 1];
                 segment[j + 1] = temp;
             }
@@ -19,8 +21,8 @@ void SortWindowSegment(uchar* segment, int count) {
 }
 
 __kernel void ApplyMedianFilter(
-    __global const uchar* inputImage,
-    __global uchar* outputImage,
+    __global const Element* inputImage,
+    __global Element* outputImage,
     const int imageWidth,
     const int imageHeight,
     const int numChannels,
@@ -32,9 +34,8 @@ __kernel void ApplyMedianFilter(
     if (globalX >= imageWidth || globalY >= imageHeight) return;
 
     // Максимальный размер окна (2*10+1)*(2*10+1) = 441 для радиуса 10.
-    // Если filterRadius больше, это приведет к проблемам.
-    // Проверка на стороне CPU должна ограничивать filterRadius.
-    uchar windowValues[441]; // Убедитесь, что это достаточно для MAX_KERNEL_SUPPORTED_RADIUS
+    // Большие радиусы хост в это ядро не пускает (см. MAX_SORT_RADIUS): AUTO выбирает для них гистограмму или MedianRadix.
+    Value windowValues[441];
 
     int windowDimension = 2 * filterRadius + 1;
     // int windowPixelCount = windowDimension * windowDimension; // Не используется явно
@@ -48,7 +49,7 @@ __kernel void ApplyMedianFilter(
 
                 int sampleIndex = (sampleY * imageWidth + sampleX) * numChannels + c;
                 if (currentPixelCountInWindow < 441) { // Защита от переполнения windowValues
-                   windowValues[currentPixelCountInWindow++] = inputImage[sampleIndex];
+                   windowValues[currentPixelCountInWindow++] = LOAD_VALUE(sampleIndex, inputImage);
                 }
             }
         }
@@ -57,122 +58,629 @@ __kernel void ApplyMedianFilter(
 
         int outputIndex = (globalY * imageWidth + globalX) * numChannels + c;
         if (currentPixelCountInWindow > 0) {
-            outputImage[outputIndex] = windowValues[currentPixelCountInWindow / 2]; // Медиана
+            // Медиана; EPILOGUE_VALUE - поэлементные операции следующих фильтров (-DPOINT_OPS)
+            Value median = windowValues[currentPixelCountInWindow / 2];
+            STORE_VALUE(TO_VALUE(EPILOGUE_VALUE(VALUE_TO_FLOAT(median), c)), outputIndex, outputImage);
         } else {
             // Этого не должно случиться, если filterRadius >= 0
-             outputImage[outputIndex] = inputImage[outputIndex];
+             STORE_VALUE(LOAD_VALUE(outputIndex, inputImage), outputIndex, outputImage);
         }
     }
 }
 )CLC";
 
-MedianFilter::MedianFilter(int initialRadius)
-        : m_effectRadius(initialRadius)
+const std::string MedianFilter::m_histogramKernelSource = R"CLC(
+// Медиана по гистограмме окна (алгоритм Хуанга). Рабочий элемент ведет один канал одного
+// столбца x на отрезке из rowsPerItem строк: гистограмма окна строится один раз, а при
+// сдвиге на строку вниз из нее вычитается верхняя строка окна и добавляется новая нижняя.
+// Стоимость на пиксель O(r), а не O(r^2 log r), как у сортировки окна; радиус не ограничен.
+// Гистограмма на 256 корзин, поэтому ядро только для 8-битных значений (16 бит - MedianHistogram16).
+__kernel void HistogramMedian(
+    __global const uchar* inputImage,
+    __global uchar* outputImage,
+    const int imageWidth,
+    const int imageHeight,
+    const int numChannels,
+    const int filterRadius,
+    const int rowsPerItem)
+{
+    int x = get_global_id(0);
+    int rowStart = get_global_id(1) * rowsPerItem;
+    int c = get_global_id(2);
+    if (x >= imageWidth || rowStart >= imageHeight) return;
+    int rowEnd = min(rowStart + rowsPerItem, imageHeight);
+
+    uint histogram[256];
+    for (int i = 0; i < 256; ++i) histogram[i] = 0;
+
+    // Окно первой строки отрезка; координаты за краем прижимаются к краю, как в ApplyMedianFilter
+    for (int offsetY = -filterRadius; offsetY <= filterRadius; ++offsetY) {
+        int sampleY = clamp(rowStart + offsetY, 0, imageHeight - 1);
+        for (int offsetX = -filterRadius; offsetX <= filterRadius; ++offsetX) {
+            int sampleX = clamp(x + offsetX, 0, imageWidth - 1);
+            histogram[inputImage[(sampleY * imageWidth + sampleX) * numChannels + c]]++;
+        }
+    }
+
+    // median - текущая медиана, below - сколько значений окна строго меньше нее
+    const uint middle = (uint)((2 * filterRadius + 1) * (2 * filterRadius + 1)) / 2;
+    int median = 0;
+    uint below = 0;
+    while (below + histogram[median] <= middle) below += histogram[median++];
+
+    for (int y = rowStart; ; ++y) {
+        STORE_VALUE(TO_VALUE(EPILOGUE_VALUE((float)median, c)), (y * imageWidth + x) * numChannels + c, outputImage);
+        if (y + 1 >= rowEnd) break;
+
+        // Сдвиг окна вниз: строка y - r уходит, строка y + r + 1 приходит
+        int removedY = clamp(y - filterRadius, 0, imageHeight - 1);
+        int addedY = clamp(y + filterRadius + 1, 0, imageHeight - 1);
+        for (int offsetX = -filterRadius; offsetX <= filterRadius; ++offsetX) {
+            int sampleX = clamp(x + offsetX, 0, imageWidth - 1);
+            uchar removed = inputImage[(removedY * imageWidth + sampleX) * numChannels + c];
+            uchar added = inputImage[(addedY * imageWidth + sampleX) * numChannels + c];
+            histogram[removed]--;
+            histogram[added]++;
+            below -= (removed < median);
+            below += (added < median);
+        }
+
+        // Медиана сдвигается к новому положению, значение за значением
+        while (below > middle) below -= histogram[--median];
+        while (below + histogram[median] <= middle) below += histogram[median++];
+    }
+}
+)CLC";
+
+const std::string MedianFilter::m_keySource = R"CLC(
+// Значения как беззнаковые ключи того же порядка: медиана ключей - ключ медианы значений.
+// StoreKey записывает биты исходного значения обратно, поэтому результат - одно из значений окна.
+#if ELEMENT == 2
+#define KEY_BYTES 2
+// half без cl_khr_fp16 читается как биты: отрицательные - в обратном порядке и ниже положительных
+uint LoadKey(__global const Element* image, int index)
+{
+    uint bits = ((__global const ushort*)image)[index];
+    return (bits & 0x8000u) ? (~bits & 0xFFFFu) : (bits | 0x8000u);
+}
+ushort KeyBits(uint key) { return (ushort)((key & 0x8000u) ? (key & 0x7FFFu) : (~key & 0xFFFFu)); }
+void StoreKey(uint key, __global Element* image, int index) { ((__global ushort*)image)[index] = KeyBits(key); }
+float KeyToFloat(uint key)
+{
+    ushort bits = KeyBits(key);
+    return vload_half(0, (const half*)&bits);
+}
+#elif ELEMENT == 3
+#define KEY_BYTES 4
+uint LoadKey(__global const Element* image, int index)
+{
+    uint bits = as_uint(image[index]);
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+uint KeyBits(uint key) { return (key & 0x80000000u) ? (key & 0x7FFFFFFFu) : ~key; }
+void StoreKey(uint key, __global Element* image, int index) { image[index] = as_float(KeyBits(key)); }
+float KeyToFloat(uint key) { return as_float(KeyBits(key)); }
+#else
+#define KEY_BYTES (ELEMENT + 1) // uchar - 1 байт, ushort - 2
+uint LoadKey(__global const Element* image, int index) { return image[index]; }
+void StoreKey(uint key, __global Element* image, int index) { image[index] = (Element)key; }
+float KeyToFloat(uint key) { return (float)key; }
+#endif
+
+// Запись медианы канала channel: без эпилога - биты исходного значения, с эпилогом (-DPOINT_OPS) -
+// значение после EPILOGUE_VALUE
+#ifdef POINT_OPS
+#define STORE_MEDIAN(key, image, index, channel) STORE_VALUE(TO_VALUE(EPILOGUE_VALUE(KeyToFloat(key), channel)), index, image)
+#else
+#define STORE_MEDIAN(key, image, index, channel) StoreKey(key, image, index)
+#endif
+)CLC";
+
+const std::string MedianFilter::m_radixKernelSource = R"CLC(
+// Поразрядный выбор (radix select) медианы по ключам m_keySource: на каждом уровне окно просматривается
+// целиком и строится гистограмма следующего байта ключа только по значениям с уже найденными старшими
+// байтами. Массива окна нет, поэтому радиус не ограничен, но стоимость на пиксель - KEY_BYTES * (2r+1)^2
+// чтений, как у выбора в окне. AUTO берет это ядро только для float (32-битный ключ не помещается
+// в гистограмму) и для окон больше MedianHistogram16.
+__kernel void MedianRadix(
+    __global const Element* inputImage,
+    __global Element* outputImage,
+    const int imageWidth,
+    const int imageHeight,
+    const int numChannels,
+    const int filterRadius)
 {
-    InitializeOpenCl();
-    m_program = CreateProgramWithSource(m_context, m_deviceId, m_kernelSource);
-    CreateKernel();
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+    int c = get_global_id(2);
+    if (x >= imageWidth || y >= imageHeight) return;
+
+    uint histogram[256];
+    uint prefix = 0; // Найденные старшие байты ключа медианы
+    // Номер медианы среди значений окна с этим префиксом (средний элемент, как в ApplyMedianFilter)
+    uint rank = (uint)((2 * filterRadius + 1) * (2 * filterRadius + 1)) / 2;
+    for (int level = KEY_BYTES - 1; level >= 0; --level) {
+        for (int i = 0; i < 256; ++i) histogram[i] = 0;
+        int shift = level * 8;
+        // Координаты за краем прижимаются к краю, как в остальных ядрах
+        for (int offsetY = -filterRadius; offsetY <= filterRadius; ++offsetY) {
+            int sampleY = clamp(y + offsetY, 0, imageHeight - 1);
+            for (int offsetX = -filterRadius; offsetX <= filterRadius; ++offsetX) {
+                int sampleX = clamp(x + offsetX, 0, imageWidth - 1);
+                uint key = LoadKey(inputImage, (sampleY * imageWidth + sampleX) * numChannels + c);
+                // На старшем уровне префикса еще нет (сдвиг на 32 бита не определен)
+                if (level == KEY_BYTES - 1 || (key >> (shift + 8)) == prefix) histogram[(key >> shift) & 0xFFu]++;
+            }
+        }
+        uint digit = 0;
+        while (rank >= histogram[digit]) rank -= histogram[digit++];
+        prefix = (prefix << 8) | digit;
+    }
+    STORE_MEDIAN(prefix, outputImage, (y * imageWidth + x) * numChannels + c, c);
 }
+)CLC";
 
-MedianFilter::~MedianFilter()
+const std::string MedianFilter::m_histogram16KernelSource = R"CLC(
+// Скользящая двухуровневая гистограмма 16-битных ключей (ushort и half) по схеме Perreault-Hebert:
+// грубая - 256 корзин старшего байта в регистрах, точная - 256 корзин младшего байта для каждой грубой
+// (65536 счетчиков) в глобальном буфере элемента. Элемент, как в HistogramMedian, идет по отрезку столбца:
+// сдвиг окна на строку - 2(2r+1) обновлений, поиск медианы - не больше 256 + 256 корзин, то есть O(r)
+// на пиксель. Начальное окно строится и в конце вычитается обратно за (2r+1)^2 на отрезок, поэтому
+// буфер остается нулевым для следующего элемента и его не нужно очищать.
+#define FINE_BINS 65536
+
+void AddRow(__global const Element* image, int row, int x, int c, int imageWidth, int numChannels, int filterRadius,
+            uint* coarse, __global ushort* fine, int delta)
 {
-    ReleaseOpenCl();
+    for (int offsetX = -filterRadius; offsetX <= filterRadius; ++offsetX) {
+        int sampleX = clamp(x + offsetX, 0, imageWidth - 1);
+        uint key = LoadKey(image, (row * imageWidth + sampleX) * numChannels + c);
+        coarse[key >> 8] += delta;
+        fine[key] += delta;
+    }
 }
 
-void MedianFilter::InitializeOpenCl()
+__kernel void MedianHistogram16(
+    __global const Element* inputImage,
+    __global Element* outputImage,
+    __global ushort* fineHistograms, // FINE_BINS счетчиков на элемент запуска, изначально нули
+    const int imageWidth,
+    const int imageHeight,
+    const int numChannels,
+    const int filterRadius,
+    const int rowsPerItem,
+    const int itemStart)             // Запуск покрывает часть пар (столбец, отрезок), см. EnqueueHistogram16Median
 {
-    cl_int err;
-    cl_uint numPlatforms;
-    err = clGetPlatformIDs(0, nullptr, &numPlatforms);
-    CheckCLError(err, "clGetPlatformIDs (count)");
-    if (numPlatforms == 0) throw std::runtime_error("MedianFilter: No OpenCL platforms found.");
+    int item = itemStart + get_global_id(0);
+    int x = item % imageWidth;
+    int yStart = item / imageWidth * rowsPerItem;
+    int c = get_global_id(1);
+    if (yStart >= imageHeight) return;
+    int yEnd = min(yStart + rowsPerItem, imageHeight);
+    __global ushort* fine = fineHistograms + (size_t)(get_global_id(1) * get_global_size(0) + get_global_id(0)) * FINE_BINS;
 
-    std::vector<cl_platform_id> platforms(numPlatforms);
-    err = clGetPlatformIDs(numPlatforms, platforms.data(), nullptr);
-    CheckCLError(err, "clGetPlatformIDs (list)");
+    uint coarse[256];
+    for (int i = 0; i < 256; ++i) coarse[i] = 0;
+    for (int offsetY = -filterRadius; offsetY <= filterRadius; ++offsetY) {
+        AddRow(inputImage, clamp(yStart + offsetY, 0, imageHeight - 1), x, c, imageWidth, numChannels, filterRadius,
+               coarse, fine, 1);
+    }
 
-    cl_platform_id platform = platforms[0];
-    err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_GPU, 1, &m_deviceId, nullptr);
-    if (err == CL_DEVICE_NOT_FOUND || m_deviceId == nullptr) {
-        err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_CPU, 1, &m_deviceId, nullptr);
-        CheckCLError(err, "clGetDeviceIDs (CPU) for MedianFilter");
-    } else {
-        CheckCLError(err, "clGetDeviceIDs (GPU) for MedianFilter");
+    uint middle = (uint)((2 * filterRadius + 1) * (2 * filterRadius + 1)) / 2;
+    for (int y = yStart; y < yEnd; ++y) {
+        uint rank = middle;
+        uint high = 0;
+        while (rank >= coarse[high]) rank -= coarse[high++];
+        __global const ushort* bins = fine + high * 256;
+        uint low = 0;
+        while (rank >= bins[low]) rank -= bins[low++];
+        STORE_MEDIAN((high << 8) | low, outputImage, (y * imageWidth + x) * numChannels + c, c);
+
+        if (y + 1 == yEnd) break;
+        AddRow(inputImage, clamp(y - filterRadius, 0, imageHeight - 1), x, c, imageWidth, numChannels, filterRadius,
+               coarse, fine, -1);
+        AddRow(inputImage, min(y + filterRadius + 1, imageHeight - 1), x, c, imageWidth, numChannels, filterRadius,
+               coarse, fine, 1);
     }
 
-    m_context = clCreateContext(nullptr, 1, &m_deviceId, nullptr, nullptr, &err);
-    CheckCLError(err, "clCreateContext for MedianFilter");
+    // Окно последней строки вычитается: точная гистограмма снова нулевая
+    for (int offsetY = -filterRadius; offsetY <= filterRadius; ++offsetY) {
+        AddRow(inputImage, clamp(yEnd - 1 + offsetY, 0, imageHeight - 1), x, c, imageWidth, numChannels, filterRadius,
+               coarse, fine, -1);
+    }
+}
+)CLC";
 
-#if defined(CL_VERSION_2_0) && CL_TARGET_OPENCL_VERSION >= 200
-    m_commandQueue = clCreateCommandQueueWithProperties(m_context, m_deviceId, 0, &err);
+const std::string MedianFilter::m_selectSource = R"CLC(
+// Общая часть MedianNetwork и MedianTiled, собирается после m_pixelTypesSource с -DRADIUS,
+// -DCHANNELS=1..4 и -DELEMENT: все каналы пикселя обрабатываются одним векторным min/max, окно в регистрах.
+#define SORT_PAIR(a, b) { Pixel t = min(a, b); b = max(a, b); a = t; }
+#define WINDOW_DIM (2 * RADIUS + 1)
+#define WINDOW_SIZE (WINDOW_DIM * WINDOW_DIM)
+
+// Медиана окна без ветвлений. 3x3 и 5x5 - сети сравнения-обмена Devillard (19 и 99 пар);
+// остальные радиусы - частичная сортировка выбором до середины окна.
+Pixel SelectMedian(Pixel* p)
+{
+#if RADIUS == 1
+    SORT_PAIR(p[1], p[2]); SORT_PAIR(p[4], p[5]); SORT_PAIR(p[7], p[8]);
+    SORT_PAIR(p[0], p[1]); SORT_PAIR(p[3], p[4]); SORT_PAIR(p[6], p[7]);
+    SORT_PAIR(p[1], p[2]); SORT_PAIR(p[4], p[5]); SORT_PAIR(p[7], p[8]);
+    SORT_PAIR(p[0], p[3]); SORT_PAIR(p[5], p[8]); SORT_PAIR(p[4], p[7]);
+    SORT_PAIR(p[3], p[6]); SORT_PAIR(p[1], p[4]); SORT_PAIR(p[2], p[5]);
+    SORT_PAIR(p[4], p[7]); SORT_PAIR(p[4], p[2]); SORT_PAIR(p[6], p[4]);
+    SORT_PAIR(p[4], p[2]);
+#elif RADIUS == 2
+    SORT_PAIR(p[0], p[1]); SORT_PAIR(p[3], p[4]); SORT_PAIR(p[2], p[4]);
+    SORT_PAIR(p[2], p[3]); SORT_PAIR(p[6], p[7]); SORT_PAIR(p[5], p[7]);
+    SORT_PAIR(p[5], p[6]); SORT_PAIR(p[9], p[10]); SORT_PAIR(p[8], p[10]);
+    SORT_PAIR(p[8], p[9]); SORT_PAIR(p[12], p[13]); SORT_PAIR(p[11], p[13]);
+    SORT_PAIR(p[11], p[12]); SORT_PAIR(p[15], p[16]); SORT_PAIR(p[14], p[16]);
+    SORT_PAIR(p[14], p[15]); SORT_PAIR(p[18], p[19]); SORT_PAIR(p[17], p[19]);
+    SORT_PAIR(p[17], p[18]); SORT_PAIR(p[21], p[22]); SORT_PAIR(p[20], p[22]);
+    SORT_PAIR(p[20], p[21]); SORT_PAIR(p[23], p[24]); SORT_PAIR(p[2], p[5]);
+    SORT_PAIR(p[3], p[6]); SORT_PAIR(p[0], p[6]); SORT_PAIR(p[0], p[3]);
+    SORT_PAIR(p[4], p[7]); SORT_PAIR(p[1], p[7]); SORT_PAIR(p[1], p[4]);
+    SORT_PAIR(p[11], p[14]); SORT_PAIR(p[8], p[14]); SORT_PAIR(p[8], p[11]);
+    SORT_PAIR(p[12], p[15]); SORT_PAIR(p[9], p[15]); SORT_PAIR(p[9], p[12]);
+    SORT_PAIR(p[13], p[16]); SORT_PAIR(p[10], p[16]); SORT_PAIR(p[10], p[13]);
+    SORT_PAIR(p[20], p[23]); SORT_PAIR(p[17], p[23]); SORT_PAIR(p[17], p[20]);
+    SORT_PAIR(p[21], p[24]); SORT_PAIR(p[18], p[24]); SORT_PAIR(p[18], p[21]);
+    SORT_PAIR(p[19], p[22]); SORT_PAIR(p[8], p[17]); SORT_PAIR(p[9], p[18]);
+    SORT_PAIR(p[0], p[18]); SORT_PAIR(p[0], p[9]); SORT_PAIR(p[10], p[19]);
+    SORT_PAIR(p[1], p[19]); SORT_PAIR(p[1], p[10]); SORT_PAIR(p[11], p[20]);
+    SORT_PAIR(p[2], p[20]); SORT_PAIR(p[2], p[11]); SORT_PAIR(p[12], p[21]);
+    SORT_PAIR(p[3], p[21]); SORT_PAIR(p[3], p[12]); SORT_PAIR(p[13], p[22]);
+    SORT_PAIR(p[4], p[22]); SORT_PAIR(p[4], p[13]); SORT_PAIR(p[14], p[23]);
+    SORT_PAIR(p[5], p[23]); SORT_PAIR(p[5], p[14]); SORT_PAIR(p[15], p[24]);
+    SORT_PAIR(p[6], p[24]); SORT_PAIR(p[6], p[15]); SORT_PAIR(p[7], p[16]);
+    SORT_PAIR(p[7], p[19]); SORT_PAIR(p[13], p[21]); SORT_PAIR(p[15], p[23]);
+    SORT_PAIR(p[7], p[13]); SORT_PAIR(p[7], p[15]); SORT_PAIR(p[1], p[9]);
+    SORT_PAIR(p[3], p[11]); SORT_PAIR(p[5], p[17]); SORT_PAIR(p[11], p[17]);
+    SORT_PAIR(p[9], p[17]); SORT_PAIR(p[4], p[10]); SORT_PAIR(p[6], p[12]);
+    SORT_PAIR(p[7], p[14]); SORT_PAIR(p[4], p[6]); SORT_PAIR(p[4], p[7]);
+    SORT_PAIR(p[12], p[14]); SORT_PAIR(p[10], p[14]); SORT_PAIR(p[6], p[7]);
+    SORT_PAIR(p[10], p[12]); SORT_PAIR(p[6], p[10]); SORT_PAIR(p[6], p[17]);
+    SORT_PAIR(p[12], p[17]); SORT_PAIR(p[7], p[17]); SORT_PAIR(p[7], p[10]);
+    SORT_PAIR(p[12], p[18]); SORT_PAIR(p[7], p[12]); SORT_PAIR(p[10], p[18]);
+    SORT_PAIR(p[12], p[20]); SORT_PAIR(p[10], p[20]); SORT_PAIR(p[10], p[12]);
 #else
-    m_commandQueue = clCreateCommandQueue(m_context, m_deviceId, 0, &err);
+    for (int i = 0; i <= WINDOW_SIZE / 2; ++i) {
+        for (int j = i + 1; j < WINDOW_SIZE; ++j) SORT_PAIR(p[i], p[j]);
+    }
 #endif
-    CheckCLError(err, "clCreateCommandQueue for MedianFilter");
+    // На своем месте гарантированно только средний элемент
+    return p[WINDOW_SIZE / 2];
 }
+)CLC";
 
-void MedianFilter::CreateKernel() {
-    cl_int err;
-    m_kernel = clCreateKernel(m_program, "ApplyMedianFilter", &err);
-    CheckCLError(err, "clCreateKernel (ApplyMedianFilter)");
+const std::string MedianFilter::m_networkKernelSource = R"CLC(
+__kernel void MedianNetwork(
+    __global const Element* inputImage,
+    __global Element* outputImage,
+    const int imageWidth,
+    const int imageHeight)
+{
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+    if (x >= imageWidth || y >= imageHeight) return;
+
+    Pixel p[WINDOW_SIZE];
+    int i = 0;
+    #pragma unroll
+    for (int offsetY = -RADIUS; offsetY <= RADIUS; ++offsetY) {
+        int sampleY = clamp(y + offsetY, 0, imageHeight - 1);
+        #pragma unroll
+        for (int offsetX = -RADIUS; offsetX <= RADIUS; ++offsetX) {
+            int sampleX = clamp(x + offsetX, 0, imageWidth - 1);
+            p[i++] = LOAD_PIXEL(sampleY * imageWidth + sampleX, inputImage);
+        }
+    }
+    STORE_PIXEL(EPILOGUE_PIXEL(SelectMedian(p)), y * imageWidth + x, outputImage);
 }
+)CLC";
+
+const std::string MedianFilter::m_tiledKernelSource = R"CLC(
+// Рабочая группа TILE_W x TILE_H один раз загружает свой блок с полями по RADIUS в __local,
+// и окна соседних элементов читаются оттуда, а не по (2r+1)^2 раз из глобальной памяти.
+#define LOCAL_W (TILE_W + 2 * RADIUS)
+#define LOCAL_H (TILE_H + 2 * RADIUS)
 
-void MedianFilter::ReleaseOpenCl()
+__kernel __attribute__((reqd_work_group_size(TILE_W, TILE_H, 1)))
+void MedianTiled(
+    __global const Element* inputImage,
+    __global Element* outputImage,
+    const int imageWidth,
+    const int imageHeight)
 {
-    if (m_kernel) clReleaseKernel(m_kernel);
-    if (m_program) clReleaseProgram(m_program);
-    if (m_commandQueue) clReleaseCommandQueue(m_commandQueue);
-    if (m_context) clReleaseContext(m_context);
+    __local Pixel tile[LOCAL_H * LOCAL_W];
+
+    int localX = get_local_id(0);
+    int localY = get_local_id(1);
+    int originX = get_group_id(0) * TILE_W - RADIUS;
+    int originY = get_group_id(1) * TILE_H - RADIUS;
+
+    // Совместная загрузка блока с полями; за краем изображения - прижатие к краю
+    for (int index = localY * TILE_W + localX; index < LOCAL_W * LOCAL_H; index += TILE_W * TILE_H) {
+        int sampleX = clamp(originX + index % LOCAL_W, 0, imageWidth - 1);
+        int sampleY = clamp(originY + index / LOCAL_W, 0, imageHeight - 1);
+        tile[index] = LOAD_PIXEL(sampleY * imageWidth + sampleX, inputImage);
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+    if (x >= imageWidth || y >= imageHeight) return; // Только после барьера: загружают все
+
+    Pixel p[WINDOW_SIZE];
+    int i = 0;
+    #pragma unroll
+    for (int offsetY = 0; offsetY < WINDOW_DIM; ++offsetY) {
+        #pragma unroll
+        for (int offsetX = 0; offsetX < WINDOW_DIM; ++offsetX) {
+            p[i++] = tile[(localY + offsetY) * LOCAL_W + localX + offsetX];
+        }
+    }
+    STORE_PIXEL(EPILOGUE_PIXEL(SelectMedian(p)), y * imageWidth + x, outputImage);
 }
+)CLC";
 
-void MedianFilter::ApplyFilter(std::vector<unsigned char>& imageData, int width, int height, int channels)
+MedianFilter::MedianFilter(int initialRadius)
+        : m_effectRadius(initialRadius)
 {
-    // Радиус 0 для медианного фильтра означает окно 1x1, т.е. без изменений.
-    // Однако, если m_effectRadius = 0, то windowDimension = 1, windowPixelCount = 1.
-    // Это корректно вернет исходный пиксель.
+}
 
-    // Ограничиваем радиус тем, что поддерживает ядро
-    int actualRadius = std::min(m_effectRadius, MAX_KERNEL_SUPPORTED_RADIUS);
-    if (m_effectRadius > MAX_KERNEL_SUPPORTED_RADIUS) {
-        std::cout << "Warning: MedianFilter radius " << m_effectRadius
-                  << " capped at " << MAX_KERNEL_SUPPORTED_RADIUS
-                  << " due to kernel limitations." << std::endl;
-    }
-    if (actualRadius < 0) actualRadius = 0; // Не должно быть, но на всякий случай
+MedianFilter::~MedianFilter() = default;
+
+cl_kernel MedianFilter::GetChannelKernel(const std::string& kernelSource, const std::string& kernelName, int channels,
+                                         ElementType elementType)
+{
+    // Эпилог со swizzle смешивает каналы, а ядро видит только свой: тогда он идет отдельным проходом
+    if (!HasEpilogue() || !AppliesPerValue(GetEpilogue())) return GetKernel(kernelSource, kernelName, PixelBuildOptions(0, elementType));
+    return GetKernel(GetEpilogueSource() + kernelSource, kernelName,
+                     PixelBuildOptions(channels, elementType) + GetEpilogueBuildOptions(channels));
+}
 
+MedianAlgorithm MedianFilter::ResolveAlgorithm(ElementType elementType) const
+{
+    // Скользящая гистограмма есть для 8- и 16-битных ключей; 32-битный ключ float в нее не помещается,
+    // а окно больше 65535 значений не помещается в 16-битные счетчики MedianHistogram16
+    const bool histogramFits = elementType == ElementType::UCHAR ||
+                               (elementType != ElementType::FLOAT && m_effectRadius <= MAX_HISTOGRAM16_RADIUS);
+    if (m_algorithm == MedianAlgorithm::HISTOGRAM && !histogramFits) return MedianAlgorithm::RADIX;
+    if (m_algorithm != MedianAlgorithm::AUTO) return m_algorithm;
+    // Окна до 11x11 - выбор в регистрах из блока в локальной памяти, дальше - гистограмма
+    if (m_effectRadius < HISTOGRAM_RADIUS_THRESHOLD) return MedianAlgorithm::TILED;
+    // Поразрядный выбор растет как r^2, но без ограничения на радиус: только там, где гистограммы нет
+    return histogramFits ? MedianAlgorithm::HISTOGRAM : MedianAlgorithm::RADIX;
+}
 
+void MedianFilter::EnqueueOnDevice(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                                   ElementType elementType)
+{
+    if (m_effectRadius == 0) {
+        EnqueueEpilogue(queue, input, output, width, height, channels, elementType);
+        return;
+    }
+    // Радиус 0 (окно 1x1) не меняет изображение и обработан выше как копирование (или один эпилог).
+    // Эпилог слит с записью медианы во всех ядрах; гистограмма, поразрядный выбор и сортировка ведут
+    // один канал, поэтому эпилог со swizzle после них - проход по месту (см. GetChannelKernel).
+    const bool separateEpilogue = !AppliesPerValue(GetEpilogue());
+    switch (ResolveAlgorithm(elementType)) {
+        case MedianAlgorithm::NETWORK:
+            EnqueueNetworkMedian(queue, input, output, width, height, channels, elementType);
+            return;
+        case MedianAlgorithm::TILED:
+            EnqueueTiledMedian(queue, input, output, width, height, channels, elementType);
+            return;
+        case MedianAlgorithm::HISTOGRAM:
+            if (elementType == ElementType::UCHAR) EnqueueHistogramMedian(queue, input, output, width, height, channels);
+            else EnqueueHistogram16Median(queue, input, output, width, height, channels, elementType);
+            if (separateEpilogue) EnqueueEpilogue(queue, output, output, width, height, channels, elementType);
+            return;
+        case MedianAlgorithm::RADIX:
+            EnqueueRadixMedian(queue, input, output, width, height, channels, elementType);
+            if (separateEpilogue) EnqueueEpilogue(queue, output, output, width, height, channels, elementType);
+            return;
+        default:
+            break;
+    }
+
+    // Сортировка окна (исходное ядро): массив в ядре рассчитан на окно до 21x21
+    if (m_effectRadius > MAX_SORT_RADIUS) {
+        throw std::runtime_error("MedianFilter algo=sort supports radius up to " + std::to_string(MAX_SORT_RADIUS) +
+                                 ", got " + std::to_string(m_effectRadius));
+    }
+    cl_kernel kernel = GetChannelKernel(m_kernelSource, "ApplyMedianFilter", channels, elementType);
     cl_int err;
-    size_t imageSizeBytes = static_cast<size_t>(width) * height * channels * sizeof(unsigned char);
-
-    cl_mem inputBuffer = clCreateBuffer(m_context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
-                                        imageSizeBytes, imageData.data(), &err);
-    CheckCLError(err, "MedianFilter clCreateBuffer (inputBuffer)");
-    cl_mem outputBuffer = clCreateBuffer(m_context, CL_MEM_WRITE_ONLY,
-                                         imageSizeBytes, nullptr, &err);
-    CheckCLError(err, "MedianFilter clCreateBuffer (outputBuffer)");
-
-    err = clSetKernelArg(m_kernel, 0, sizeof(cl_mem), &inputBuffer); CheckCLError(err, "Median SetArg 0");
-    err = clSetKernelArg(m_kernel, 1, sizeof(cl_mem), &outputBuffer); CheckCLError(err, "Median SetArg 1");
-    err = clSetKernelArg(m_kernel, 2, sizeof(int), &width); CheckCLError(err, "Median SetArg 2");
-    err = clSetKernelArg(m_kernel, 3, sizeof(int), &height); CheckCLError(err, "Median SetArg 3");
-    err = clSetKernelArg(m_kernel, 4, sizeof(int), &channels); CheckCLError(err, "Median SetArg 4");
-    err = clSetKernelArg(m_kernel, 5, sizeof(int), &actualRadius); CheckCLError(err, "Median SetArg 5");
+    err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &input); CheckCLError(err, "Median SetArg 0");
+    err = clSetKernelArg(kernel, 1, sizeof(cl_mem), &output); CheckCLError(err, "Median SetArg 1");
+    err = clSetKernelArg(kernel, 2, sizeof(int), &width); CheckCLError(err, "Median SetArg 2");
+    err = clSetKernelArg(kernel, 3, sizeof(int), &height); CheckCLError(err, "Median SetArg 3");
+    err = clSetKernelArg(kernel, 4, sizeof(int), &channels); CheckCLError(err, "Median SetArg 4");
+    err = clSetKernelArg(kernel, 5, sizeof(int), &m_effectRadius); CheckCLError(err, "Median SetArg 5");
 
     size_t globalWorkSize[2] = {static_cast<size_t>(width), static_cast<size_t>(height)};
-    err = clEnqueueNDRangeKernel(m_commandQueue, m_kernel, 2, nullptr, globalWorkSize, nullptr, 0, nullptr, nullptr);
+    err = m_runtime->EnqueueTunedKernel(queue, kernel, 2, globalWorkSize,
+                                        m_runtime->GetProfiler().Track("Median", ProfileCategory::COMPUTE));
     CheckCLError(err, "MedianFilter clEnqueueNDRangeKernel");
+    if (separateEpilogue) EnqueueEpilogue(queue, output, output, width, height, channels, elementType);
+}
 
-    err = clEnqueueReadBuffer(m_commandQueue, outputBuffer, CL_TRUE, 0,
-                              imageSizeBytes, imageData.data(), 0, nullptr, nullptr);
-    CheckCLError(err, "MedianFilter clEnqueueReadBuffer");
+void MedianFilter::EnqueueNetworkMedian(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                                        ElementType elementType)
+{
+    // Программа собирается под конкретные радиус, каналы и тип значения
+    const std::string buildOptions = "-DRADIUS=" + std::to_string(m_effectRadius) + " " + PixelBuildOptions(channels, elementType) +
+                                     GetEpilogueBuildOptions(channels);
+    cl_kernel kernel = GetKernel(GetEpilogueSource() + m_selectSource + m_networkKernelSource, "MedianNetwork", buildOptions);
+    cl_int err;
+    err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &input); CheckCLError(err, "MedianNetwork SetArg 0");
+    err = clSetKernelArg(kernel, 1, sizeof(cl_mem), &output); CheckCLError(err, "MedianNetwork SetArg 1");
+    err = clSetKernelArg(kernel, 2, sizeof(int), &width); CheckCLError(err, "MedianNetwork SetArg 2");
+    err = clSetKernelArg(kernel, 3, sizeof(int), &height); CheckCLError(err, "MedianNetwork SetArg 3");
+
+    size_t globalWorkSize[2] = {static_cast<size_t>(width), static_cast<size_t>(height)};
+    err = m_runtime->EnqueueTunedKernel(queue, kernel, 2, globalWorkSize,
+                                        m_runtime->GetProfiler().Track("Median network", ProfileCategory::COMPUTE));
+    CheckCLError(err, "MedianFilter clEnqueueNDRangeKernel (MedianNetwork)");
+}
+
+void MedianFilter::EnqueueTiledMedian(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                                      ElementType elementType)
+{
+    // 16x16 = 256 элементов поддерживает почти любое устройство; иначе блок 8x8
+    const OpenCLDeviceInfo& device = m_runtime->GetDeviceInfo();
+    const int tileSize = device.maxWorkGroupSize >= 256 ? 16 : 8;
+    const size_t pixelBytes = PixelStorageBytes(channels, elementType);
+    const size_t localDim = tileSize + 2 * static_cast<size_t>(m_effectRadius);
+    if (localDim * localDim * pixelBytes > device.localMemBytes) {
+        throw std::runtime_error("MedianFilter algo=tiled: radius " + std::to_string(m_effectRadius) +
+                                 " does not fit into local memory, use algo=histogram or algo=radix");
+    }
 
-    clFinish(m_commandQueue);
+    const std::string buildOptions = "-DRADIUS=" + std::to_string(m_effectRadius) + " " + PixelBuildOptions(channels, elementType) +
+                                     " -DTILE_W=" + std::to_string(tileSize) + " -DTILE_H=" + std::to_string(tileSize) +
+                                     GetEpilogueBuildOptions(channels);
+    cl_kernel kernel = GetKernel(GetEpilogueSource() + m_selectSource + m_tiledKernelSource, "MedianTiled", buildOptions);
 
-    clReleaseMemObject(inputBuffer);
-    clReleaseMemObject(outputBuffer);
+    cl_int err;
+    err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &input); CheckCLError(err, "MedianTiled SetArg 0");
+    err = clSetKernelArg(kernel, 1, sizeof(cl_mem), &output); CheckCLError(err, "MedianTiled SetArg 1");
+    err = clSetKernelArg(kernel, 2, sizeof(int), &width); CheckCLError(err, "MedianTiled SetArg 2");
+    err = clSetKernelArg(kernel, 3, sizeof(int), &height); CheckCLError(err, "MedianTiled SetArg 3");
+
+    // Глобальный размер кратен блоку, лишние элементы на краю только помогают загрузить блок
+    size_t localWorkSize[2] = {static_cast<size_t>(tileSize), static_cast<size_t>(tileSize)};
+    size_t globalWorkSize[2] = {
+            static_cast<size_t>((width + tileSize - 1) / tileSize * tileSize),
+            static_cast<size_t>((height + tileSize - 1) / tileSize * tileSize)
+    };
+    err = clEnqueueNDRangeKernel(queue, kernel, 2, nullptr, globalWorkSize, localWorkSize, 0, nullptr,
+                                 m_runtime->GetProfiler().Track("Median tiled", ProfileCategory::COMPUTE));
+    CheckCLError(err, "MedianFilter clEnqueueNDRangeKernel (MedianTiled)");
+}
+
+void MedianFilter::EnqueueHistogramMedian(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels)
+{
+    // Построение гистограммы стоит (2r+1)^2, сдвиг на строку - 2(2r+1). Отрезок в несколько
+    // размеров окна делает начальное построение не дороже самого прохода.
+    int windowDimension = 2 * m_effectRadius + 1;
+    int rowsPerItem = std::max(32, 2 * windowDimension);
+
+    cl_kernel kernel = GetChannelKernel(m_histogramKernelSource, "HistogramMedian", channels, ElementType::UCHAR);
+    cl_int err;
+    err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &input); CheckCLError(err, "HistogramMedian SetArg 0");
+    err = clSetKernelArg(kernel, 1, sizeof(cl_mem), &output); CheckCLError(err, "HistogramMedian SetArg 1");
+    err = clSetKernelArg(kernel, 2, sizeof(int), &width); CheckCLError(err, "HistogramMedian SetArg 2");
+    err = clSetKernelArg(kernel, 3, sizeof(int), &height); CheckCLError(err, "HistogramMedian SetArg 3");
+    err = clSetKernelArg(kernel, 4, sizeof(int), &channels); CheckCLError(err, "HistogramMedian SetArg 4");
+    err = clSetKernelArg(kernel, 5, sizeof(int), &m_effectRadius); CheckCLError(err, "HistogramMedian SetArg 5");
+    err = clSetKernelArg(kernel, 6, sizeof(int), &rowsPerItem); CheckCLError(err, "HistogramMedian SetArg 6");
+
+    size_t globalWorkSize[3] = {
+            static_cast<size_t>(width),
+            static_cast<size_t>((height + rowsPerItem - 1) / rowsPerItem),
+            static_cast<size_t>(channels)
+    };
+    err = m_runtime->EnqueueTunedKernel(queue, kernel, 3, globalWorkSize,
+                                        m_runtime->GetProfiler().Track("Median histogram", ProfileCategory::COMPUTE));
+    CheckCLError(err, "MedianFilter clEnqueueNDRangeKernel (HistogramMedian)");
+}
+
+void MedianFilter::EnqueueRadixMedian(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                                      ElementType elementType)
+{
+    // Один элемент на пиксель и канал; число проходов по окну - байты ключа (1, 2 или 4)
+    cl_kernel kernel = GetChannelKernel(m_keySource + m_radixKernelSource, "MedianRadix", channels, elementType);
+    cl_int err;
+    err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &input); CheckCLError(err, "MedianRadix SetArg 0");
+    err = clSetKernelArg(kernel, 1, sizeof(cl_mem), &output); CheckCLError(err, "MedianRadix SetArg 1");
+    err = clSetKernelArg(kernel, 2, sizeof(int), &width); CheckCLError(err, "MedianRadix SetArg 2");
+    err = clSetKernelArg(kernel, 3, sizeof(int), &height); CheckCLError(err, "MedianRadix SetArg 3");
+    err = clSetKernelArg(kernel, 4, sizeof(int), &channels); CheckCLError(err, "MedianRadix SetArg 4");
+    err = clSetKernelArg(kernel, 5, sizeof(int), &m_effectRadius); CheckCLError(err, "MedianRadix SetArg 5");
+
+    size_t globalWorkSize[3] = {static_cast<size_t>(width), static_cast<size_t>(height), static_cast<size_t>(channels)};
+    err = m_runtime->EnqueueTunedKernel(queue, kernel, 3, globalWorkSize,
+                                        m_runtime->GetProfiler().Track("Median radix", ProfileCategory::COMPUTE));
+    CheckCLError(err, "MedianFilter clEnqueueNDRangeKernel (MedianRadix)");
+}
+
+int MedianFilter::GetHistogram16RowsPerItem() const
+{
+    // Как в EnqueueHistogramMedian: построение и вычитание окна на отрезок не дороже самого прохода
+    return std::max(32, 2 * (2 * m_effectRadius + 1));
+}
+
+size_t MedianFilter::GetHistogram16LaunchItems(int width, int height, int channels) const
+{
+    // Элемент - пара (столбец, отрезок); запуск ограничен буфером точных гистограмм
+    const int rowsPerItem = GetHistogram16RowsPerItem();
+    const size_t items = static_cast<size_t>(width) * ((height + rowsPerItem - 1) / rowsPerItem);
+    const size_t budgetItems = std::max<size_t>(1, HISTOGRAM16_SCRATCH_BUDGET / (static_cast<size_t>(channels) * HISTOGRAM16_ITEM_BYTES));
+    return std::min(items, budgetItems);
+}
+
+void MedianFilter::EnqueueHistogram16Median(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height,
+                                            int channels, ElementType elementType)
+{
+    const int rowsPerItem = GetHistogram16RowsPerItem();
+    const int totalItems = width * ((height + rowsPerItem - 1) / rowsPerItem);
+    const size_t launchItems = GetHistogram16LaunchItems(width, height, channels);
+    const size_t scratchBytes = launchItems * channels * HISTOGRAM16_ITEM_BYTES;
+
+    // Буфер обнуляется один раз: каждый элемент возвращает свои счетчики в ноль.
+    // Очередь упорядочена, поэтому запуски по частям работают с одним буфером по очереди
+    PooledBuffer histogramsBuffer(m_runtime->GetBufferPool(), scratchBytes);
+    const cl_uint zero = 0;
+    cl_int err = clEnqueueFillBuffer(queue, histogramsBuffer.Get(), &zero, sizeof(zero), 0, scratchBytes, 0, nullptr,
+                                     m_runtime->GetProfiler().Track("Median histogram16 clear", ProfileCategory::COMPUTE));
+    CheckCLError(err, "MedianFilter clEnqueueFillBuffer (MedianHistogram16)");
+
+    cl_kernel kernel = GetChannelKernel(m_keySource + m_histogram16KernelSource, "MedianHistogram16", channels, elementType);
+    err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &input); CheckCLError(err, "MedianHistogram16 SetArg 0");
+    err = clSetKernelArg(kernel, 1, sizeof(cl_mem), &output); CheckCLError(err, "MedianHistogram16 SetArg 1");
+    err = clSetKernelArg(kernel, 2, sizeof(cl_mem), histogramsBuffer.GetPtr()); CheckCLError(err, "MedianHistogram16 SetArg 2");
+    err = clSetKernelArg(kernel, 3, sizeof(int), &width); CheckCLError(err, "MedianHistogram16 SetArg 3");
+    err = clSetKernelArg(kernel, 4, sizeof(int), &height); CheckCLError(err, "MedianHistogram16 SetArg 4");
+    err = clSetKernelArg(kernel, 5, sizeof(int), &channels); CheckCLError(err, "MedianHistogram16 SetArg 5");
+    err = clSetKernelArg(kernel, 6, sizeof(int), &m_effectRadius); CheckCLError(err, "MedianHistogram16 SetArg 6");
+    err = clSetKernelArg(kernel, 7, sizeof(int), &rowsPerItem); CheckCLError(err, "MedianHistogram16 SetArg 7");
+
+    for (int itemStart = 0; itemStart < totalItems; itemStart += static_cast<int>(launchItems)) {
+        err = clSetKernelArg(kernel, 8, sizeof(int), &itemStart); CheckCLError(err, "MedianHistogram16 SetArg 8");
+        // Последний запуск короче
+        size_t globalWorkSize[2] = {std::min(launchItems, static_cast<size_t>(totalItems - itemStart)), static_cast<size_t>(channels)};
+        err = m_runtime->EnqueueTunedKernel(queue, kernel, 2, globalWorkSize,
+                                            m_runtime->GetProfiler().Track("Median histogram16", ProfileCategory::COMPUTE));
+        CheckCLError(err, "MedianFilter clEnqueueNDRangeKernel (MedianHistogram16)");
+    }
+    histogramsBuffer.ResetAfter(queue);
+}
+
+size_t MedianFilter::GetScratchBytes(int width, int rows, int channels, ElementType elementType) const
+{
+    if (IsIdentity() || elementType == ElementType::UCHAR || ResolveAlgorithm(elementType) != MedianAlgorithm::HISTOGRAM) return 0;
+    return GetHistogram16LaunchItems(width, rows, channels) * channels * HISTOGRAM16_ITEM_BYTES;
 }
 
 void MedianFilter::SetEffectRadius(int radius)
 {
     m_effectRadius = std::max(0, radius);
+}
+
+void MedianFilter::SetOption(const std::string& key, const std::string& value)
+{
+    if (key != "algo") {
+        OpenCLImageFilter::SetOption(key, value);
+        return;
+    }
+    if (value == "auto") m_algorithm = MedianAlgorithm::AUTO;
+    else if (value == "sort") m_algorithm = MedianAlgorithm::SORT;
+    else if (value == "network") m_algorithm = MedianAlgorithm::NETWORK;
+    else if (value == "tiled") m_algorithm = MedianAlgorithm::TILED;
+    else if (value == "histogram") m_algorithm = MedianAlgorithm::HISTOGRAM;
+    else if (value == "radix") m_algorithm = MedianAlgorithm::RADIX;
+    else throw std::runtime_error("Unknown median algo '" + value + "' (auto, sort, network, tiled, histogram, radix)");
 }
\ No newline at end of file
@@ -1,33 +1,75 @@
 #pragma once
-#include "IImageFilter.h"
+#include "OpenCLImageFilter.h"
 #include <CL/cl.h>
 #include <string>
 #include <vector>
 
-class MedianFilter : public IImageFilter
+enum class MedianAlgorithm
+{
+    AUTO,      // По радиусу: TILED до HISTOGRAM_RADIUS_THRESHOLD, дальше HISTOGRAM, где она есть, иначе RADIX
+    SORT,      // Исходное ядро: сортировка окна каждого канала в глобальной памяти
+    NETWORK,   // Векторный выбор медианы, окно читается из глобальной памяти
+    TILED,     // То же, но окна берутся из блока в локальной памяти
+    HISTOGRAM, // Скользящая гистограмма, O(r) на пиксель: 8 бит - одна, ushort и half - двухуровневая
+               // до MAX_HISTOGRAM16_RADIUS; float и большие окна идут в RADIX
+    RADIX      // Поразрядный выбор по байтам ключа: любой тип и радиус, но O(r^2) на пиксель
+};
+
+class MedianFilter : public OpenCLImageFilter
 {
 public:
     MedianFilter(int initialRadius);
     ~MedianFilter() override;
 
-    void ApplyFilter(std::vector<unsigned char>& imageData, int width, int height, int channels) override;
+    void EnqueueOnDevice(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                         ElementType elementType) override;
     void SetEffectRadius(int radius) override;
+    [[nodiscard]] int GetHaloRows() const override { return m_effectRadius; }
+    // Буфер точных гистограмм MedianHistogram16 (ushort и half с algo=histogram или AUTO)
+    [[nodiscard]] size_t GetScratchBytes(int width, int rows, int channels, ElementType elementType) const override;
+    // "algo": auto | sort | network | tiled | histogram | radix
+    void SetOption(const std::string& key, const std::string& value) override;
     std::string GetName() const override { return "Median Filter"; }
+    [[nodiscard]] bool IsIdentity() const override { return m_effectRadius == 0 && !HasEpilogue(); }
+    [[nodiscard]] bool SupportsEpilogue() const override { return true; }
 
 private:
-    void InitializeOpenCl();
-    void ReleaseOpenCl();
-    void CreateKernel();
+    // Ядро, которое ведет один канал (гистограмма, поразрядный выбор, сортировка). Эпилог без swizzle
+    // собирается в него (EPILOGUE_VALUE при записи медианы), со swizzle - нет, и идет отдельным проходом
+    cl_kernel GetChannelKernel(const std::string& kernelSource, const std::string& kernelName, int channels,
+                               ElementType elementType);
+    // HISTOGRAM без подходящей гистограммы (float, окно больше 65535 значений) заменяется на RADIX,
+    // у которого нет ограничения на радиус (SORT - только до MAX_SORT_RADIUS)
+    [[nodiscard]] MedianAlgorithm ResolveAlgorithm(ElementType elementType) const;
+    void EnqueueNetworkMedian(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                              ElementType elementType);
+    void EnqueueTiledMedian(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                            ElementType elementType);
+    void EnqueueHistogramMedian(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels);
+    void EnqueueHistogram16Median(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                                  ElementType elementType);
+    [[nodiscard]] int GetHistogram16RowsPerItem() const;
+    [[nodiscard]] size_t GetHistogram16LaunchItems(int width, int height, int channels) const;
+    void EnqueueRadixMedian(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                            ElementType elementType);
 
     int m_effectRadius;
-    static constexpr int MAX_KERNEL_SUPPORTED_RADIUS = 10;
-
+    MedianAlgorithm m_algorithm = MedianAlgorithm::AUTO;
+    // Начиная с этого радиуса выбор в окне дороже гистограммы (O(r^2) и больше против O(r))
+    static constexpr int HISTOGRAM_RADIUS_THRESHOLD = 6;
+    static constexpr int MAX_SORT_RADIUS = 10; // Размер массива окна в ApplyMedianFilter
+    // Счетчики MedianHistogram16 - ushort: окно (2r+1)^2 не больше 65535 значений
+    static constexpr int MAX_HISTOGRAM16_RADIUS = 127;
+    static constexpr size_t HISTOGRAM16_ITEM_BYTES = 65536 * sizeof(unsigned short); // Точная гистограмма элемента
+    static constexpr size_t HISTOGRAM16_SCRATCH_BUDGET = size_t(64) << 20;         // Гистограммы одного запуска
 
-    cl_device_id m_deviceId = nullptr;
-    cl_context m_context = nullptr;
-    cl_command_queue m_commandQueue = nullptr;
-    cl_program m_program = nullptr;
-    cl_kernel m_kernel = nullptr;
 
     static const std::string m_kernelSource;
+    static const std::string m_histogramKernelSource;
+    static const std::string m_keySource;
+    static const std::string m_radixKernelSource;
+    static const std::string m_histogram16KernelSource;
+    static const std::string m_selectSource;
+    static const std::string m_networkKernelSource;
+    static const std::string m_tiledKernelSource;
 };
\ No newline at end of file
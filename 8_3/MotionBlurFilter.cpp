@@ -1,12 +1,16 @@
 #include "MotionBlurFilter.h"
+#include "MotionBlurGeometry.h"
 #include "OpenCLUtils.h"
 #include <iostream>
 #include <algorithm> // For std::max
+#include <sstream>
+#include <stdexcept>
 
 const std::string MotionBlurFilter::m_kernelSource = R"CLC(
+// Собирается после m_pixelTypesSource: значения типа Element по -DELEMENT
 __kernel void ApplyMotionBlur(
-    __global const uchar* inputImage,
-    __global uchar* outputImage,
+    __global const Element* inputImage,
+    __global Element* outputImage,
     const int imageWidth,
     const int imageHeight,
     const int numChannels,
@@ -38,117 +42,255 @@ __kernel void ApplyMotionBlur(
             int sampleX = clamp(globalX + offset, 0, imageWidth - 1);
             int sampleIndex = (globalY * imageWidth + sampleX) * numChannels + c;
 
-            accumulatedColor += (float)inputImage[sampleIndex];
+            accumulatedColor += VALUE_TO_FLOAT(LOAD_VALUE(sampleIndex, inputImage));
             samplesCount++;
         }
 
         int outputIndex = (globalY * imageWidth + globalX) * numChannels + c;
         if (samplesCount > 0) {
-            outputImage[outputIndex] = (uchar)(accumulatedColor / samplesCount);
+            // Отбрасывание дробной части, как приведение (uchar) в исходном 8-битном ядре
+            STORE_VALUE(TO_VALUE_RTZ(accumulatedColor / samplesCount), outputIndex, outputImage);
         } else {
             // Это может случиться, если blurLength = 0
-            outputImage[outputIndex] = inputImage[outputIndex];
+            STORE_VALUE(LOAD_VALUE(outputIndex, inputImage), outputIndex, outputImage);
         }
     }
 }
 )CLC";
 
-MotionBlurFilter::MotionBlurFilter(int initialBlurLength)
-        : m_blurLength(initialBlurLength)
+const std::string MotionBlurFilter::m_runningSumKernelSource = R"CLC(
+// Размытие вдоль наклонных линий через сдвиг (shear), геометрия - в MotionBlurGeometry.h.
+// Для почти горизонтального направления major - это x, для почти вертикального - y; шаги по осям
+// в пикселях задают majorStride/minorStride. Изображение обходится блоками: MotionLines считает
+// скользящие суммы линий блока с шагом 1 / phases пикселя, MotionResample интерполирует каждый пиксель
+// между двумя линиями, ближайшими к его собственной.
+// sum[c] += sign * значение канала c между minor0 и minor0 + 1 с весом weight
+void AddSample(__global const Element* image, int major, int minor0, float weight, int minorLength,
+               int majorStride, int minorStride, int numChannels, float sign, float* sum)
 {
-    InitializeOpenCl();
-    m_program = CreateProgramWithSource(m_context, m_deviceId, m_kernelSource);
-    CreateKernel();
+    int minor1 = clamp(minor0 + 1, 0, minorLength - 1);
+    minor0 = clamp(minor0, 0, minorLength - 1);
+    int index0 = (major * majorStride + minor0 * minorStride) * numChannels;
+    int index1 = (major * majorStride + minor1 * minorStride) * numChannels;
+    for (int c = 0; c < numChannels; ++c) {
+        sum[c] += sign * mix(VALUE_TO_FLOAT(LOAD_VALUE(index0 + c, image)), VALUE_TO_FLOAT(LOAD_VALUE(index1 + c, image)), weight);
+    }
 }
 
-MotionBlurFilter::~MotionBlurFilter()
+// Точка линии line на основной оси: minor = minorBase + line / phases + lineBaseFrac + (line % phases) / phases
+// + (major - majorStart) * slope
+void AddLineSample(__global const Element* image, int major, int line, int phases, int majorStart, int minorBase, float lineBaseFrac,
+                   float slope, int minorLength, int majorStride, int minorStride, int numChannels, float sign, float* sum)
 {
-    ReleaseOpenCl();
+    float position = lineBaseFrac + (float)(line % phases) / (float)phases + (float)(major - majorStart) * slope;
+    float whole = floor(position);
+    AddSample(image, major, minorBase + line / phases + (int)whole, position - whole, minorLength, majorStride, minorStride,
+              numChannels, sign, sum);
 }
 
-void MotionBlurFilter::InitializeOpenCl()
+__kernel void MotionLines(
+    __global const Element* inputImage,
+    __global float* lines, // lineCount x bandLength x 4 (каналы, выровнено до 4)
+    const int majorLength,
+    const int minorLength,
+    const int majorStride,
+    const int minorStride,
+    const int numChannels,
+    const float slope, // Смещение по minor на один шаг по major (|slope| <= 1)
+    const int windowStart, // Окно [i + windowStart, i + windowEnd] вдоль линии
+    const int windowEnd,
+    const int majorStart, // Блок по основной оси: [majorStart, majorStart + bandLength)
+    const int bandLength,
+    const int minorBase, // minorStart + lineBaseInt
+    const float lineBaseFrac,
+    const int lineCount,
+    const int phases) // Линий на пиксель по minor
 {
-    cl_int err;
-    cl_uint numPlatforms;
-    err = clGetPlatformIDs(0, nullptr, &numPlatforms);
-    CheckCLError(err, "clGetPlatformIDs (count)");
-    if (numPlatforms == 0) throw std::runtime_error("MotionBlurFilter: No OpenCL platforms found.");
-
-    std::vector<cl_platform_id> platforms(numPlatforms);
-    err = clGetPlatformIDs(numPlatforms, platforms.data(), nullptr);
-    CheckCLError(err, "clGetPlatformIDs (list)");
-
-    cl_platform_id platform = platforms[0];
-    err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_GPU, 1, &m_deviceId, nullptr);
-    if (err == CL_DEVICE_NOT_FOUND || m_deviceId == nullptr) {
-        err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_CPU, 1, &m_deviceId, nullptr);
-        CheckCLError(err, "clGetDeviceIDs (CPU) for MotionBlur");
-    } else {
-        CheckCLError(err, "clGetDeviceIDs (GPU) for MotionBlur");
-    }
+    int line = get_global_id(0);
+    if (line >= lineCount) return;
 
-    m_context = clCreateContext(nullptr, 1, &m_deviceId, nullptr, nullptr, &err);
-    CheckCLError(err, "clCreateContext for MotionBlur");
+    float sum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    for (int offset = windowStart; offset <= windowEnd; ++offset) {
+        int major = clamp(majorStart + offset, 0, majorLength - 1);
+        AddLineSample(inputImage, major, line, phases, majorStart, minorBase, lineBaseFrac, slope, minorLength, majorStride, minorStride, numChannels, 1.0f, sum);
+    }
 
-#if defined(CL_VERSION_2_0) && CL_TARGET_OPENCL_VERSION >= 200
-    m_commandQueue = clCreateCommandQueueWithProperties(m_context, m_deviceId, 0, &err);
-#else
-    m_commandQueue = clCreateCommandQueue(m_context, m_deviceId, 0, &err);
-#endif
-    CheckCLError(err, "clCreateCommandQueue for MotionBlur");
+    float scale = 1.0f / (windowEnd - windowStart + 1);
+    for (int i = 0; i < bandLength; ++i) {
+        vstore4((float4)(sum[0], sum[1], sum[2], sum[3]) * scale, line * bandLength + i, lines);
+        if (i + 1 == bandLength) break;
+        int major = majorStart + i;
+        int added = min(major + windowEnd + 1, majorLength - 1);
+        int removed = clamp(major + windowStart, 0, majorLength - 1);
+        AddLineSample(inputImage, added, line, phases, majorStart, minorBase, lineBaseFrac, slope, minorLength, majorStride, minorStride, numChannels, 1.0f, sum);
+        AddLineSample(inputImage, removed, line, phases, majorStart, minorBase, lineBaseFrac, slope, minorLength, majorStride, minorStride, numChannels, -1.0f, sum);
+    }
 }
 
-void MotionBlurFilter::CreateKernel() {
-    cl_int err;
-    m_kernel = clCreateKernel(m_program, "ApplyMotionBlur", &err);
-    CheckCLError(err, "clCreateKernel (ApplyMotionBlur)");
+// Обратный сдвиг: пиксель блока (i, j) лежит между двумя соседними линиями сетки с шагом 1 / phases
+__kernel void MotionResample(
+    __global const float* lines,
+    __global Element* outputImage,
+    const int majorStride,
+    const int minorStride,
+    const int numChannels,
+    const float slope,
+    const int majorStart,
+    const int bandLength,
+    const int minorStart,
+    const int blockMinorLength,
+    const int lineBaseInt,
+    const float lineBaseFrac,
+    const int lineCount,
+    const int phases)
+{
+    int i = get_global_id(0);
+    int j = get_global_id(1);
+    if (i >= bandLength || j >= blockMinorLength) return;
+
+    // Линия t проходит через j = lineBaseInt + t / phases + position, то же выражение, что в AddLineSample
+    float position = lineBaseFrac + (float)i * slope;
+    float whole = floor(position);
+    float scaled = (position - whole) * (float)phases; // Дробная часть в шагах линий
+    float upper = ceil(scaled);
+    int line0 = (j - lineBaseInt - (int)whole) * phases - (int)upper;
+    float weight = upper - scaled;
+    line0 = clamp(line0, 0, lineCount - 2); // Ошибка округления не должна увести за линии блока
+    float4 value = mix(vload4(line0 * bandLength + i, lines), vload4((line0 + 1) * bandLength + i, lines), weight);
+    float channelValues[4] = {value.x, value.y, value.z, value.w};
+
+    int outputIndex = ((majorStart + i) * majorStride + (minorStart + j) * minorStride) * numChannels;
+    for (int c = 0; c < numChannels; ++c) STORE_VALUE(TO_VALUE(channelValues[c]), outputIndex + c, outputImage);
 }
+)CLC";
 
-void MotionBlurFilter::ReleaseOpenCl()
+MotionBlurFilter::MotionBlurFilter(int initialBlurLength)
+        : m_blurLength(initialBlurLength)
 {
-    if (m_kernel) clReleaseKernel(m_kernel);
-    if (m_program) clReleaseProgram(m_program);
-    if (m_commandQueue) clReleaseCommandQueue(m_commandQueue);
-    if (m_context) clReleaseContext(m_context);
 }
 
-void MotionBlurFilter::ApplyFilter(std::vector<unsigned char>& imageData, int width, int height, int channels)
+void MotionBlurFilter::EnqueueOnDevice(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                                       ElementType elementType)
 {
-    if (m_blurLength <= 0) return; // Длина 0 или 1 обычно означает отсутствие эффекта или минимальный.
-    // Если m_blurLength = 1, ядро возьмет только текущий пиксель.
+    if (IsIdentity()) {
+        EnqueueCopy(queue, input, output, width, height, channels, elementType);
+        return;
+    }
+    if (m_algorithm == MotionBlurAlgorithm::RUNNING_SUM) {
+        EnqueueRunningSum(queue, input, output, width, height, channels, elementType);
+        return;
+    }
+    if (m_angleDegrees != 0.0f) {
+        throw std::runtime_error("Motion blur algo 'direct' is horizontal only; use algo=running for angle != 0");
+    }
 
+    // Ядра собираются под тип значения при первом изображении с ним
+    cl_kernel kernel = GetKernel(m_kernelSource, "ApplyMotionBlur", PixelBuildOptions(0, elementType));
     cl_int err;
-    size_t imageSizeBytes = static_cast<size_t>(width) * height * channels * sizeof(unsigned char);
-
-    cl_mem inputBuffer = clCreateBuffer(m_context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
-                                        imageSizeBytes, imageData.data(), &err);
-    CheckCLError(err, "MotionBlur clCreateBuffer (inputBuffer)");
-    cl_mem outputBuffer = clCreateBuffer(m_context, CL_MEM_WRITE_ONLY,
-                                         imageSizeBytes, nullptr, &err);
-    CheckCLError(err, "MotionBlur clCreateBuffer (outputBuffer)");
-
-    err = clSetKernelArg(m_kernel, 0, sizeof(cl_mem), &inputBuffer); CheckCLError(err, "MotionBlur SetArg 0");
-    err = clSetKernelArg(m_kernel, 1, sizeof(cl_mem), &outputBuffer); CheckCLError(err, "MotionBlur SetArg 1");
-    err = clSetKernelArg(m_kernel, 2, sizeof(int), &width); CheckCLError(err, "MotionBlur SetArg 2");
-    err = clSetKernelArg(m_kernel, 3, sizeof(int), &height); CheckCLError(err, "MotionBlur SetArg 3");
-    err = clSetKernelArg(m_kernel, 4, sizeof(int), &channels); CheckCLError(err, "MotionBlur SetArg 4");
-    err = clSetKernelArg(m_kernel, 5, sizeof(int), &m_blurLength); CheckCLError(err, "MotionBlur SetArg 5");
+    err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &input); CheckCLError(err, "MotionBlur SetArg 0");
+    err = clSetKernelArg(kernel, 1, sizeof(cl_mem), &output); CheckCLError(err, "MotionBlur SetArg 1");
+    err = clSetKernelArg(kernel, 2, sizeof(int), &width); CheckCLError(err, "MotionBlur SetArg 2");
+    err = clSetKernelArg(kernel, 3, sizeof(int), &height); CheckCLError(err, "MotionBlur SetArg 3");
+    err = clSetKernelArg(kernel, 4, sizeof(int), &channels); CheckCLError(err, "MotionBlur SetArg 4");
+    err = clSetKernelArg(kernel, 5, sizeof(int), &m_blurLength); CheckCLError(err, "MotionBlur SetArg 5");
 
     size_t globalWorkSize[2] = {static_cast<size_t>(width), static_cast<size_t>(height)};
-    err = clEnqueueNDRangeKernel(m_commandQueue, m_kernel, 2, nullptr, globalWorkSize, nullptr, 0, nullptr, nullptr);
+    err = m_runtime->EnqueueTunedKernel(queue, kernel, 2, globalWorkSize,
+                                        m_runtime->GetProfiler().Track("MotionBlur", ProfileCategory::COMPUTE));
     CheckCLError(err, "MotionBlur clEnqueueNDRangeKernel");
+}
+
+void MotionBlurFilter::SetEffectRadius(int blurLength) // radius является blurLength
+{
+    m_blurLength = std::max(0, blurLength);
+}
+void MotionBlurFilter::EnqueueRunningSum(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                                         ElementType elementType)
+{
+    if (channels < 1 || channels > 4) {
+        throw std::runtime_error("MotionBlurFilter supports 1-4 channels, got " + std::to_string(channels));
+    }
 
-    err = clEnqueueReadBuffer(m_commandQueue, outputBuffer, CL_TRUE, 0,
-                              imageSizeBytes, imageData.data(), 0, nullptr, nullptr);
-    CheckCLError(err, "MotionBlur clEnqueueReadBuffer");
+    // Один промежуточный буфер на все блоки: очередь упорядочена, блоки идут друг за другом.
+    // Сетка линий считается от начала всего изображения, поэтому полосы не дают швов
+    const MotionBlurGeometry geometry = MakeMotionBlurGeometry(m_blurLength, m_angleDegrees, width, height, m_rowOrigin);
+    PooledBuffer linesBuffer(m_runtime->GetBufferPool(), GetMotionBlurScratchBytes(geometry));
 
-    clFinish(m_commandQueue);
+    const std::string buildOptions = PixelBuildOptions(0, elementType);
+    cl_kernel linesKernel = GetKernel(m_runningSumKernelSource, "MotionLines", buildOptions);
+    cl_kernel resampleKernel = GetKernel(m_runningSumKernelSource, "MotionResample", buildOptions);
+    cl_int err;
+    err = clSetKernelArg(linesKernel, 0, sizeof(cl_mem), &input);                   CheckCLError(err, "MotionLines SetArg 0");
+    err = clSetKernelArg(linesKernel, 1, sizeof(cl_mem), linesBuffer.GetPtr());      CheckCLError(err, "MotionLines SetArg 1");
+    err = clSetKernelArg(linesKernel, 2, sizeof(int), &geometry.majorLength);       CheckCLError(err, "MotionLines SetArg 2");
+    err = clSetKernelArg(linesKernel, 3, sizeof(int), &geometry.minorLength);       CheckCLError(err, "MotionLines SetArg 3");
+    err = clSetKernelArg(linesKernel, 4, sizeof(int), &geometry.majorStride);       CheckCLError(err, "MotionLines SetArg 4");
+    err = clSetKernelArg(linesKernel, 5, sizeof(int), &geometry.minorStride);       CheckCLError(err, "MotionLines SetArg 5");
+    err = clSetKernelArg(linesKernel, 6, sizeof(int), &channels);                   CheckCLError(err, "MotionLines SetArg 6");
+    err = clSetKernelArg(linesKernel, 7, sizeof(float), &geometry.slope);           CheckCLError(err, "MotionLines SetArg 7");
+    err = clSetKernelArg(linesKernel, 8, sizeof(int), &geometry.windowStart);       CheckCLError(err, "MotionLines SetArg 8");
+    err = clSetKernelArg(linesKernel, 9, sizeof(int), &geometry.windowEnd);         CheckCLError(err, "MotionLines SetArg 9");
+    err = clSetKernelArg(linesKernel, 15, sizeof(int), &geometry.phases);           CheckCLError(err, "MotionLines SetArg 15");
+
+    err = clSetKernelArg(resampleKernel, 0, sizeof(cl_mem), linesBuffer.GetPtr());  CheckCLError(err, "MotionResample SetArg 0");
+    err = clSetKernelArg(resampleKernel, 1, sizeof(cl_mem), &output);               CheckCLError(err, "MotionResample SetArg 1");
+    err = clSetKernelArg(resampleKernel, 2, sizeof(int), &geometry.majorStride);    CheckCLError(err, "MotionResample SetArg 2");
+    err = clSetKernelArg(resampleKernel, 3, sizeof(int), &geometry.minorStride);    CheckCLError(err, "MotionResample SetArg 3");
+    err = clSetKernelArg(resampleKernel, 4, sizeof(int), &channels);                CheckCLError(err, "MotionResample SetArg 4");
+    err = clSetKernelArg(resampleKernel, 5, sizeof(float), &geometry.slope);        CheckCLError(err, "MotionResample SetArg 5");
+    err = clSetKernelArg(resampleKernel, 13, sizeof(int), &geometry.phases);        CheckCLError(err, "MotionResample SetArg 13");
+
+    for (const MotionBlurBlock& block : MakeMotionBlurBlocks(geometry)) {
+        const int minorBase = block.minorStart + block.lineBaseInt;
+        err = clSetKernelArg(linesKernel, 10, sizeof(int), &block.majorStart);    CheckCLError(err, "MotionLines SetArg 10");
+        err = clSetKernelArg(linesKernel, 11, sizeof(int), &block.majorLength);   CheckCLError(err, "MotionLines SetArg 11");
+        err = clSetKernelArg(linesKernel, 12, sizeof(int), &minorBase);           CheckCLError(err, "MotionLines SetArg 12");
+        err = clSetKernelArg(linesKernel, 13, sizeof(float), &block.lineBaseFrac); CheckCLError(err, "MotionLines SetArg 13");
+        err = clSetKernelArg(linesKernel, 14, sizeof(int), &block.lineCount);     CheckCLError(err, "MotionLines SetArg 14");
 
-    clReleaseMemObject(inputBuffer);
-    clReleaseMemObject(outputBuffer);
+        size_t linesWorkSize[1] = {static_cast<size_t>(block.lineCount)};
+        err = m_runtime->EnqueueTunedKernel(queue, linesKernel, 1, linesWorkSize,
+                                            m_runtime->GetProfiler().Track("MotionLines", ProfileCategory::COMPUTE));
+        CheckCLError(err, "MotionLines clEnqueueNDRangeKernel");
+
+        err = clSetKernelArg(resampleKernel, 6, sizeof(int), &block.majorStart);    CheckCLError(err, "MotionResample SetArg 6");
+        err = clSetKernelArg(resampleKernel, 7, sizeof(int), &block.majorLength);   CheckCLError(err, "MotionResample SetArg 7");
+        err = clSetKernelArg(resampleKernel, 8, sizeof(int), &block.minorStart);    CheckCLError(err, "MotionResample SetArg 8");
+        err = clSetKernelArg(resampleKernel, 9, sizeof(int), &block.minorLength);   CheckCLError(err, "MotionResample SetArg 9");
+        err = clSetKernelArg(resampleKernel, 10, sizeof(int), &block.lineBaseInt);  CheckCLError(err, "MotionResample SetArg 10");
+        err = clSetKernelArg(resampleKernel, 11, sizeof(float), &block.lineBaseFrac); CheckCLError(err, "MotionResample SetArg 11");
+        err = clSetKernelArg(resampleKernel, 12, sizeof(int), &block.lineCount);    CheckCLError(err, "MotionResample SetArg 12");
+
+        size_t resampleWorkSize[2] = {static_cast<size_t>(block.majorLength), static_cast<size_t>(block.minorLength)};
+        err = m_runtime->EnqueueTunedKernel(queue, resampleKernel, 2, resampleWorkSize,
+                                            m_runtime->GetProfiler().Track("MotionResample", ProfileCategory::COMPUTE));
+        CheckCLError(err, "MotionResample clEnqueueNDRangeKernel");
+    }
+    linesBuffer.ResetAfter(queue);
 }
 
-void MotionBlurFilter::SetEffectRadius(int blurLength) // radius является blurLength
+size_t MotionBlurFilter::GetScratchBytes(int width, int rows, int /*channels*/, ElementType /*elementType*/) const
 {
-    m_blurLength = std::max(0, blurLength);
-}
\ No newline at end of file
+    if (IsIdentity() || m_algorithm != MotionBlurAlgorithm::RUNNING_SUM) return 0;
+    return GetMotionBlurScratchBytes(MakeMotionBlurGeometry(m_blurLength, m_angleDegrees, width, rows));
+}
+
+void MotionBlurFilter::SetOption(const std::string& key, const std::string& value)
+{
+    if (key == "angle") {
+        m_angleDegrees = std::stof(value);
+    } else if (key == "algo") {
+        if (value == "running") m_algorithm = MotionBlurAlgorithm::RUNNING_SUM;
+        else if (value == "direct") m_algorithm = MotionBlurAlgorithm::DIRECT;
+        else throw std::runtime_error("Unknown motion algo '" + value + "' (running, direct)");
+    } else {
+        OpenCLImageFilter::SetOption(key, value);
+    }
+}
+
+std::string MotionBlurFilter::GetName() const
+{
+    std::ostringstream name;
+    name << "Motion Blur (" << m_angleDegrees << " deg)";
+    return name.str();
+}
@@ -1,31 +1,40 @@
 #pragma once
-#include "IImageFilter.h"
+#include "OpenCLImageFilter.h"
 #include <CL/cl.h>
 #include <string>
 #include <vector>
 
-class MotionBlurFilter : public IImageFilter
+enum class MotionBlurAlgorithm
+{
+    RUNNING_SUM, // Скользящая сумма вдоль линий под углом angle, стоимость не зависит от длины
+    DIRECT       // Исходное ядро: blurLength отсчетов на пиксель, только по горизонтали
+};
+
+class MotionBlurFilter : public OpenCLImageFilter
 {
 public:
     MotionBlurFilter(int initialBlurLength);
-    ~MotionBlurFilter() override;
 
-    void ApplyFilter(std::vector<unsigned char>& imageData, int width, int height, int channels) override;
+    void EnqueueOnDevice(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                         ElementType elementType) override;
     void SetEffectRadius(int blurLength) override; // Здесь radius - это длина размытия
-    std::string GetName() const override { return "Motion Blur (Horizontal)"; }
+    // "angle": направление в градусах (0 - по горизонтали); "algo": running | direct
+    void SetOption(const std::string& key, const std::string& value) override;
+    std::string GetName() const override;
+    [[nodiscard]] bool IsIdentity() const override { return m_blurLength <= 1; }
+    // Половина окна вдоль любого направления плюс строка на интерполяцию между линиями
+    [[nodiscard]] int GetHaloRows() const override { return m_blurLength / 2 + 2; }
+    // Линии одного блока (MotionBlurGeometry), не больше 32 МБ при любом размере изображения
+    [[nodiscard]] size_t GetScratchBytes(int width, int rows, int channels, ElementType elementType) const override;
 
 private:
-    void InitializeOpenCl();
-    void ReleaseOpenCl();
-    void CreateKernel();
+    void EnqueueRunningSum(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                           ElementType elementType);
 
     int m_blurLength;
-
-    cl_device_id m_deviceId = nullptr;
-    cl_context m_context = nullptr;
-    cl_command_queue m_commandQueue = nullptr;
-    cl_program m_program = nullptr;
-    cl_kernel m_kernel = nullptr;
+    float m_angleDegrees = 0.0f;
+    MotionBlurAlgorithm m_algorithm = MotionBlurAlgorithm::RUNNING_SUM;
 
     static const std::string m_kernelSource;
+    static const std::string m_runningSumKernelSource;
 };
\ No newline at end of file
@@ -0,0 +1,112 @@
+#include "MotionBlurGeometry.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Длина блока по основной оси: начальное окно каждой линии стоит samples отсчетов,
+    // поэтому блок не короче окна, иначе скользящая сумма теряет смысл
+    constexpr int MOTION_BLOCK_MAJOR = 256;
+    // Предел промежуточного буфера блока; по нему выбирается размер блока по второй оси
+    constexpr size_t MOTION_SCRATCH_BUDGET = size_t(32) << 20;
+    constexpr int MOTION_MIN_BLOCK_MINOR = 64;
+    constexpr size_t LINE_SAMPLE_BYTES = 4 * sizeof(float);
+    // Линий на пиксель по minor при дробном наклоне
+    constexpr int MOTION_LINE_PHASES = 8;
+
+    // Блок [start, конец) на сетке с шагом blockSize от начала всего изображения
+    int BlockEnd(int start, int origin, int blockSize, int length)
+    {
+        return std::min(length, ((start + origin) / blockSize + 1) * blockSize - origin);
+    }
+
+    MotionBlurBlock MakeBlock(const MotionBlurGeometry& geometry, int majorStart, int majorEnd, int minorStart, int minorEnd)
+    {
+        MotionBlurBlock block;
+        block.majorStart = majorStart;
+        block.minorStart = minorStart;
+        block.majorLength = majorEnd - majorStart;
+        block.minorLength = minorEnd - minorStart;
+
+        // Пиксель (major, minor) всего изображения лежит на линии k = minor - major * slope; диапазон k по блоку
+        const double slope = geometry.slope;
+        const double shift = slope * (block.majorLength - 1);
+        const double startShift = slope * (majorStart + geometry.majorOrigin);
+        const double firstMinor = minorStart + geometry.minorOrigin;
+        const double lowest = firstMinor - startShift - std::max(0.0, shift);
+        const double highest = firstMinor + block.minorLength - 1 - startShift - std::min(0.0, shift);
+        const double firstLine = std::floor(lowest);
+        // Целые линии firstLine .. floor(highest) + 1 и phases - 1 дробных между соседними
+        const int wholeLines = static_cast<int>(std::floor(highest) - firstLine) + 2;
+        block.lineCount = std::min(geometry.maxLineCount, (wholeLines - 1) * geometry.phases + 1);
+
+        // Линия t = k - firstLine в точке majorStart: minor = firstLine + t + (majorStart + majorOrigin) * slope
+        const double base = firstLine + startShift - firstMinor;
+        const double baseInt = std::floor(base);
+        block.lineBaseInt = static_cast<int>(baseInt);
+        block.lineBaseFrac = static_cast<float>(base - baseInt);
+        if (block.lineBaseFrac >= 1.0f) { // Округление до float
+            block.lineBaseInt += 1;
+            block.lineBaseFrac = 0.0f;
+        }
+        return block;
+    }
+}
+
+MotionBlurGeometry MakeMotionBlurGeometry(int blurLength, float angleDegrees, int width, int height, int rowOrigin)
+{
+    const double angle = angleDegrees * 3.14159265358979323846 / 180.0;
+    const double dx = std::cos(angle);
+    const double dy = -std::sin(angle);
+    const bool horizontal = std::abs(dx) >= std::abs(dy);
+
+    MotionBlurGeometry geometry;
+    geometry.majorLength = horizontal ? width : height;
+    geometry.minorLength = horizontal ? height : width;
+    geometry.majorStride = horizontal ? 1 : width;
+    geometry.minorStride = horizontal ? width : 1;
+    geometry.majorOrigin = horizontal ? 0 : rowOrigin;
+    geometry.minorOrigin = horizontal ? rowOrigin : 0;
+    geometry.slope = static_cast<float>(horizontal ? dy / dx : dx / dy);
+    // При наклоне 0 и 45 градусов каждый пиксель лежит на целой линии
+    geometry.phases = geometry.slope == std::round(geometry.slope) ? 1 : MOTION_LINE_PHASES;
+
+    // Шаг по основной оси проходит sqrt(1 + slope^2) пикселей вдоль линии
+    const double slope = geometry.slope;
+    const int samples = std::max(1, static_cast<int>(std::lround(blurLength / std::sqrt(1.0 + slope * slope))));
+    geometry.windowStart = -samples / 2;
+    geometry.windowEnd = samples % 2 == 0 ? samples / 2 - 1 : samples / 2; // Как в ApplyMotionBlur
+
+    // Сетка не зависит от размера изображения, иначе полоса и изображение целиком разбились бы по-разному
+    geometry.blockMajor = std::max(MOTION_BLOCK_MAJOR, samples);
+    const long long shear = static_cast<long long>(std::ceil(std::abs(slope) * (geometry.blockMajor - 1)));
+    const long long budgetLines = static_cast<long long>(MOTION_SCRATCH_BUDGET / (static_cast<size_t>(geometry.blockMajor) * LINE_SAMPLE_BYTES));
+    geometry.blockMinor = static_cast<int>(std::max<long long>(MOTION_MIN_BLOCK_MINOR, (budgetLines - 1) / geometry.phases - shear - 2));
+
+    // Линии блока: сдвиг на его длине плюс одна сверху для интерполяции и одна на округление
+    geometry.maxBandLength = std::max(1, std::min(geometry.blockMajor, geometry.majorLength));
+    const int maxBlockMinor = std::max(1, std::min(geometry.blockMinor, geometry.minorLength));
+    const int maxWholeLines = maxBlockMinor + static_cast<int>(std::ceil(std::abs(slope) * (geometry.maxBandLength - 1))) + 2;
+    geometry.maxLineCount = (maxWholeLines - 1) * geometry.phases + 1;
+    return geometry;
+}
+
+std::vector<MotionBlurBlock> MakeMotionBlurBlocks(const MotionBlurGeometry& geometry)
+{
+    std::vector<MotionBlurBlock> blocks;
+    for (int majorStart = 0; majorStart < geometry.majorLength;) {
+        const int majorEnd = BlockEnd(majorStart, geometry.majorOrigin, geometry.blockMajor, geometry.majorLength);
+        for (int minorStart = 0; minorStart < geometry.minorLength;) {
+            const int minorEnd = BlockEnd(minorStart, geometry.minorOrigin, geometry.blockMinor, geometry.minorLength);
+            blocks.push_back(MakeBlock(geometry, majorStart, majorEnd, minorStart, minorEnd));
+            minorStart = minorEnd;
+        }
+        majorStart = majorEnd;
+    }
+    return blocks;
+}
+
+size_t GetMotionBlurScratchBytes(const MotionBlurGeometry& geometry)
+{
+    return static_cast<size_t>(geometry.maxLineCount) * geometry.maxBandLength * LINE_SAMPLE_BYTES;
+}
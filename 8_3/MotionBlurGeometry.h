@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Геометрия размытия в движении вдоль наклонных линий (общая для MotionBlurFilter и CpuMotionBlurFilter).
+// Линия k проходит через точки (major, minor = k + major * slope); для почти горизонтального направления
+// major - это x, для почти вертикального - y, поэтому |slope| <= 1. Значение на линии берется линейной
+// интерполяцией по minor, окно усредняется скользящей суммой. Пиксель (i, j) лежит на линии k = j - i * slope,
+// дробная часть которой меняется с i, поэтому скользящие суммы считаются для линий с шагом 1 / phases
+// и пиксель интерполируется между двумя ближайшими: отклонение от его собственной линии - не больше
+// 1 / (2 * phases) пикселя поперек направления (при целом slope - 0 и phases = 1).
+// Изображение обрабатывается блоками: в блоке считаются только линии, проходящие через его пиксели,
+// поэтому промежуточный буфер ограничен размером блока, а не majorLength^2 * |slope|.
+// Линии и границы блоков привязаны к координатам всего изображения: полоса (FilterPipeline::ApplyInStrips)
+// с началом в строке rowOrigin считается на той же сетке, что и изображение целиком.
+struct MotionBlurGeometry
+{
+    int majorLength = 0;
+    int minorLength = 0;
+    int majorStride = 0; // Шаг по осям в пикселях
+    int minorStride = 0;
+    float slope = 0.0f;  // Смещение по minor на один шаг по major
+    int phases = 1;      // Линий на один пиксель по minor
+    int windowStart = 0; // Окно [i + windowStart, i + windowEnd] вдоль линии
+    int windowEnd = 0;
+    int majorOrigin = 0; // Координаты начала изображения (полосы) во всем изображении
+    int minorOrigin = 0;
+    int blockMajor = 0;  // Шаг сетки блоков по осям: зависит только от длины и угла
+    int blockMinor = 0;
+    int maxBandLength = 0; // Длина самого большого блока по основной оси
+    int maxLineCount = 0;  // Линий в самом большом блоке (с запасом на интерполяцию)
+};
+
+struct MotionBlurBlock
+{
+    int majorStart = 0;
+    int majorLength = 0;
+    int minorStart = 0;
+    int minorLength = 0;
+    int lineCount = 0;
+    // Линия t = a * phases + b проходит через minor = minorStart + lineBaseInt + a + floor(f), где
+    // f = lineBaseFrac + b / phases + (major - majorStart) * slope; разделение на целую и дробную части
+    // сохраняет точность интерполяции при больших координатах
+    int lineBaseInt = 0;
+    float lineBaseFrac = 0.0f;
+};
+
+// Направление (cos, -sin) в градусах: y изображения растет вниз, положительный угол - против часовой стрелки
+[[nodiscard]] MotionBlurGeometry MakeMotionBlurGeometry(int blurLength, float angleDegrees, int width, int height,
+                                                      int rowOrigin = 0);
+// Все блоки изображения: сетка с шагом blockMajor x blockMinor от начала всего изображения, обрезанная по краям
+[[nodiscard]] std::vector<MotionBlurBlock> MakeMotionBlurBlocks(const MotionBlurGeometry& geometry);
+// Промежуточный буфер одного блока: maxLineCount x maxBandLength x float4
+[[nodiscard]] size_t GetMotionBlurScratchBytes(const MotionBlurGeometry& geometry);
@@ -0,0 +1,240 @@
+#include "OpenCLDevices.h"
+#include "OpenCLUtils.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+
+using Clock = std::chrono::high_resolution_clock;
+using Milliseconds = std::chrono::duration<double, std::milli>;
+
+namespace
+{
+// Смесь арифметики и чтения памяти, чтобы не выиграло устройство, сильное только в одном
+const std::string PROBE_KERNEL_SOURCE = R"CLC(
+__kernel void DeviceProbe(__global const float* input, __global float* output, const int iterations)
+{
+    int gid = get_global_id(0);
+    float value = input[gid];
+    float accumulator = 0.0f;
+    for (int i = 0; i < iterations; ++i) {
+        accumulator = mad(accumulator, 0.999f, value);
+        value = mad(value, 1.0001f, 0.5f);
+    }
+    output[gid] = accumulator;
+}
+)CLC";
+
+std::string ToLower(std::string text)
+{
+    for (char& c : text) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return text;
+}
+
+std::string DeviceTypeName(cl_device_type type)
+{
+    if (type & CL_DEVICE_TYPE_GPU) return "GPU";
+    if (type & CL_DEVICE_TYPE_CPU) return "CPU";
+    if (type & CL_DEVICE_TYPE_ACCELERATOR) return "ACCEL";
+    return "OTHER";
+}
+
+// Время одного прогона пробного ядра в мс; бесконечность, если устройство не справилось
+double BenchmarkDevice(const OpenCLDeviceInfo& device)
+{
+    const size_t numElements = 1 << 20;
+    const int iterations = 256;
+    cl_int err;
+    cl_context context = clCreateContext(nullptr, 1, &device.deviceId, nullptr, nullptr, &err);
+    if (err != CL_SUCCESS) return std::numeric_limits<double>::infinity();
+
+    double bestMs = std::numeric_limits<double>::infinity();
+    cl_command_queue queue = nullptr;
+    cl_program program = nullptr;
+    cl_kernel kernel = nullptr;
+    cl_mem inputBuffer = nullptr;
+    cl_mem outputBuffer = nullptr;
+    try {
+#if defined(CL_VERSION_2_0) && CL_TARGET_OPENCL_VERSION >= 200
+        queue = clCreateCommandQueueWithProperties(context, device.deviceId, nullptr, &err);
+#else
+        queue = clCreateCommandQueue(context, device.deviceId, 0, &err);
+#endif
+        CheckCLError(err, "clCreateCommandQueue (probe)");
+        program = CreateProgramWithSource(context, device.deviceId, PROBE_KERNEL_SOURCE);
+        kernel = clCreateKernel(program, "DeviceProbe", &err);
+        CheckCLError(err, "clCreateKernel (DeviceProbe)");
+
+        std::vector<float> input(numElements, 1.0f);
+        inputBuffer = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                     numElements * sizeof(float), input.data(), &err);
+        CheckCLError(err, "clCreateBuffer (probe input)");
+        outputBuffer = clCreateBuffer(context, CL_MEM_WRITE_ONLY, numElements * sizeof(float), nullptr, &err);
+        CheckCLError(err, "clCreateBuffer (probe output)");
+
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &inputBuffer); CheckCLError(err, "Probe SetArg 0");
+        err = clSetKernelArg(kernel, 1, sizeof(cl_mem), &outputBuffer); CheckCLError(err, "Probe SetArg 1");
+        err = clSetKernelArg(kernel, 2, sizeof(int), &iterations); CheckCLError(err, "Probe SetArg 2");
+
+        size_t globalWorkSize[1] = {numElements};
+        // Первый прогон - прогрев (JIT, ленивое выделение памяти), потом берем лучший из трех
+        for (int run = 0; run < 4; ++run) {
+            auto startTime = Clock::now();
+            err = clEnqueueNDRangeKernel(queue, kernel, 1, nullptr, globalWorkSize, nullptr, 0, nullptr, nullptr);
+            CheckCLError(err, "clEnqueueNDRangeKernel (probe)");
+            clFinish(queue);
+            double elapsedMs = Milliseconds(Clock::now() - startTime).count();
+            if (run > 0) bestMs = std::min(bestMs, elapsedMs);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Warning: benchmark failed on device " << device.index << ": " << e.what() << std::endl;
+        bestMs = std::numeric_limits<double>::infinity();
+    }
+
+    if (inputBuffer) clReleaseMemObject(inputBuffer);
+    if (outputBuffer) clReleaseMemObject(outputBuffer);
+    if (kernel) clReleaseKernel(kernel);
+    if (program) clReleaseProgram(program);
+    if (queue) clReleaseCommandQueue(queue);
+    clReleaseContext(context);
+    return bestMs;
+}
+}
+
+DeviceSelectionPolicy DeviceSelectionPolicy::Parse(const std::string& value)
+{
+    DeviceSelectionPolicy policy;
+    std::string lowered = ToLower(value);
+    if (lowered.empty() || lowered == "default") {
+        policy.mode = DeviceSelectionMode::DEFAULT;
+    } else if (lowered == "fastest") {
+        policy.mode = DeviceSelectionMode::FASTEST;
+    } else if (std::all_of(value.begin(), value.end(), [](unsigned char c) { return std::isdigit(c); })) {
+        policy.mode = DeviceSelectionMode::INDEX;
+        policy.index = std::stoi(value);
+    } else {
+        policy.mode = DeviceSelectionMode::NAME;
+        policy.name = value;
+    }
+    return policy;
+}
+
+std::vector<OpenCLDeviceInfo> EnumerateOpenCLDevices()
+{
+    std::vector<OpenCLDeviceInfo> devices;
+
+    cl_uint numPlatforms = 0;
+    cl_int err = clGetPlatformIDs(0, nullptr, &numPlatforms);
+    if (err != CL_SUCCESS || numPlatforms == 0) return devices; // Нет ICD или платформ - пустой список
+
+    std::vector<cl_platform_id> platforms(numPlatforms);
+    err = clGetPlatformIDs(numPlatforms, platforms.data(), nullptr);
+    CheckCLError(err, "clGetPlatformIDs (list)");
+
+    for (cl_platform_id platform : platforms) {
+        cl_uint numDevices = 0;
+        err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_ALL, 0, nullptr, &numDevices);
+        if (err == CL_DEVICE_NOT_FOUND || numDevices == 0) continue;
+        CheckCLError(err, "clGetDeviceIDs (count)");
+
+        std::vector<cl_device_id> deviceIds(numDevices);
+        err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_ALL, numDevices, deviceIds.data(), nullptr);
+        CheckCLError(err, "clGetDeviceIDs (list)");
+
+        std::string platformName = GetPlatformInfoString(platform, CL_PLATFORM_NAME);
+        for (cl_device_id deviceId : deviceIds) {
+            OpenCLDeviceInfo info;
+            info.index = static_cast<int>(devices.size());
+            info.platformId = platform;
+            info.deviceId = deviceId;
+            info.platformName = platformName;
+            info.deviceName = GetDeviceInfoString(deviceId, CL_DEVICE_NAME);
+            info.driverVersion = GetDeviceInfoString(deviceId, CL_DRIVER_VERSION);
+            clGetDeviceInfo(deviceId, CL_DEVICE_TYPE, sizeof(info.type), &info.type, nullptr);
+            clGetDeviceInfo(deviceId, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(info.computeUnits), &info.computeUnits, nullptr);
+            clGetDeviceInfo(deviceId, CL_DEVICE_MAX_CLOCK_FREQUENCY, sizeof(info.clockMHz), &info.clockMHz, nullptr);
+            clGetDeviceInfo(deviceId, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(info.maxWorkGroupSize), &info.maxWorkGroupSize, nullptr);
+            clGetDeviceInfo(deviceId, CL_DEVICE_LOCAL_MEM_SIZE, sizeof(info.localMemBytes), &info.localMemBytes, nullptr);
+            clGetDeviceInfo(deviceId, CL_DEVICE_GLOBAL_MEM_SIZE, sizeof(info.globalMemBytes), &info.globalMemBytes, nullptr);
+            clGetDeviceInfo(deviceId, CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(info.maxAllocBytes), &info.maxAllocBytes, nullptr);
+            clGetDeviceInfo(deviceId, CL_DEVICE_IMAGE_SUPPORT, sizeof(info.imageSupport), &info.imageSupport, nullptr);
+            clGetDeviceInfo(deviceId, CL_DEVICE_IMAGE2D_MAX_WIDTH, sizeof(info.image2dMaxWidth), &info.image2dMaxWidth, nullptr);
+            clGetDeviceInfo(deviceId, CL_DEVICE_IMAGE2D_MAX_HEIGHT, sizeof(info.image2dMaxHeight), &info.image2dMaxHeight, nullptr);
+            clGetDeviceInfo(deviceId, CL_DEVICE_HOST_UNIFIED_MEMORY, sizeof(info.hostUnifiedMemory), &info.hostUnifiedMemory, nullptr);
+            devices.push_back(info);
+        }
+    }
+    return devices;
+}
+
+void PrintOpenCLDevices(const std::vector<OpenCLDeviceInfo>& devices, std::ostream& out)
+{
+    if (devices.empty()) {
+        out << "No OpenCL devices found." << std::endl;
+        return;
+    }
+    for (const OpenCLDeviceInfo& device : devices) {
+        out << "[" << device.index << "] " << DeviceTypeName(device.type) << " " << device.deviceName
+            << " (platform: " << device.platformName << ", driver " << device.driverVersion << ")\n"
+            << "     compute units: " << device.computeUnits
+            << ", clock: " << device.clockMHz << " MHz"
+            << ", max work-group: " << device.maxWorkGroupSize
+            << ", local mem: " << device.localMemBytes / 1024 << " KiB"
+            << ", global mem: " << device.globalMemBytes / (1024 * 1024) << " MiB"
+            << ", max alloc: " << device.maxAllocBytes / (1024 * 1024) << " MiB"
+            << ", images: " << (device.imageSupport ? "up to " + std::to_string(device.image2dMaxWidth) + "x" +
+                                                      std::to_string(device.image2dMaxHeight) : std::string("no"))
+            << ", unified memory: " << (device.hostUnifiedMemory ? "yes" : "no") << std::endl;
+    }
+}
+
+const OpenCLDeviceInfo& SelectOpenCLDevice(const std::vector<OpenCLDeviceInfo>& devices,
+                                           const DeviceSelectionPolicy& policy)
+{
+    if (devices.empty()) throw std::runtime_error("No OpenCL platforms found.");
+
+    switch (policy.mode) {
+        case DeviceSelectionMode::INDEX:
+            if (policy.index < 0 || policy.index >= static_cast<int>(devices.size())) {
+                throw std::runtime_error("OpenCL device index " + std::to_string(policy.index) +
+                                         " is out of range (found " + std::to_string(devices.size()) + " devices).");
+            }
+            return devices[policy.index];
+
+        case DeviceSelectionMode::NAME: {
+            std::string pattern = ToLower(policy.name);
+            for (const OpenCLDeviceInfo& device : devices) {
+                if (ToLower(device.deviceName).find(pattern) != std::string::npos ||
+                    ToLower(device.platformName).find(pattern) != std::string::npos) {
+                    return device;
+                }
+            }
+            throw std::runtime_error("No OpenCL device matches name '" + policy.name + "'.");
+        }
+
+        case DeviceSelectionMode::FASTEST: {
+            const OpenCLDeviceInfo* best = nullptr;
+            double bestMs = std::numeric_limits<double>::infinity();
+            for (const OpenCLDeviceInfo& device : devices) {
+                double elapsedMs = BenchmarkDevice(device);
+                std::cout << "Benchmark [" << device.index << "] " << device.deviceName << ": "
+                          << std::fixed << std::setprecision(3) << elapsedMs << " ms" << std::endl;
+                if (elapsedMs < bestMs) {
+                    bestMs = elapsedMs;
+                    best = &device;
+                }
+            }
+            if (best == nullptr) throw std::runtime_error("Benchmark failed on every OpenCL device.");
+            return *best;
+        }
+
+        case DeviceSelectionMode::DEFAULT:
+        default:
+            for (const OpenCLDeviceInfo& device : devices) {
+                if (device.type & CL_DEVICE_TYPE_GPU) return device;
+            }
+            return devices.front();
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <CL/cl.h>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Описание одного устройства OpenCL из всех доступных платформ
+struct OpenCLDeviceInfo
+{
+    int index = 0; // Сквозной номер устройства по всем платформам, используется в --device <index>
+    cl_platform_id platformId = nullptr;
+    cl_device_id deviceId = nullptr;
+    std::string platformName;
+    std::string deviceName;
+    std::string driverVersion;
+    cl_device_type type = 0;
+    cl_uint computeUnits = 0;
+    cl_uint clockMHz = 0;
+    size_t maxWorkGroupSize = 0;
+    cl_ulong localMemBytes = 0;
+    cl_ulong globalMemBytes = 0;
+    cl_ulong maxAllocBytes = 0;
+    cl_bool imageSupport = CL_FALSE;
+    size_t image2dMaxWidth = 0; // Предел размеров image2d; больше - только буферы
+    size_t image2dMaxHeight = 0;
+    cl_bool hostUnifiedMemory = CL_FALSE; // Память устройства - это память хоста (CPU, встроенный GPU)
+};
+
+enum class DeviceSelectionMode
+{
+    DEFAULT, // Первый GPU на любой платформе, иначе первое устройство
+    INDEX,
+    NAME,    // Первое устройство, в имени которого (или в имени платформы) есть подстрока
+    FASTEST  // Замер микробенчмарком на каждом устройстве
+};
+
+struct DeviceSelectionPolicy
+{
+    DeviceSelectionMode mode = DeviceSelectionMode::DEFAULT;
+    int index = -1;
+    std::string name;
+
+    // "3" -> INDEX, "fastest" -> FASTEST, "default" или "" -> DEFAULT, иначе NAME
+    static DeviceSelectionPolicy Parse(const std::string& value);
+};
+
+std::vector<OpenCLDeviceInfo> EnumerateOpenCLDevices();
+void PrintOpenCLDevices(const std::vector<OpenCLDeviceInfo>& devices, std::ostream& out);
+const OpenCLDeviceInfo& SelectOpenCLDevice(const std::vector<OpenCLDeviceInfo>& devices,
+                                           const DeviceSelectionPolicy& policy);
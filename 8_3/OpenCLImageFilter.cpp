@@ -0,0 +1,334 @@
+#include "OpenCLImageFilter.h"
+#include "OpenCLUtils.h"
+#include <stdexcept>
+#include <utility>
+
+const std::string OpenCLImageFilter::m_pixelTypesSource = R"CLC(
+// Тип значения канала по -DELEMENT: 0 - uchar, 1 - ushort, 2 - half, 3 - float (по умолчанию uchar).
+// Element - тип в глобальной памяти, Value - тип значения в регистрах. Без cl_khr_fp16 half можно
+// только загрузить и сохранить (vload_half/vstore_half), поэтому для half Value - это float.
+#ifndef ELEMENT
+#define ELEMENT 0
+#endif
+#define PASTE_(a, b) a##b
+#define PASTE(a, b) PASTE_(a, b)
+
+#if ELEMENT == 0
+typedef uchar Element;
+#define VALUE_TYPE uchar
+#define ELEMENT_SCALE 255.0f // Во сколько раз значение больше нормированного (read_imagef с UNORM)
+#elif ELEMENT == 1
+typedef ushort Element;
+#define VALUE_TYPE ushort
+#define ELEMENT_SCALE 65535.0f
+#elif ELEMENT == 2
+typedef half Element;
+#define VALUE_TYPE float
+#define ELEMENT_SCALE 1.0f
+#else
+typedef float Element;
+#define VALUE_TYPE float
+#define ELEMENT_SCALE 1.0f
+#endif
+typedef VALUE_TYPE Value;
+
+// Одно значение: LOAD_VALUE/STORE_VALUE по индексу элемента, преобразования в float и обратно
+// (TO_VALUE - с округлением к ближайшему, TO_VALUE_RTZ - с отбрасыванием дробной части)
+#if ELEMENT == 2
+#define LOAD_VALUE(index, image) vload_half(index, image)
+#define STORE_VALUE(value, index, image) vstore_half_rte(value, index, image)
+#else
+#define LOAD_VALUE(index, image) ((image)[index])
+#define STORE_VALUE(value, index, image) ((image)[index] = (value))
+#endif
+#if ELEMENT <= 1
+#define VALUE_TO_FLOAT(value) convert_float(value)
+#define TO_VALUE(value) PASTE(PASTE(convert_, VALUE_TYPE), _sat_rte)(value)
+#define TO_VALUE_RTZ(value) PASTE(PASTE(convert_, VALUE_TYPE), _sat)(value)
+#else
+#define VALUE_TO_FLOAT(value) (value)
+#define TO_VALUE(value) (value)
+#define TO_VALUE_RTZ(value) (value)
+#endif
+
+// Пиксель из CHANNELS значений (-DCHANNELS=1..4): Pixel - вектор Value, PixelF - его float-вариант
+#ifdef CHANNELS
+#if CHANNELS == 1
+#define VECTOR_WIDTH
+#else
+#define VECTOR_WIDTH CHANNELS
+#endif
+typedef PASTE(VALUE_TYPE, VECTOR_WIDTH) Pixel;
+typedef PASTE(float, VECTOR_WIDTH) PixelF;
+
+#if ELEMENT == 2
+#define LOAD_PIXEL(index, image) PASTE(vload_half, VECTOR_WIDTH)(index, image)
+#define STORE_PIXEL(value, index, image) PASTE(PASTE(vstore_half, VECTOR_WIDTH), _rte)(value, index, image)
+#elif CHANNELS == 1
+#define LOAD_PIXEL(index, image) ((image)[index])
+#define STORE_PIXEL(value, index, image) ((image)[index] = (value))
+#elif CHANNELS == 4
+// 4 канала: выровненный векторный доступ, как в исходных ядрах
+#define LOAD_PIXEL(index, image) (((__global const Pixel*)(image))[index])
+#define STORE_PIXEL(value, index, image) (((__global Pixel*)(image))[index] = (value))
+#else
+#define LOAD_PIXEL(index, image) PASTE(vload, CHANNELS)(index, image)
+#define STORE_PIXEL(value, index, image) PASTE(vstore, CHANNELS)(value, index, image)
+#endif
+
+#if ELEMENT <= 1
+#define TO_FLOAT(pixel) PASTE(convert_float, VECTOR_WIDTH)(pixel)
+#define TO_PIXEL(value) PASTE(PASTE(PASTE(convert_, VALUE_TYPE), VECTOR_WIDTH), _sat_rte)(value)
+#else
+#define TO_FLOAT(pixel) (pixel)
+#define TO_PIXEL(value) (value)
+#endif
+
+// Эпилог фильтра (OpenCLImageFilter::SetEpilogue): с -DPOINT_OPS перед ядром стоит ApplyPointOps
+#ifdef POINT_OPS
+#define EPILOGUE(value) ApplyPointOps(value)
+#define EPILOGUE_PIXEL(pixel) TO_PIXEL(ApplyPointOps(TO_FLOAT(pixel)))
+#else
+#define EPILOGUE(value) (value)
+#define EPILOGUE_PIXEL(pixel) (pixel)
+#endif
+#endif
+
+// Эпилог для ядер, которые ведут один канал: float-значение канала channel (эпилог без swizzle).
+// Без -DCHANNELS или -DPOINT_OPS значение не меняется
+#if defined(POINT_OPS) && defined(CHANNELS)
+#define EPILOGUE_VALUE(value, channel) ApplyPointOpsValue(value, channel)
+#else
+#define EPILOGUE_VALUE(value, channel) (value)
+#endif
+)CLC";
+
+FilterCompletion::FilterCompletion(cl_event readEvent, PooledBuffer inputBuffer, PooledBuffer outputBuffer)
+        : m_readEvent(readEvent), m_inputBuffer(std::move(inputBuffer)), m_outputBuffer(std::move(outputBuffer))
+{
+}
+
+FilterCompletion::~FilterCompletion()
+{
+    try {
+        Wait();
+    } catch (...) {
+        // Исключение из деструктора недопустимо; ошибка устройства всплывет на следующей команде
+    }
+}
+
+FilterCompletion::FilterCompletion(FilterCompletion&& other) noexcept
+        : m_readEvent(other.m_readEvent),
+          m_inputBuffer(std::move(other.m_inputBuffer)),
+          m_outputBuffer(std::move(other.m_outputBuffer))
+{
+    other.m_readEvent = nullptr;
+}
+
+FilterCompletion& FilterCompletion::operator=(FilterCompletion&& other) noexcept
+{
+    if (this != &other) {
+        Wait();
+        m_readEvent = other.m_readEvent;
+        m_inputBuffer = std::move(other.m_inputBuffer);
+        m_outputBuffer = std::move(other.m_outputBuffer);
+        other.m_readEvent = nullptr;
+    }
+    return *this;
+}
+
+void FilterCompletion::Wait()
+{
+    if (!m_readEvent) return;
+    cl_int err = clWaitForEvents(1, &m_readEvent);
+    clReleaseEvent(m_readEvent);
+    m_readEvent = nullptr;
+    // Чтение завершено, значит и все команды до него в этой in-order очереди
+    m_inputBuffer.Reset();
+    m_outputBuffer.Reset();
+    CheckCLError(err, "FilterCompletion clWaitForEvents");
+}
+
+bool FilterCompletion::IsReady() const
+{
+    if (!m_readEvent) return true;
+    cl_int status = CL_QUEUED;
+    cl_int err = clGetEventInfo(m_readEvent, CL_EVENT_COMMAND_EXECUTION_STATUS, sizeof(status), &status, nullptr);
+    CheckCLError(err, "FilterCompletion clGetEventInfo");
+    return status <= CL_COMPLETE;
+}
+
+OpenCLImageFilter::OpenCLImageFilter()
+        : m_runtime(OpenCLRuntime::Acquire())
+{
+}
+
+OpenCLImageFilter::~OpenCLImageFilter()
+{
+    for (auto& [key, kernel] : m_kernels) clReleaseKernel(kernel);
+}
+
+std::string OpenCLImageFilter::PixelBuildOptions(int channels, ElementType elementType)
+{
+    std::string options = "-DELEMENT=" + std::to_string(static_cast<int>(elementType));
+    return channels > 0 ? "-DCHANNELS=" + std::to_string(channels) + " " + options : options;
+}
+
+size_t OpenCLImageFilter::PixelStorageBytes(int channels, ElementType elementType)
+{
+    size_t valueBytes = elementType == ElementType::HALF ? sizeof(float) : GetElementSize(elementType);
+    return (channels == 3 ? 4 : static_cast<size_t>(channels)) * valueBytes;
+}
+
+cl_kernel OpenCLImageFilter::GetKernel(const std::string& kernelSource, const std::string& kernelName,
+                                       const std::string& buildOptions)
+{
+    const std::string key = kernelName + ' ' + buildOptions;
+    auto it = m_kernels.find(key);
+    if (it != m_kernels.end()) return it->second;
+
+    cl_kernel kernel = m_runtime->CreateKernel(m_pixelTypesSource + kernelSource, kernelName, buildOptions);
+    m_kernels.emplace(key, kernel);
+    return kernel;
+}
+
+void OpenCLImageFilter::SetEpilogue(std::vector<PointOp> ops)
+{
+    m_epilogue = std::move(ops);
+    for (auto& [key, kernel] : m_kernels) clReleaseKernel(kernel);
+    m_kernels.clear();
+}
+
+std::string OpenCLImageFilter::GetEpilogueSource() const
+{
+    return HasEpilogue() ? GeneratePointOpsSource(m_epilogue) : std::string();
+}
+
+std::string OpenCLImageFilter::GetEpilogueBuildOptions(int channels) const
+{
+    if (!HasEpilogue()) return {};
+    ValidatePointOps(m_epilogue, channels);
+    return " -DPOINT_OPS";
+}
+
+void OpenCLImageFilter::EnqueuePointOps(cl_command_queue queue, const std::vector<PointOp>& ops, cl_mem input, cl_mem output,
+                                        int width, int height, int channels, ElementType elementType)
+{
+    ValidatePointOps(ops, channels);
+    // Программа зависит только от набора операций: одинаковые цепочки получают одно ядро из реестра рантайма
+    cl_kernel kernel = GetKernel(GeneratePointOpsSource(ops), "PointOps",
+                                 PixelBuildOptions(channels, elementType) + " -DPOINT_OPS");
+    int numPixels = width * height;
+    cl_int err;
+    err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &input); CheckCLError(err, "PointOps SetArg 0");
+    err = clSetKernelArg(kernel, 1, sizeof(cl_mem), &output); CheckCLError(err, "PointOps SetArg 1");
+    err = clSetKernelArg(kernel, 2, sizeof(int), &numPixels); CheckCLError(err, "PointOps SetArg 2");
+
+    size_t globalWorkSize[1] = {static_cast<size_t>(numPixels)};
+    err = clEnqueueNDRangeKernel(queue, kernel, 1, nullptr, globalWorkSize, nullptr, 0, nullptr,
+                                 m_runtime->GetProfiler().Track(GetName() + " point ops", ProfileCategory::COMPUTE));
+    CheckCLError(err, GetName() + " clEnqueueNDRangeKernel (PointOps)");
+}
+
+void OpenCLImageFilter::EnqueueEpilogue(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height,
+                                        int channels, ElementType elementType)
+{
+    if (HasEpilogue()) EnqueuePointOps(queue, m_epilogue, input, output, width, height, channels, elementType);
+    else if (input != output) EnqueueCopy(queue, input, output, width, height, channels, elementType);
+}
+
+void OpenCLImageFilter::ApplyFilter(PixelBuffer& imageData, int width, int height, int channels)
+{
+    ApplyFilter(imageData, width, height, channels, ElementType::UCHAR);
+}
+
+void OpenCLImageFilter::ApplyFilter(PixelBuffer& imageData, int width, int height, int channels, ElementType elementType)
+{
+    if (IsIdentity()) return;
+
+    cl_int err;
+    cl_command_queue queue = m_runtime->GetQueue();
+    size_t imageSizeBytes = static_cast<size_t>(width) * height * channels * GetElementSize(elementType);
+
+    if (m_runtime->UsesZeroCopy()) {
+        // Ядро читает imageData и пишет в выровненный вектор хоста напрямую, затем векторы меняются местами
+        PixelBuffer result(imageData.size());
+        {
+            HostMappedBuffer inputBuffer(m_runtime->GetContext(), CL_MEM_READ_ONLY, imageData.data(), imageSizeBytes);
+            HostMappedBuffer outputBuffer(m_runtime->GetContext(), CL_MEM_READ_WRITE, result.data(), imageSizeBytes);
+            EnqueueOnDevice(queue, inputBuffer.Get(), outputBuffer.Get(), width, height, channels, elementType);
+            outputBuffer.SyncToHost(queue, m_runtime->GetProfiler().Track(GetName() + " map", ProfileCategory::TRANSFER));
+            clFinish(queue);
+        }
+        imageData.swap(result);
+        return;
+    }
+
+    DeviceBufferPool& bufferPool = m_runtime->GetBufferPool();
+    PooledBuffer inputBuffer(bufferPool, imageSizeBytes);
+    PooledBuffer outputBuffer(bufferPool, imageSizeBytes);
+    err = clEnqueueWriteBuffer(queue, inputBuffer.Get(), CL_FALSE, 0, imageSizeBytes, imageData.data(), 0, nullptr,
+                               m_runtime->GetProfiler().Track(GetName() + " write", ProfileCategory::TRANSFER));
+    CheckCLError(err, GetName() + " clEnqueueWriteBuffer (inputBuffer)");
+
+    EnqueueOnDevice(queue, inputBuffer.Get(), outputBuffer.Get(), width, height, channels, elementType);
+
+    err = clEnqueueReadBuffer(queue, outputBuffer.Get(), CL_TRUE, 0, imageSizeBytes, imageData.data(), 0, nullptr,
+                              m_runtime->GetProfiler().Track(GetName() + " read", ProfileCategory::TRANSFER));
+    CheckCLError(err, GetName() + " clEnqueueReadBuffer");
+
+    clFinish(queue);
+}
+
+FilterCompletion OpenCLImageFilter::ApplyFilterAsync(PixelBuffer& imageData, int width, int height, int channels,
+                                                     ElementType elementType)
+{
+    if (IsIdentity()) return {};
+
+    cl_int err;
+    cl_command_queue queue = m_runtime->GetQueue(m_nextAsyncQueue);
+    m_nextAsyncQueue = (m_nextAsyncQueue + 1) % ASYNC_QUEUE_COUNT;
+    size_t imageSizeBytes = static_cast<size_t>(width) * height * channels * GetElementSize(elementType);
+
+    DeviceBufferPool& bufferPool = m_runtime->GetBufferPool();
+    PooledBuffer inputBuffer;
+    PooledBuffer outputBuffer(bufferPool, imageSizeBytes);
+    if (m_runtime->UsesZeroCopy()) {
+        // Вход читается из imageData без загрузки. Результат по-прежнему копируется чтением:
+        // вектор вызывающего должен остаться тем же, а записать в него по месту ядро не может.
+        // Буфер освобождается сразу - OpenCL удалит его после завершения команд.
+        HostMappedBuffer hostInput(m_runtime->GetContext(), CL_MEM_READ_ONLY, imageData.data(), imageSizeBytes);
+        EnqueueOnDevice(queue, hostInput.Get(), outputBuffer.Get(), width, height, channels, elementType);
+    } else {
+        inputBuffer = PooledBuffer(bufferPool, imageSizeBytes);
+        err = clEnqueueWriteBuffer(queue, inputBuffer.Get(), CL_FALSE, 0, imageSizeBytes, imageData.data(), 0, nullptr,
+                                   m_runtime->GetProfiler().Track(GetName() + " write", ProfileCategory::TRANSFER));
+        CheckCLError(err, GetName() + " clEnqueueWriteBuffer (async inputBuffer)");
+
+        EnqueueOnDevice(queue, inputBuffer.Get(), outputBuffer.Get(), width, height, channels, elementType);
+    }
+
+    cl_event readEvent = nullptr;
+    err = clEnqueueReadBuffer(queue, outputBuffer.Get(), CL_FALSE, 0,
+                              imageSizeBytes, imageData.data(), 0, nullptr, &readEvent);
+    CheckCLError(err, GetName() + " clEnqueueReadBuffer (async)");
+    m_runtime->GetProfiler().Record(GetName() + " read", ProfileCategory::TRANSFER, readEvent);
+    // Без flush команды могут лежать на хосте до следующего вызова, и перекрытия не будет
+    clFlush(queue);
+
+    return FilterCompletion(readEvent, std::move(inputBuffer), std::move(outputBuffer));
+}
+
+void OpenCLImageFilter::SetOption(const std::string& key, const std::string& value)
+{
+    throw std::runtime_error(GetName() + " has no option '" + key + "' (value '" + value + "').");
+}
+
+void OpenCLImageFilter::EnqueueCopy(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                                    ElementType elementType)
+{
+    size_t imageSizeBytes = static_cast<size_t>(width) * height * channels * GetElementSize(elementType);
+    cl_int err = clEnqueueCopyBuffer(queue, input, output, 0, 0, imageSizeBytes, 0, nullptr,
+                                     m_runtime->GetProfiler().Track(GetName() + " copy", ProfileCategory::TRANSFER));
+    CheckCLError(err, GetName() + " clEnqueueCopyBuffer");
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include "IImageFilter.h"
+#include "OpenCLRuntime.h"
+#include "PixelFormat.h"
+#include "PointOps.h"
+#include <CL/cl.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Результат ApplyFilterAsync: событие чтения результата на хост плюс буферы устройства,
+// которые должны жить до его завершения. Деструктор ждет завершения, поэтому разрушать
+// объект до того, как перестанет существовать вектор с данными, безопасно.
+class FilterCompletion
+{
+public:
+    FilterCompletion() = default; // Уже завершенная операция (например, фильтр-тождество)
+    FilterCompletion(cl_event readEvent, PooledBuffer inputBuffer, PooledBuffer outputBuffer);
+    ~FilterCompletion();
+
+    FilterCompletion(FilterCompletion&& other) noexcept;
+    FilterCompletion& operator=(FilterCompletion&& other) noexcept;
+    FilterCompletion(const FilterCompletion&) = delete;
+    FilterCompletion& operator=(const FilterCompletion&) = delete;
+
+    // Блокируется, пока результат не окажется в векторе, переданном в ApplyFilterAsync
+    void Wait();
+    [[nodiscard]] bool IsReady() const;
+    // Событие для списков ожидания других команд; nullptr, если операция уже завершена
+    [[nodiscard]] cl_event GetEvent() const { return m_readEvent; }
+
+private:
+    cl_event m_readEvent = nullptr;
+    PooledBuffer m_inputBuffer;
+    PooledBuffer m_outputBuffer;
+};
+
+// Базовый класс фильтров на OpenCL. Наследник реализует только EnqueueOnDevice,
+// а ApplyFilter (загрузка, запуск, чтение результата) общий для всех.
+class OpenCLImageFilter : public IImageFilter
+{
+public:
+    ~OpenCLImageFilter() override;
+
+    void ApplyFilter(PixelBuffer& imageData, int width, int height, int channels) override;
+    // То же для значений типа elementType (IImageFilter::ApplyFilter - это ElementType::UCHAR)
+    void ApplyFilter(PixelBuffer& imageData, int width, int height, int channels, ElementType elementType);
+
+    // Асинхронный вариант ApplyFilter: загрузка, ядра и чтение ставятся в очередь без ожидания.
+    // Кадры по очереди распределяются между ASYNC_QUEUE_COUNT очередями, так что загрузка
+    // следующего кадра, вычисление текущего и чтение предыдущего могут идти одновременно.
+    // imageData нельзя трогать (и разрушать), пока не завершится возвращенный FilterCompletion.
+    // Фильтр не потокобезопасен: вызывать из одного потока хоста.
+    FilterCompletion ApplyFilterAsync(PixelBuffer& imageData, int width, int height, int channels,
+                                      ElementType elementType = ElementType::UCHAR);
+
+    // Ставит фильтр в очередь queue: читает input, пишет output.
+    // Оба буфера не меньше width * height * channels значений типа elementType и не совпадают.
+    // Завершения не ждет, поэтому цепочку фильтров можно выполнить на устройстве без чтения
+    // промежуточных результатов.
+    virtual void EnqueueOnDevice(cl_command_queue queue, cl_mem input, cl_mem output,
+                                 int width, int height, int channels, ElementType elementType) = 0;
+
+    // Дополнительная настройка из цепочки фильтров ("median:5:algo=tiled").
+    // По умолчанию опций нет: неизвестный ключ - исключение.
+    virtual void SetOption(const std::string& key, const std::string& value);
+
+    // true, если с текущими параметрами фильтр не меняет изображение и его можно пропустить
+    [[nodiscard]] virtual bool IsIdentity() const { return false; }
+
+    // На сколько строк выше и ниже пикселя фильтр читает вход: по этому числу FilterPipeline
+    // добавляет поля к полосам при обработке по частям. -1 - результат зависит от всего
+    // изображения (например, от его центра), и по частям фильтр не применяется.
+    [[nodiscard]] virtual int GetHaloRows() const { return -1; }
+
+    // Байт временных буферов устройства, которые EnqueueOnDevice выделяет для изображения width x rows
+    // (у полосы rows - с полями). По ним FilterPipeline выбирает высоту полос. По умолчанию 0.
+    [[nodiscard]] virtual size_t GetScratchBytes(int /*width*/, int /*rows*/, int /*channels*/, ElementType /*elementType*/) const
+    {
+        return 0;
+    }
+    // Строка всего изображения, с которой начинается полоса в EnqueueOnDevice (FilterPipeline::ApplyInStrips).
+    // Фильтры с сеткой выборки, привязанной к координатам (motion под углом), считают ее от начала
+    // изображения, чтобы полосы давали тот же результат, что и изображение целиком.
+    void SetRowOrigin(int row) { m_rowOrigin = row; }
+
+    // Поэлементные операции над результатом фильтра (см. PointOps.h). Если SupportsEpilogue(),
+    // фильтр вызывает их в последнем ядре перед записью, иначе - отдельным проходом по месту.
+    // Собранные ядра сбрасываются: исходник эпилога входит в программу.
+    void SetEpilogue(std::vector<PointOp> ops);
+    [[nodiscard]] bool HasEpilogue() const { return !m_epilogue.empty(); }
+    [[nodiscard]] const std::vector<PointOp>& GetEpilogue() const { return m_epilogue; }
+    [[nodiscard]] virtual bool SupportsEpilogue() const { return false; }
+
+    [[nodiscard]] const std::shared_ptr<OpenCLRuntime>& GetRuntime() const { return m_runtime; }
+
+    static constexpr size_t ASYNC_QUEUE_COUNT = 3; // Загрузка / вычисление / чтение
+
+protected:
+    OpenCLImageFilter();
+
+    // Для IsIdentity() == true: EnqueueOnDevice просто копирует input в output
+    void EnqueueCopy(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                     ElementType elementType);
+
+    // Общий префикс ядер: тип значения Element/Value по -DELEMENT и, если задан -DCHANNELS=1..4,
+    // тип пикселя Pixel, его float-вариант PixelF и макросы чтения/записи/преобразования
+    static const std::string m_pixelTypesSource;
+    // "-DELEMENT=1" или "-DCHANNELS=3 -DELEMENT=1"; channels = 0 - ядро с числом каналов в аргументе
+    static std::string PixelBuildOptions(int channels, ElementType elementType);
+    // Байт на пиксель в __local/__private (3 канала выравниваются до 4, half хранится как float)
+    static size_t PixelStorageBytes(int channels, ElementType elementType);
+
+    // Ядро из m_pixelTypesSource + kernelSource, собранное с buildOptions. Кэшируется по имени
+    // и опциям (имена ядер внутри фильтра уникальны) и освобождается вместе с фильтром.
+    cl_kernel GetKernel(const std::string& kernelSource, const std::string& kernelName, const std::string& buildOptions);
+
+    // Для ядер со слитым эпилогом: исходник ApplyPointOps ставится перед kernelSource, а к опциям
+    // добавляется " -DPOINT_OPS" - тогда EPILOGUE/EPILOGUE_PIXEL в ядре вызывают операции
+    // (EPILOGUE_VALUE - над одним значением, только если AppliesPerValue(GetEpilogue())).
+    // Без эпилога - пустые строки, и макросы ничего не меняют.
+    [[nodiscard]] std::string GetEpilogueSource() const;
+    [[nodiscard]] std::string GetEpilogueBuildOptions(int channels) const;
+    // ops над input -> output одним проходом (ядро PointOps); input и output могут совпадать
+    void EnqueuePointOps(cl_command_queue queue, const std::vector<PointOp>& ops, cl_mem input, cl_mem output,
+                         int width, int height, int channels, ElementType elementType);
+    // Эпилог отдельным проходом input -> output; без эпилога - копия (или ничего, если буфер тот же)
+    void EnqueueEpilogue(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                         ElementType elementType);
+
+    std::shared_ptr<OpenCLRuntime> m_runtime;
+    int m_rowOrigin = 0;
+
+private:
+    size_t m_nextAsyncQueue = 0;
+    std::map<std::string, cl_kernel> m_kernels; // Имя ядра + ' ' + опции сборки -> ядро
+    std::vector<PointOp> m_epilogue;
+};
@@ -0,0 +1,307 @@
+#include "OpenCLRuntime.h"
+#include "OpenCLUtils.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+using Clock = std::chrono::high_resolution_clock;
+using Milliseconds = std::chrono::duration<double, std::milli>;
+
+namespace
+{
+const char* const DEFAULT_LOCAL_SIZE = "default"; // Запись базы: локальный размер выбирает драйвер
+
+// Кандидаты перебора по числу измерений; в 3D третье измерение остается 1
+const size_t LOCAL_SIZES_1D[][1] = {{32}, {64}, {128}, {256}, {512}, {1024}};
+const size_t LOCAL_SIZES_2D[][2] = {{8, 4}, {8, 8}, {16, 4}, {16, 8}, {16, 16}, {32, 4}, {32, 8}, {64, 2}, {64, 4}, {128, 1}, {256, 1}};
+
+std::string FormatLocalSize(cl_uint dims, const size_t* localSize)
+{
+    std::string text;
+    for (cl_uint d = 0; d < dims; ++d) text += (d > 0 ? "x" : "") + std::to_string(localSize[d]);
+    return text;
+}
+
+// "16x8" -> {16, 8}; false для DEFAULT_LOCAL_SIZE и записей с другим числом измерений
+bool ParseLocalSize(const std::string& text, cl_uint dims, size_t* localSize)
+{
+    std::stringstream stream(text);
+    std::string part;
+    cl_uint d = 0;
+    while (std::getline(stream, part, 'x')) {
+        if (d == dims || part.empty() || part.find_first_not_of("0123456789") != std::string::npos) return false;
+        localSize[d++] = std::stoul(part);
+    }
+    return d == dims;
+}
+
+void RoundUpGlobalSize(cl_uint dims, const size_t* globalSize, const size_t* localSize, size_t* roundedSize)
+{
+    for (cl_uint d = 0; d < dims; ++d) roundedSize[d] = (globalSize[d] + localSize[d] - 1) / localSize[d] * localSize[d];
+}
+
+// Имя ядра и опции его программы: варианты одного ядра (-DCHANNELS, -DRADIUS) настраиваются раздельно
+std::string GetKernelKey(cl_kernel kernel, cl_device_id device)
+{
+    size_t nameSize = 0;
+    clGetKernelInfo(kernel, CL_KERNEL_FUNCTION_NAME, 0, nullptr, &nameSize);
+    std::string name(nameSize, '\0');
+    clGetKernelInfo(kernel, CL_KERNEL_FUNCTION_NAME, nameSize, name.data(), nullptr);
+    cl_program program = nullptr;
+    clGetKernelInfo(kernel, CL_KERNEL_PROGRAM, sizeof(program), &program, nullptr);
+    size_t optionsSize = 0;
+    clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_OPTIONS, 0, nullptr, &optionsSize);
+    std::string options(optionsSize, '\0');
+    clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_OPTIONS, optionsSize, options.data(), nullptr);
+    auto trim = [](std::string& text) { text.erase(std::find(text.begin(), text.end(), '\0'), text.end()); };
+    trim(name);
+    trim(options);
+    return options.empty() ? name : name + " " + options;
+}
+}
+
+std::mutex OpenCLRuntime::s_instanceMutex;
+std::weak_ptr<OpenCLRuntime> OpenCLRuntime::s_instance;
+DeviceSelectionPolicy OpenCLRuntime::s_selectionPolicy;
+ProfilingOptions OpenCLRuntime::s_profilingOptions;
+bool OpenCLRuntime::s_zeroCopyEnabled = true;
+bool OpenCLRuntime::s_tuningEnabled = false;
+
+std::shared_ptr<OpenCLRuntime> OpenCLRuntime::Acquire()
+{
+    std::lock_guard<std::mutex> lock(s_instanceMutex);
+    std::shared_ptr<OpenCLRuntime> runtime = s_instance.lock();
+    if (!runtime) {
+        // Конструктор приватный, поэтому std::make_shared недоступен
+        runtime = std::shared_ptr<OpenCLRuntime>(new OpenCLRuntime());
+        s_instance = runtime;
+    }
+    return runtime;
+}
+
+void OpenCLRuntime::Configure(const DeviceSelectionPolicy& policy)
+{
+    std::lock_guard<std::mutex> lock(s_instanceMutex);
+    s_selectionPolicy = policy;
+}
+
+void OpenCLRuntime::ConfigureProfiling(const ProfilingOptions& options)
+{
+    std::lock_guard<std::mutex> lock(s_instanceMutex);
+    s_profilingOptions = options;
+}
+
+void OpenCLRuntime::ConfigureZeroCopy(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(s_instanceMutex);
+    s_zeroCopyEnabled = enabled;
+}
+
+void OpenCLRuntime::ConfigureTuning(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(s_instanceMutex);
+    s_tuningEnabled = enabled;
+}
+
+OpenCLRuntime::OpenCLRuntime()
+        : m_tuning(s_tuningEnabled),
+          m_programCache(ProgramBinaryCache::DefaultDirectory()),
+          m_tuningDatabase(TuningDatabase::DefaultPath()),
+          m_profiler(s_profilingOptions) // Конструктор вызывается из Acquire() под s_instanceMutex
+{
+    try {
+        InitializeOpenCl();
+    } catch (...) {
+        ReleaseOpenCl(); // Деструктор не вызовется для недостроенного объекта
+        throw;
+    }
+}
+
+OpenCLRuntime::~OpenCLRuntime()
+{
+    if (!m_programs.empty()) m_programCache.PrintStats(std::cout);
+    if (m_bufferPool && m_bufferPool->GetStats().misses > 0) m_bufferPool->PrintStats(std::cout);
+    m_profiler.Report(std::cout); // До освобождения очередей: отчет ждет и освобождает события
+    ReleaseOpenCl();
+}
+
+void OpenCLRuntime::InitializeOpenCl()
+{
+    // Вызывается из Acquire() под s_instanceMutex, поэтому s_selectionPolicy читаем без гонки
+    std::vector<OpenCLDeviceInfo> devices = EnumerateOpenCLDevices();
+    m_deviceInfo = SelectOpenCLDevice(devices, s_selectionPolicy);
+    m_deviceId = m_deviceInfo.deviceId;
+    m_deviceIdentity = TuningDatabase::MakeDeviceIdentity(m_deviceId);
+    std::cout << "Selected device [" << m_deviceInfo.index << "]: " << m_deviceInfo.deviceName
+              << " (platform: " << m_deviceInfo.platformName << ")" << std::endl;
+    m_zeroCopy = s_zeroCopyEnabled && m_deviceInfo.hostUnifiedMemory == CL_TRUE;
+    if (m_zeroCopy) std::cout << "Unified host memory: images are processed in place, without copies" << std::endl;
+
+    cl_int err;
+    m_context = clCreateContext(nullptr, 1, &m_deviceId, nullptr, nullptr, &err);
+    CheckCLError(err, "clCreateContext");
+
+    m_commandQueues.push_back(CreateCommandQueue());
+    m_bufferPool = std::make_unique<DeviceBufferPool>(m_context, m_zeroCopy ? CL_MEM_ALLOC_HOST_PTR : 0);
+}
+
+cl_command_queue OpenCLRuntime::CreateCommandQueue()
+{
+    cl_int err;
+    cl_command_queue queue;
+    cl_command_queue_properties properties = m_profiler.IsEnabled() ? CL_QUEUE_PROFILING_ENABLE : 0;
+#if defined(CL_VERSION_2_0) && CL_TARGET_OPENCL_VERSION >= 200
+    cl_queue_properties queueProperties[] = {CL_QUEUE_PROPERTIES, properties, 0};
+    queue = clCreateCommandQueueWithProperties(m_context, m_deviceId, queueProperties, &err);
+#else
+    queue = clCreateCommandQueue(m_context, m_deviceId, properties, &err);
+#endif
+    CheckCLError(err, "clCreateCommandQueue");
+    return queue;
+}
+
+void OpenCLRuntime::ReleaseOpenCl()
+{
+    for (auto& [key, program] : m_programs) clReleaseProgram(program);
+    m_programs.clear();
+    for (cl_command_queue queue : m_commandQueues) {
+        clFinish(queue);
+        clReleaseCommandQueue(queue);
+    }
+    m_commandQueues.clear();
+    m_bufferPool.reset();
+    if (m_context) clReleaseContext(m_context);
+    m_context = nullptr;
+    // clReleaseDevice не нужен для m_deviceId, он получен, а не создан
+}
+
+cl_command_queue OpenCLRuntime::GetQueue(size_t index)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    while (m_commandQueues.size() <= index) {
+        m_commandQueues.push_back(CreateCommandQueue());
+    }
+    return m_commandQueues[index];
+}
+
+cl_program OpenCLRuntime::GetProgram(const std::string& kernelSource, const std::string& buildOptions)
+{
+    const std::string key = buildOptions + '\n' + kernelSource;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_programs.find(key);
+    if (it != m_programs.end()) return it->second;
+
+    cl_program program = m_programCache.GetOrBuild(m_context, m_deviceId, kernelSource, buildOptions);
+    m_programs.emplace(key, program);
+    return program;
+}
+
+cl_kernel OpenCLRuntime::CreateKernel(const std::string& kernelSource, const std::string& kernelName,
+                                      const std::string& buildOptions)
+{
+    cl_program program = GetProgram(kernelSource, buildOptions);
+    cl_int err;
+    cl_kernel kernel = clCreateKernel(program, kernelName.c_str(), &err);
+    CheckCLError(err, "clCreateKernel (" + kernelName + ")");
+    return kernel;
+}
+
+std::optional<std::string> OpenCLRuntime::FindTuned(const std::string& name, const std::string& sizeClass) const
+{
+    return m_tuningDatabase.Find(m_deviceIdentity + "|" + name + "|" + sizeClass);
+}
+
+void OpenCLRuntime::StoreTuned(const std::string& name, const std::string& sizeClass, const std::string& value)
+{
+    m_tuningDatabase.Store(m_deviceIdentity + "|" + name + "|" + sizeClass, value);
+}
+
+double OpenCLRuntime::MeasureKernelMs(cl_command_queue queue, cl_kernel kernel, cl_uint dims, const size_t* globalSize,
+                                      const size_t* localSize, int runs)
+{
+    size_t roundedSize[3];
+    if (localSize) RoundUpGlobalSize(dims, globalSize, localSize, roundedSize);
+    const size_t* launchSize = localSize ? roundedSize : globalSize;
+    // Первый запуск - прогрев; ошибка запуска (размер группы, ресурсы) исключает кандидата
+    if (clEnqueueNDRangeKernel(queue, kernel, dims, nullptr, launchSize, localSize, 0, nullptr, nullptr) != CL_SUCCESS ||
+        clFinish(queue) != CL_SUCCESS) {
+        return std::numeric_limits<double>::infinity();
+    }
+    double bestMs = std::numeric_limits<double>::infinity();
+    for (int run = 0; run < runs; ++run) {
+        auto startTime = Clock::now();
+        cl_int err = clEnqueueNDRangeKernel(queue, kernel, dims, nullptr, launchSize, localSize, 0, nullptr, nullptr);
+        if (err == CL_SUCCESS) err = clFinish(queue);
+        if (err != CL_SUCCESS) return std::numeric_limits<double>::infinity();
+        bestMs = std::min(bestMs, Milliseconds(Clock::now() - startTime).count());
+    }
+    return bestMs;
+}
+
+std::string OpenCLRuntime::TuneLocalSize(cl_command_queue queue, cl_kernel kernel, const std::string& kernelKey,
+                                         const std::string& sizeClass, cl_uint dims, const size_t* globalSize)
+{
+    size_t kernelGroupSize = 0;
+    cl_int err = clGetKernelWorkGroupInfo(kernel, m_deviceId, CL_KERNEL_WORK_GROUP_SIZE, sizeof(kernelGroupSize),
+                                          &kernelGroupSize, nullptr);
+    CheckCLError(err, "clGetKernelWorkGroupInfo (tuning " + kernelKey + ")");
+    const size_t maxGroupSize = std::min(kernelGroupSize, m_deviceInfo.maxWorkGroupSize);
+
+    std::vector<std::vector<size_t>> candidates;
+    if (dims == 1) {
+        for (const auto& size : LOCAL_SIZES_1D) candidates.push_back({size[0]});
+    } else {
+        for (const auto& size : LOCAL_SIZES_2D) {
+            candidates.push_back({size[0], size[1]});
+            if (dims == 3) candidates.back().push_back(1);
+        }
+    }
+
+    // Команды, поставленные до перебора, не должны попасть в замеры
+    clFinish(queue);
+    const double defaultMs = MeasureKernelMs(queue, kernel, dims, globalSize, nullptr);
+    double bestMs = defaultMs;
+    std::string best = DEFAULT_LOCAL_SIZE;
+    for (const std::vector<size_t>& candidate : candidates) {
+        size_t groupSize = 1;
+        for (size_t size : candidate) groupSize *= size;
+        if (groupSize > maxGroupSize) continue;
+        double candidateMs = MeasureKernelMs(queue, kernel, dims, globalSize, candidate.data());
+        if (candidateMs < bestMs) {
+            bestMs = candidateMs;
+            best = FormatLocalSize(dims, candidate.data());
+        }
+    }
+    if (std::isinf(bestMs)) throw std::runtime_error("Tuning failed: " + kernelKey + " does not run with any work-group size");
+
+    std::cout << "Tuned " << kernelKey << " [" << sizeClass << "]: " << best << std::fixed << std::setprecision(3)
+              << " (" << bestMs << " ms, driver default " << defaultMs << " ms)" << std::defaultfloat << std::endl;
+    StoreTuned(kernelKey, sizeClass, best);
+    return best;
+}
+
+cl_int OpenCLRuntime::EnqueueTunedKernel(cl_command_queue queue, cl_kernel kernel, cl_uint dims, const size_t* globalSize,
+                                         cl_event* event)
+{
+    // Без базы и без перебора - обычный запуск, не тратя время на ключ
+    if (!m_tuning && m_tuningDatabase.IsEmpty()) {
+        return clEnqueueNDRangeKernel(queue, kernel, dims, nullptr, globalSize, nullptr, 0, nullptr, event);
+    }
+    const std::string kernelKey = GetKernelKey(kernel, m_deviceId);
+    const std::string sizeClass = TuningDatabase::MakeSizeClass(dims, globalSize);
+    std::optional<std::string> tuned = FindTuned(kernelKey, sizeClass);
+    if (!tuned && m_tuning) tuned = TuneLocalSize(queue, kernel, kernelKey, sizeClass, dims, globalSize);
+
+    size_t localSize[3];
+    if (!tuned || dims > 3 || !ParseLocalSize(*tuned, dims, localSize)) {
+        return clEnqueueNDRangeKernel(queue, kernel, dims, nullptr, globalSize, nullptr, 0, nullptr, event);
+    }
+    size_t roundedSize[3];
+    RoundUpGlobalSize(dims, globalSize, localSize, roundedSize);
+    return clEnqueueNDRangeKernel(queue, kernel, dims, nullptr, roundedSize, localSize, 0, nullptr, event);
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include "CommandProfiler.h"
+#include "DeviceBufferPool.h"
+#include "OpenCLDevices.h"
+#include "ProgramBinaryCache.h"
+#include "TuningDatabase.h"
+#include <CL/cl.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Общий для всего процесса рантайм OpenCL: устройство, контекст, очереди и реестр программ.
+// Все фильтры и MatrixMultiplier получают его через Acquire(), поэтому выбор платформы,
+// создание контекста и сборка одинаковых программ выполняются один раз на процесс.
+// Экземпляр живет, пока на него есть хотя бы одна ссылка (std::shared_ptr).
+class OpenCLRuntime
+{
+public:
+    static std::shared_ptr<OpenCLRuntime> Acquire();
+    // Политика выбора устройства; действует для экземпляров, созданных после вызова.
+    static void Configure(const DeviceSelectionPolicy& policy);
+    // Профилирование команд; как и Configure, действует на экземпляры, созданные после вызова
+    static void ConfigureProfiling(const ProfilingOptions& options);
+    // Буферы поверх памяти хоста на устройствах с общей памятью (по умолчанию включено)
+    static void ConfigureZeroCopy(bool enabled);
+    // Автонастройка (--tune): ядро без записи в TuningDatabase при первом запуске перебирает
+    // локальные размеры, лучший сохраняется в базе и используется следующими запусками программы
+    static void ConfigureTuning(bool enabled);
+
+    ~OpenCLRuntime();
+    OpenCLRuntime(const OpenCLRuntime&) = delete;
+    OpenCLRuntime& operator=(const OpenCLRuntime&) = delete;
+
+    [[nodiscard]] cl_device_id GetDevice() const { return m_deviceId; }
+    [[nodiscard]] cl_context GetContext() const { return m_context; }
+    [[nodiscard]] const OpenCLDeviceInfo& GetDeviceInfo() const { return m_deviceInfo; }
+    // Очередь с индексом 0 - основная. Дополнительные in-order очереди создаются по требованию.
+    cl_command_queue GetQueue(size_t index = 0);
+
+    // true - устройство работает с памятью хоста напрямую: входы и выходы оборачиваются
+    // в HostMappedBuffer вместо копий, а пул выделяет буферы с CL_MEM_ALLOC_HOST_PTR
+    [[nodiscard]] bool UsesZeroCopy() const { return m_zeroCopy; }
+
+    // Общий для всех фильтров пул буферов устройства
+    DeviceBufferPool& GetBufferPool() { return *m_bufferPool; }
+    // Отчет печатается при разрушении рантайма
+    CommandProfiler& GetProfiler() { return m_profiler; }
+
+    // Программа собирается один раз для каждой пары (исходник, опции сборки) и принадлежит рантайму.
+    // Между запусками бинарники переживают в ProgramBinaryCache.
+    cl_program GetProgram(const std::string& kernelSource, const std::string& buildOptions = "");
+    // Ядро принадлежит вызывающему и освобождается им через clReleaseKernel.
+    cl_kernel CreateKernel(const std::string& kernelSource, const std::string& kernelName,
+                           const std::string& buildOptions = "");
+
+    // clEnqueueNDRangeKernel с локальным размером из базы настройки для этого устройства, ядра
+    // (имя и опции сборки) и класса размера; без записи - выбор драйвера, как с nullptr.
+    // Глобальный размер дополняется до кратного локальному, поэтому ядро обязано проверять границы.
+    // При переборе (IsTuning) ядро выполняется несколько раз: оно не должно писать в свой вход.
+    cl_int EnqueueTunedKernel(cl_command_queue queue, cl_kernel kernel, cl_uint dims, const size_t* globalSize,
+                              cl_event* event);
+
+    [[nodiscard]] bool IsTuning() const { return m_tuning; }
+    // Записи базы настройки текущего устройства; name - ядро или иной настраиваемый параметр
+    [[nodiscard]] std::optional<std::string> FindTuned(const std::string& name, const std::string& sizeClass) const;
+    void StoreTuned(const std::string& name, const std::string& sizeClass, const std::string& value);
+    // Лучшее из runs времен ядра в мс после прогрева (localSize == nullptr - выбор драйвера);
+    // бесконечность, если с такими размерами ядро не запускается
+    double MeasureKernelMs(cl_command_queue queue, cl_kernel kernel, cl_uint dims, const size_t* globalSize,
+                           const size_t* localSize, int runs = 3);
+
+private:
+    OpenCLRuntime();
+
+    void InitializeOpenCl();
+    void ReleaseOpenCl();
+    cl_command_queue CreateCommandQueue();
+    // Перебор локальных размеров для EnqueueTunedKernel; возвращает записанное в базу значение
+    std::string TuneLocalSize(cl_command_queue queue, cl_kernel kernel, const std::string& kernelKey,
+                              const std::string& sizeClass, cl_uint dims, const size_t* globalSize);
+
+    OpenCLDeviceInfo m_deviceInfo;
+    cl_device_id m_deviceId = nullptr;
+    cl_context m_context = nullptr;
+    bool m_zeroCopy = false;
+    bool m_tuning = false;
+    std::string m_deviceIdentity; // Префикс ключей TuningDatabase
+    std::vector<cl_command_queue> m_commandQueues;
+    std::unique_ptr<DeviceBufferPool> m_bufferPool; // Освобождается до контекста
+    std::map<std::string, cl_program> m_programs; // Ключ: опции сборки + '\n' + исходник
+    ProgramBinaryCache m_programCache;
+    TuningDatabase m_tuningDatabase;
+    CommandProfiler m_profiler;
+    std::mutex m_mutex;
+
+    static std::mutex s_instanceMutex;
+    static std::weak_ptr<OpenCLRuntime> s_instance;
+    static DeviceSelectionPolicy s_selectionPolicy;
+    static ProfilingOptions s_profilingOptions;
+    static bool s_zeroCopyEnabled;
+    static bool s_tuningEnabled;
+};
@@ -13,16 +13,27 @@ void CheckCLError(cl_int errCode, const std::string& operation)
     }
 }
 
-cl_program CreateProgramWithSource(cl_context context, cl_device_id device, const std::string& kernelSource)
+std::string GetPlatformInfoString(cl_platform_id platform, cl_platform_info param)
 {
-    cl_int err;
-    const char* sourceStr = kernelSource.c_str();
-    size_t sourceSize = kernelSource.length();
+    size_t size = 0;
+    clGetPlatformInfo(platform, param, 0, nullptr, &size);
+    std::string value(size, '\0');
+    clGetPlatformInfo(platform, param, size, value.data(), nullptr);
+    return value.c_str(); // Отрезаем завершающий '\0'
+}
 
-    cl_program program = clCreateProgramWithSource(context, 1, &sourceStr, &sourceSize, &err);
-    CheckCLError(err, "clCreateProgramWithSource");
+std::string GetDeviceInfoString(cl_device_id device, cl_device_info param)
+{
+    size_t size = 0;
+    clGetDeviceInfo(device, param, 0, nullptr, &size);
+    std::string value(size, '\0');
+    clGetDeviceInfo(device, param, size, value.data(), nullptr);
+    return value.c_str();
+}
 
-    err = clBuildProgram(program, 1, &device, nullptr, nullptr, nullptr);
+void BuildProgram(cl_program program, cl_device_id device, const std::string& buildOptions)
+{
+    cl_int err = clBuildProgram(program, 1, &device, buildOptions.empty() ? nullptr : buildOptions.c_str(), nullptr, nullptr);
     if (err != CL_SUCCESS)
     {
         size_t logSize;
@@ -34,5 +45,23 @@ cl_program CreateProgramWithSource(cl_context context, cl_device_id device, cons
         std::cerr << "------------------------------" << std::endl;
         CheckCLError(err, "clBuildProgram"); // Это вызовет исключение
     }
+}
+
+cl_program CreateProgramWithSource(cl_context context, cl_device_id device, const std::string& kernelSource,
+                                   const std::string& buildOptions)
+{
+    cl_int err;
+    const char* sourceStr = kernelSource.c_str();
+    size_t sourceSize = kernelSource.length();
+
+    cl_program program = clCreateProgramWithSource(context, 1, &sourceStr, &sourceSize, &err);
+    CheckCLError(err, "clCreateProgramWithSource");
+
+    try {
+        BuildProgram(program, device, buildOptions);
+    } catch (...) {
+        clReleaseProgram(program);
+        throw;
+    }
     return program;
 }
@@ -7,5 +7,13 @@
 // Вспомогательная функция для проверки ошибок OpenCL
 void CheckCLError(cl_int errCode, const std::string& operation);
 
+// Строковые параметры платформы/устройства (имя, версия драйвера и т.п.)
+std::string GetPlatformInfoString(cl_platform_id platform, cl_platform_info param);
+std::string GetDeviceInfoString(cl_device_id device, cl_device_info param);
+
+// Собирает программу для устройства; при ошибке печатает лог сборки и бросает исключение
+void BuildProgram(cl_program program, cl_device_id device, const std::string& buildOptions);
+
 // Вспомогательная функция для загрузки и сборки программы OpenCL
-cl_program CreateProgramWithSource(cl_context context, cl_device_id device, const std::string& kernelSource);
+cl_program CreateProgramWithSource(cl_context context, cl_device_id device, const std::string& kernelSource,
+                                   const std::string& buildOptions = "");
@@ -0,0 +1,153 @@
+#include "PixelFormat.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+// binary16 <-> binary32 без аппаратной поддержки: half-значения на хосте только конвертируются
+float HalfToFloat(uint16_t half)
+{
+    uint32_t sign = static_cast<uint32_t>(half & 0x8000u) << 16;
+    int exponent = (half >> 10) & 0x1f;
+    uint32_t mantissa = half & 0x3ffu;
+    uint32_t bits;
+    if (exponent == 0x1f) {
+        bits = sign | 0x7f800000u | (mantissa << 13); // Inf / NaN
+    } else if (exponent != 0) {
+        bits = sign | (static_cast<uint32_t>(exponent + 127 - 15) << 23) | (mantissa << 13);
+    } else if (mantissa == 0) {
+        bits = sign;
+    } else {
+        // Денормализованное half - нормализованное float
+        exponent = 127 - 15 + 1;
+        while ((mantissa & 0x400u) == 0) {
+            mantissa <<= 1;
+            --exponent;
+        }
+        bits = sign | (static_cast<uint32_t>(exponent) << 23) | ((mantissa & 0x3ffu) << 13);
+    }
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+uint16_t FloatToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+    int exponent = static_cast<int>((bits >> 23) & 0xffu) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffffu;
+    if (((bits >> 23) & 0xffu) == 0xffu) return static_cast<uint16_t>(sign | 0x7c00u | (mantissa ? 0x200u : 0u));
+    if (exponent >= 0x1f) return static_cast<uint16_t>(sign | 0x7c00u); // Переполнение - бесконечность
+    if (exponent <= 0) {
+        if (exponent < -10) return sign;
+        // Денормализованное half: неявная единица становится явной, округление к ближайшему четному
+        mantissa |= 0x800000u;
+        int shift = 14 - exponent;
+        uint32_t halfMantissa = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (halfMantissa & 1u))) ++halfMantissa;
+        return static_cast<uint16_t>(sign | halfMantissa);
+    }
+    uint32_t result = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1fffu;
+    if (remainder > 0x1000u || (remainder == 0x1000u && (result & 1u))) ++result; // Перенос в порядок тоже верен
+    return static_cast<uint16_t>(sign | result);
+}
+
+// Значение в нормированной шкале (1.0 - максимум целого типа)
+float LoadNormalized(const unsigned char* data, size_t index, ElementType type)
+{
+    switch (type) {
+        case ElementType::UCHAR:
+            return static_cast<float>(data[index]) / 255.0f;
+        case ElementType::USHORT: {
+            uint16_t value;
+            std::memcpy(&value, data + index * sizeof(value), sizeof(value));
+            return static_cast<float>(value) / 65535.0f;
+        }
+        case ElementType::HALF: {
+            uint16_t value;
+            std::memcpy(&value, data + index * sizeof(value), sizeof(value));
+            return HalfToFloat(value);
+        }
+        default: {
+            float value;
+            std::memcpy(&value, data + index * sizeof(value), sizeof(value));
+            return value;
+        }
+    }
+}
+
+void StoreNormalized(float value, unsigned char* data, size_t index, ElementType type)
+{
+    switch (type) {
+        case ElementType::UCHAR:
+            data[index] = static_cast<unsigned char>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+            return;
+        case ElementType::USHORT: {
+            auto converted = static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+            std::memcpy(data + index * sizeof(converted), &converted, sizeof(converted));
+            return;
+        }
+        case ElementType::HALF: {
+            uint16_t converted = FloatToHalf(value);
+            std::memcpy(data + index * sizeof(converted), &converted, sizeof(converted));
+            return;
+        }
+        default:
+            std::memcpy(data + index * sizeof(value), &value, sizeof(value));
+            return;
+    }
+}
+}
+
+size_t GetElementSize(ElementType type)
+{
+    switch (type) {
+        case ElementType::UCHAR: return 1;
+        case ElementType::USHORT: return 2;
+        case ElementType::HALF: return 2;
+        default: return 4;
+    }
+}
+
+const char* GetElementTypeName(ElementType type)
+{
+    switch (type) {
+        case ElementType::UCHAR: return "u8";
+        case ElementType::USHORT: return "u16";
+        case ElementType::HALF: return "f16";
+        default: return "f32";
+    }
+}
+
+ElementType ParseElementType(const std::string& name)
+{
+    for (ElementType type : {ElementType::UCHAR, ElementType::USHORT, ElementType::HALF, ElementType::FLOAT}) {
+        if (name == GetElementTypeName(type)) return type;
+    }
+    throw std::runtime_error("Unknown element type '" + name + "' (u8, u16, f16, f32)");
+}
+
+PixelBuffer ConvertElements(const PixelBuffer& pixels, ElementType from, ElementType to)
+{
+    if (from == to) return pixels;
+    size_t count = pixels.size() / GetElementSize(from);
+    PixelBuffer converted(count * GetElementSize(to));
+    if (from == ElementType::UCHAR && to == ElementType::USHORT) {
+        // Точный частный случай: 255 * 257 = 65535
+        for (size_t i = 0; i < count; ++i) {
+            auto value = static_cast<uint16_t>(pixels[i] * 257);
+            std::memcpy(converted.data() + i * sizeof(value), &value, sizeof(value));
+        }
+        return converted;
+    }
+    for (size_t i = 0; i < count; ++i) StoreNormalized(LoadNormalized(pixels.data(), i, from), converted.data(), i, to);
+    return converted;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "HostMemory.h"
+#include <cstddef>
+#include <string>
+
+// Тип одного значения канала. Целые типы используют весь свой диапазон (0..255, 0..65535),
+// half и float хранят нормированные значения (1.0 - белый; в HDR бывает и больше).
+// В памяти хоста и устройства значения лежат как есть: 16-битное изображение занимает вдвое
+// больше 8-битного, а half - вдвое меньше float.
+enum class ElementType
+{
+    UCHAR,  // 8 бит: обычные PNG/JPEG/BMP
+    USHORT, // 16 бит: 16-битные PNG
+    HALF,   // IEEE 754 binary16: HDR с половинной пропускной способностью
+    FLOAT   // Radiance HDR (.hdr)
+};
+
+[[nodiscard]] size_t GetElementSize(ElementType type);
+// "u8", "u16", "f16", "f32"
+[[nodiscard]] const char* GetElementTypeName(ElementType type);
+// Обратное к GetElementTypeName; неизвестное имя - исключение
+[[nodiscard]] ElementType ParseElementType(const std::string& name);
+
+// Пересчет значений из одного типа в другой с учетом диапазонов; при сужении - насыщение и округление
+[[nodiscard]] PixelBuffer ConvertElements(const PixelBuffer& pixels, ElementType from, ElementType to);
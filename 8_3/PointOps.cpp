@@ -0,0 +1,193 @@
+#include "PointOps.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+const char* const POINT_OP_NAMES[] = {"brightness", "contrast", "gamma", "threshold", "invert", "swizzle"};
+
+// Литерал float для OpenCL C: "2" без точки там не float
+std::string FloatLiteral(float value)
+{
+    std::ostringstream literal;
+    literal << std::showpoint << std::setprecision(9) << value << 'f';
+    return literal.str();
+}
+
+bool IsAlpha(int channel, int channels)
+{
+    return (channels == 2 && channel == 1) || (channels == 4 && channel == 3);
+}
+}
+
+bool IsPointOp(const std::string& name)
+{
+    return std::find(std::begin(POINT_OP_NAMES), std::end(POINT_OP_NAMES), name) != std::end(POINT_OP_NAMES);
+}
+
+PointOp ParsePointOp(const std::string& name, const std::string& argument)
+{
+    auto it = std::find(std::begin(POINT_OP_NAMES), std::end(POINT_OP_NAMES), name);
+    if (it == std::end(POINT_OP_NAMES)) throw std::runtime_error("Unknown point operation: " + name);
+    PointOp op;
+    op.type = static_cast<PointOpType>(it - std::begin(POINT_OP_NAMES));
+
+    if (op.type == PointOpType::INVERT) {
+        if (!argument.empty()) throw std::runtime_error("invert takes no argument, got '" + argument + "'");
+        return op;
+    }
+    if (argument.empty()) throw std::runtime_error(name + " needs an argument, e.g. " + name + (op.type == PointOpType::SWIZZLE ? ":bgr" : ":1.5"));
+    if (op.type == PointOpType::SWIZZLE) {
+        static const std::string letters = "rgbaxyzw";
+        if (argument.size() > 4) throw std::runtime_error("swizzle order '" + argument + "' is longer than 4 channels");
+        for (char letter : argument) {
+            size_t index = letters.find(letter);
+            if (index == std::string::npos) throw std::runtime_error("swizzle order '" + argument + "' may contain only rgba or xyzw");
+            op.order += static_cast<char>('0' + index % 4);
+        }
+        return op;
+    }
+
+    size_t parsed = 0;
+    try {
+        op.amount = std::stof(argument, &parsed);
+    } catch (const std::logic_error&) {
+        parsed = 0;
+    }
+    if (parsed != argument.size()) throw std::runtime_error(name + " argument must be a number, got '" + argument + "'");
+    if (op.type == PointOpType::GAMMA && op.amount <= 0.0f) throw std::runtime_error("gamma must be positive, got " + argument);
+    return op;
+}
+
+std::string DescribePointOps(const std::vector<PointOp>& ops)
+{
+    std::ostringstream description;
+    for (size_t i = 0; i < ops.size(); ++i) {
+        const PointOp& op = ops[i];
+        description << (i > 0 ? ", " : "") << POINT_OP_NAMES[static_cast<int>(op.type)];
+        if (op.type == PointOpType::SWIZZLE) {
+            description << ' ';
+            for (char index : op.order) description << "rgba"[index - '0'];
+        } else if (op.type != PointOpType::INVERT) {
+            description << ' ' << op.amount;
+        }
+    }
+    return description.str();
+}
+
+void ValidatePointOps(const std::vector<PointOp>& ops, int channels)
+{
+    for (const PointOp& op : ops) {
+        if (op.type != PointOpType::SWIZZLE) continue;
+        if (static_cast<int>(op.order.size()) != channels) {
+            throw std::runtime_error("swizzle order of " + std::to_string(op.order.size()) + " channels applied to a " +
+                                     std::to_string(channels) + "-channel image");
+        }
+        for (char index : op.order) {
+            if (index - '0' >= channels) throw std::runtime_error("swizzle refers to a channel the image does not have");
+        }
+    }
+}
+
+bool AppliesPerValue(const std::vector<PointOp>& ops)
+{
+    return std::none_of(ops.begin(), ops.end(), [](const PointOp& op) { return op.type == PointOpType::SWIZZLE; });
+}
+
+std::string GeneratePointOpsSource(const std::vector<PointOp>& ops)
+{
+    // Выражение операции над value типа type (PixelF или float); swizzle - только у пикселя
+    auto expression = [](const PointOp& op, const std::string& type) {
+        const std::string amount = FloatLiteral(op.amount);
+        switch (op.type) {
+            case PointOpType::BRIGHTNESS: return "value + " + amount;
+            case PointOpType::CONTRAST: return "(value - 0.5f) * " + amount + " + 0.5f";
+            case PointOpType::GAMMA:
+                return "pow(fmax(value, (" + type + ")(0.0f)), (" + type + ")(" + FloatLiteral(1.0f / op.amount) + "))";
+            case PointOpType::THRESHOLD: return "step(" + amount + ", value)";
+            case PointOpType::INVERT: return std::string("1.0f - value");
+            case PointOpType::SWIZZLE: break;
+        }
+        return std::string("value");
+    };
+
+    // Каждая операция, кроме swizzle, считается для всего вектора, а альфа возвращается прежней
+    std::ostringstream source;
+    source << R"CLC(
+#if CHANNELS == 2
+#define KEEP_ALPHA(old, result) ((float2)((result).x, (old).y))
+#elif CHANNELS == 4
+#define KEEP_ALPHA(old, result) ((float4)((result).xyz, (old).w))
+#else
+#define KEEP_ALPHA(old, result) (result)
+#endif
+
+PixelF ApplyPointOps(PixelF value)
+{
+    value /= ELEMENT_SCALE;
+)CLC";
+    for (const PointOp& op : ops) {
+        if (op.type == PointOpType::SWIZZLE) {
+            // Длину проверяет ValidatePointOps; у скаляра (1 канал) перестанавливать нечего
+            source << "#if CHANNELS > 1\n    value = value.s" << op.order << ";\n#endif\n";
+        } else {
+            source << "    value = KEEP_ALPHA(value, " << expression(op, "PixelF") << ");\n";
+        }
+    }
+    source << R"CLC(    return value * ELEMENT_SCALE;
+}
+)CLC";
+
+    if (AppliesPerValue(ops)) {
+        // Для ядер, которые ведут один канал пикселя (EPILOGUE_VALUE): без swizzle каналы независимы
+        source << R"CLC(
+float ApplyPointOpsValue(float value, int channel)
+{
+#if CHANNELS == 2 || CHANNELS == 4
+    if (channel == CHANNELS - 1) return value;
+#endif
+    value /= ELEMENT_SCALE;
+)CLC";
+        for (const PointOp& op : ops) source << "    value = " << expression(op, "float") << ";\n";
+        source << R"CLC(    return value * ELEMENT_SCALE;
+}
+)CLC";
+    }
+
+    source << R"CLC(
+__kernel void PointOps(__global const Element* input, __global Element* output, const int numPixels)
+{
+    int gid = get_global_id(0);
+    if (gid >= numPixels) return;
+    STORE_PIXEL(TO_PIXEL(ApplyPointOps(TO_FLOAT(LOAD_PIXEL(gid, input)))), gid, output);
+}
+)CLC";
+    return source.str();
+}
+
+void ApplyPointOps(const std::vector<PointOp>& ops, float* pixel, int channels)
+{
+    for (const PointOp& op : ops) {
+        if (op.type == PointOpType::SWIZZLE) {
+            float original[4];
+            std::copy(pixel, pixel + channels, original);
+            for (int c = 0; c < channels; ++c) pixel[c] = original[op.order[c] - '0'];
+            continue;
+        }
+        for (int c = 0; c < channels; ++c) {
+            if (IsAlpha(c, channels)) continue;
+            float& value = pixel[c];
+            switch (op.type) {
+                case PointOpType::BRIGHTNESS: value += op.amount; break;
+                case PointOpType::CONTRAST: value = (value - 0.5f) * op.amount + 0.5f; break;
+                case PointOpType::GAMMA: value = std::pow(std::max(value, 0.0f), 1.0f / op.amount); break;
+                case PointOpType::THRESHOLD: value = value >= op.amount ? 1.0f : 0.0f; break;
+                case PointOpType::INVERT: value = 1.0f - value; break;
+                default: break;
+            }
+        }
+    }
+}
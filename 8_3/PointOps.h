@@ -0,0 +1,45 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Поэлементные операции над пикселем (яркость, контраст, гамма и т.п.). Цепочка таких операций
+// собирается в одну функцию OpenCL, поэтому стоит один проход по памяти, а после размытия или
+// медианы - ни одного: функция вызывается перед записью результата (см. OpenCLImageFilter::SetEpilogue).
+// Значения нормированы: 1.0 - максимум целого типа (255, 65535), half/float берутся как есть.
+// Альфа-канал (второй из двух, четвертый из четырех) меняет только swizzle.
+enum class PointOpType
+{
+    BRIGHTNESS, // v + amount
+    CONTRAST,   // (v - 0.5) * amount + 0.5
+    GAMMA,      // v^(1 / amount)
+    THRESHOLD,  // v >= amount ? 1 : 0
+    INVERT,     // 1 - v
+    SWIZZLE     // Перестановка каналов: order = "bgra", "rrr" и т.п.
+};
+
+struct PointOp
+{
+    PointOpType type;
+    float amount = 0.0f;
+    std::string order; // Для SWIZZLE: индексы каналов 0..3
+};
+
+// brightness, contrast, gamma, threshold, invert, swizzle
+[[nodiscard]] bool IsPointOp(const std::string& name);
+// Разбирает "gamma" + "2.2", "swizzle" + "bgr"; неизвестное имя или аргумент - исключение
+[[nodiscard]] PointOp ParsePointOp(const std::string& name, const std::string& argument);
+// "brightness 0.1, gamma 2.2" - для имен фильтров
+[[nodiscard]] std::string DescribePointOps(const std::vector<PointOp>& ops);
+// Исключение, если операции нельзя применить к пикселю из channels каналов (swizzle другой длины)
+void ValidatePointOps(const std::vector<PointOp>& ops, int channels);
+
+// Без swizzle каждое значение меняется независимо от остальных каналов пикселя
+[[nodiscard]] bool AppliesPerValue(const std::vector<PointOp>& ops);
+
+// Исходник OpenCL: PixelF ApplyPointOps(PixelF value) в шкале Element и ядро PointOps
+// (input -> output, можно по месту). Собирается после m_pixelTypesSource с -DCHANNELS и -DPOINT_OPS.
+// Если AppliesPerValue, есть и float ApplyPointOpsValue(float value, int channel) для одного значения.
+[[nodiscard]] std::string GeneratePointOpsSource(const std::vector<PointOp>& ops);
+
+// То же на хосте для одного пикселя из channels нормированных значений (CPU-бэкенд)
+void ApplyPointOps(const std::vector<PointOp>& ops, float* pixel, int channels);
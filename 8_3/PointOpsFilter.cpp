@@ -0,0 +1,17 @@
+#include "PointOpsFilter.h"
+#include <utility>
+
+PointOpsFilter::PointOpsFilter(std::vector<PointOp> ops)
+        : m_ops(std::move(ops))
+{
+}
+
+void PointOpsFilter::EnqueueOnDevice(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height,
+                                     int channels, ElementType elementType)
+{
+    EnqueuePointOps(queue, m_ops, input, output, width, height, channels, elementType);
+}
+
+void PointOpsFilter::SetEffectRadius(int /*radius*/)
+{
+}
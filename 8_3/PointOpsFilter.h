@@ -0,0 +1,23 @@
+#pragma once
+#include "OpenCLImageFilter.h"
+#include "PointOps.h"
+#include <string>
+#include <vector>
+
+// Цепочка поэлементных операций одним ядром (см. PointOps.h). FilterPipeline создает такой фильтр,
+// только если операции не удалось слить с предыдущим фильтром через SetEpilogue.
+class PointOpsFilter : public OpenCLImageFilter
+{
+public:
+    explicit PointOpsFilter(std::vector<PointOp> ops);
+
+    void EnqueueOnDevice(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                         ElementType elementType) override;
+    void SetEffectRadius(int radius) override; // Радиуса нет: параметры у каждой операции свои
+    [[nodiscard]] std::string GetName() const override { return "Point Ops (" + DescribePointOps(m_ops) + ")"; }
+    [[nodiscard]] bool IsIdentity() const override { return m_ops.empty(); }
+    [[nodiscard]] int GetHaloRows() const override { return 0; }
+
+private:
+    std::vector<PointOp> m_ops;
+};
@@ -0,0 +1,201 @@
+#include "ProgramBinaryCache.h"
+#include "OpenCLUtils.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::high_resolution_clock;
+using Milliseconds = std::chrono::duration<double, std::milli>;
+
+namespace
+{
+const char CACHE_FILE_MAGIC[8] = {'C', 'L', 'B', 'I', 'N', '0', '0', '1'};
+
+// FNV-1a: для имени файла достаточно, полная строка-ключ все равно сверяется при загрузке
+uint64_t HashString(const std::string& text)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+template <typename T>
+void WritePod(std::ostream& out, const T& value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool ReadPod(std::istream& in, T& value)
+{
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+}
+
+ProgramBinaryCache::ProgramBinaryCache(fs::path directory)
+        : m_directory(std::move(directory))
+{
+    if (m_directory.empty()) return;
+    std::error_code ec;
+    fs::create_directories(m_directory, ec);
+    if (ec) {
+        std::cerr << "Warning: program cache disabled, cannot create " << m_directory << ": " << ec.message() << std::endl;
+        m_directory.clear();
+    }
+}
+
+fs::path ProgramBinaryCache::DefaultDirectory()
+{
+    const char* envDir = std::getenv("OPENCL_CACHE_DIR");
+    if (envDir != nullptr) {
+        std::string value = envDir;
+        if (value.empty() || value == "off" || value == "0") return {};
+        return value;
+    }
+    std::error_code ec;
+    fs::path tempDir = fs::temp_directory_path(ec);
+    if (ec) return {};
+    return tempDir / "8_3_cl_cache";
+}
+
+std::string ProgramBinaryCache::MakeIdentity(cl_device_id device, const std::string& kernelSource,
+                                             const std::string& buildOptions)
+{
+    cl_platform_id platform = nullptr;
+    clGetDeviceInfo(device, CL_DEVICE_PLATFORM, sizeof(platform), &platform, nullptr);
+
+    std::ostringstream identity;
+    identity << "platform=" << GetPlatformInfoString(platform, CL_PLATFORM_NAME)
+             << " " << GetPlatformInfoString(platform, CL_PLATFORM_VERSION) << "\n"
+             << "device=" << GetDeviceInfoString(device, CL_DEVICE_NAME) << "\n"
+             << "driver=" << GetDeviceInfoString(device, CL_DRIVER_VERSION) << "\n"
+             << "options=" << buildOptions << "\n"
+             << "source=" << std::hex << HashString(kernelSource) << std::dec << ":" << kernelSource.size() << "\n";
+    return identity.str();
+}
+
+cl_program ProgramBinaryCache::GetOrBuild(cl_context context, cl_device_id device,
+                                          const std::string& kernelSource, const std::string& buildOptions)
+{
+    if (!IsEnabled()) {
+        return CreateProgramWithSource(context, device, kernelSource, buildOptions);
+    }
+
+    const std::string identity = MakeIdentity(device, kernelSource, buildOptions);
+    std::ostringstream fileName;
+    fileName << std::hex << std::setw(16) << std::setfill('0') << HashString(identity) << ".clbin";
+    const fs::path file = m_directory / fileName.str();
+
+    auto loadStart = Clock::now();
+    double storedBuildMs = 0.0;
+    cl_program program = TryLoad(file, identity, context, device, buildOptions, storedBuildMs);
+    if (program != nullptr) {
+        double loadMs = Milliseconds(Clock::now() - loadStart).count();
+        ++m_hits;
+        m_savedMs += std::max(0.0, storedBuildMs - loadMs);
+        return program;
+    }
+
+    ++m_misses;
+    auto buildStart = Clock::now();
+    program = CreateProgramWithSource(context, device, kernelSource, buildOptions);
+    double buildMs = Milliseconds(Clock::now() - buildStart).count();
+    Store(file, identity, program, buildMs);
+    return program;
+}
+
+cl_program ProgramBinaryCache::TryLoad(const fs::path& file, const std::string& identity,
+                                       cl_context context, cl_device_id device, const std::string& buildOptions,
+                                       double& storedBuildMs)
+{
+    std::ifstream in(file, std::ios::binary);
+    if (!in) return nullptr;
+
+    char magic[sizeof(CACHE_FILE_MAGIC)];
+    uint64_t identitySize = 0;
+    bool valid = in.read(magic, sizeof(magic)) && std::equal(magic, magic + sizeof(magic), CACHE_FILE_MAGIC)
+                 && ReadPod(in, identitySize) && identitySize == identity.size();
+    std::string storedIdentity(valid ? identitySize : 0, '\0');
+    uint64_t binarySize = 0;
+    valid = valid && in.read(storedIdentity.data(), static_cast<std::streamsize>(identitySize))
+            && storedIdentity == identity
+            && ReadPod(in, storedBuildMs) && ReadPod(in, binarySize) && binarySize > 0;
+    std::vector<unsigned char> binary(valid ? binarySize : 0);
+    valid = valid && in.read(reinterpret_cast<char*>(binary.data()), static_cast<std::streamsize>(binarySize));
+    in.close();
+
+    cl_program program = nullptr;
+    if (valid) {
+        cl_int binaryStatus = CL_SUCCESS;
+        cl_int err;
+        const unsigned char* binaryPtr = binary.data();
+        size_t size = binary.size();
+        program = clCreateProgramWithBinary(context, 1, &device, &size, &binaryPtr, &binaryStatus, &err);
+        if (err != CL_SUCCESS || binaryStatus != CL_SUCCESS) {
+            if (program) clReleaseProgram(program);
+            program = nullptr;
+        } else if (clBuildProgram(program, 1, &device, buildOptions.empty() ? nullptr : buildOptions.c_str(),
+                                  nullptr, nullptr) != CL_SUCCESS) {
+            clReleaseProgram(program);
+            program = nullptr;
+        }
+    }
+
+    if (program == nullptr) {
+        // Поврежденный, чужой или отвергнутый драйвером файл: удаляем, он будет перезаписан после сборки
+        std::error_code ec;
+        fs::remove(file, ec);
+    }
+    return program;
+}
+
+void ProgramBinaryCache::Store(const fs::path& file, const std::string& identity, cl_program program, double buildMs)
+{
+    size_t binarySize = 0;
+    cl_int err = clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES, sizeof(binarySize), &binarySize, nullptr);
+    if (err != CL_SUCCESS || binarySize == 0) return; // Драйвер не отдает бинарники - просто не кэшируем
+
+    std::vector<unsigned char> binary(binarySize);
+    unsigned char* binaryPtr = binary.data();
+    err = clGetProgramInfo(program, CL_PROGRAM_BINARIES, sizeof(binaryPtr), &binaryPtr, nullptr);
+    if (err != CL_SUCCESS) return;
+
+    // Пишем во временный файл и переименовываем, чтобы параллельный процесс не прочитал половину файла
+    fs::path tempFile = file;
+    tempFile += ".tmp";
+    {
+        std::ofstream out(tempFile, std::ios::binary | std::ios::trunc);
+        if (!out) return;
+        out.write(CACHE_FILE_MAGIC, sizeof(CACHE_FILE_MAGIC));
+        WritePod(out, static_cast<uint64_t>(identity.size()));
+        out.write(identity.data(), static_cast<std::streamsize>(identity.size()));
+        WritePod(out, buildMs);
+        WritePod(out, static_cast<uint64_t>(binarySize));
+        out.write(reinterpret_cast<const char*>(binary.data()), static_cast<std::streamsize>(binarySize));
+        if (!out) return;
+    }
+    std::error_code ec;
+    fs::rename(tempFile, file, ec);
+    if (ec) fs::remove(tempFile, ec);
+}
+
+void ProgramBinaryCache::PrintStats(std::ostream& out) const
+{
+    if (!IsEnabled()) {
+        out << "Program cache: disabled" << std::endl;
+        return;
+    }
+    out << "Program cache: hits=" << m_hits << " misses=" << m_misses
+        << " saved=" << std::fixed << std::setprecision(1) << m_savedMs << " ms"
+        << " (" << m_directory.string() << ")" << std::endl;
+}
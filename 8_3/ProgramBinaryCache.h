@@ -0,0 +1,38 @@
+#pragma once
+#include <CL/cl.h>
+#include <filesystem>
+#include <ostream>
+#include <string>
+
+// Дисковый кэш собранных программ OpenCL (CL_PROGRAM_BINARIES).
+// Ключ - платформа, имя устройства, версия драйвера, исходник и опции сборки, поэтому
+// смена драйвера или правка ядра просто дает другой ключ. Файл, который не удалось
+// загрузить через clCreateProgramWithBinary, удаляется и пересобирается из исходника.
+class ProgramBinaryCache
+{
+public:
+    // Пустой путь отключает кэш: программы всегда собираются из исходников.
+    explicit ProgramBinaryCache(std::filesystem::path directory);
+
+    // Каталог по умолчанию: $OPENCL_CACHE_DIR или <temp>/8_3_cl_cache; OPENCL_CACHE_DIR=off отключает кэш.
+    static std::filesystem::path DefaultDirectory();
+
+    cl_program GetOrBuild(cl_context context, cl_device_id device,
+                          const std::string& kernelSource, const std::string& buildOptions);
+
+    [[nodiscard]] bool IsEnabled() const { return !m_directory.empty(); }
+    void PrintStats(std::ostream& out) const;
+
+private:
+    static std::string MakeIdentity(cl_device_id device, const std::string& kernelSource, const std::string& buildOptions);
+    // Возвращает nullptr, если файла нет или он устарел; storedBuildMs - время исходной сборки
+    static cl_program TryLoad(const std::filesystem::path& file, const std::string& identity,
+                              cl_context context, cl_device_id device, const std::string& buildOptions,
+                              double& storedBuildMs);
+    static void Store(const std::filesystem::path& file, const std::string& identity, cl_program program, double buildMs);
+
+    std::filesystem::path m_directory;
+    int m_hits = 0;
+    int m_misses = 0;
+    double m_savedMs = 0.0;
+};
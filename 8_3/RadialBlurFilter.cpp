@@ -3,24 +3,26 @@
 #include <iostream>
 #include <cmath>     // Для sqrt
 #include <algorithm> // Для std::max
+#include <stdexcept>
 
 const std::string RadialBlurFilter::m_kernelSource = R"CLC(
+// Собирается после m_pixelTypesSource: значения типа Element по -DELEMENT
 __kernel void ApplyRadialBlur(
-    __global const uchar* inputImage,
-    __global uchar* outputImage,
+    __global const Element* inputImage,
+    __global Element* outputImage,
     const int imageWidth,
     const int imageHeight,
     const int numChannels,
-    const int blurIntensity) // Интенсивность / количество сэмплов
+    const int blurIntensity, // Интенсивность
+    const float centerX,
+    const float centerY,
+    const int numSamples)
 {
     int globalX = get_global_id(0);
     int globalY = get_global_id(1);
 
     if (globalX >= imageWidth || globalY >= imageHeight) return;
 
-    float centerX = (float)imageWidth / 2.0f;
-    float centerY = (float)imageHeight / 2.0f;
-
     float deltaX = (float)globalX - centerX;
     float deltaY = (float)globalY - centerY;
     float distanceToCenter = sqrt(deltaX * deltaX + deltaY * deltaY);
@@ -28,7 +30,7 @@ __kernel void ApplyRadialBlur(
     if (distanceToCenter < 1.0f || blurIntensity == 0) {
         for (int ch = 0; ch < numChannels; ++ch) {
             int currentIndex = (globalY * imageWidth + globalX) * numChannels + ch;
-            outputImage[currentIndex] = inputImage[currentIndex];
+            STORE_VALUE(LOAD_VALUE(currentIndex, inputImage), currentIndex, outputImage);
         }
         return;
     }
@@ -36,9 +38,11 @@ __kernel void ApplyRadialBlur(
     float dirX = deltaX / distanceToCenter;
     float dirY = deltaY / distanceToCenter;
 
-    // Максимальное расстояние до центра (примерно половина диагонали)
+    // Максимальное расстояние до центра (расстояние до дальнего угла, для центра кадра - половина диагонали)
     // Используется для масштабирования эффекта в зависимости от удаленности от центра.
-    float maxPossibleDist = 0.5f * sqrt((float)(imageWidth * imageWidth + imageHeight * imageHeight));
+    float farX = max(centerX, (float)imageWidth - centerX);
+    float farY = max(centerY, (float)imageHeight - centerY);
+    float maxPossibleDist = sqrt(farX * farX + farY * farY);
     if (maxPossibleDist < 1.0f) maxPossibleDist = 1.0f; // Избегаем деления на ноль
 
     // sampleStep определяет, насколько далеко друг от друга берутся сэмплы.
@@ -48,8 +52,6 @@ __kernel void ApplyRadialBlur(
     float sampleStep = 1.0f + (distanceToCenter / maxPossibleDist) * stepFactor * blurIntensity;
     sampleStep = max(1.0f, sampleStep);
 
-    int numSamples = max(1, blurIntensity / 2 + 1); // Количество сэмплов, можно тоже связать с blurIntensity
-
     for (int c = 0; c < numChannels; ++c) {
         float accumulatedColor = 0.0f;
         int actualSamplesCount = 0;
@@ -64,115 +66,428 @@ __kernel void ApplyRadialBlur(
             int sampleY = clamp((int)((float)globalY - dirY * currentOffset), 0, imageHeight - 1);
 
             int sampleIndex = (sampleY * imageWidth + sampleX) * numChannels + c;
-            accumulatedColor += (float)inputImage[sampleIndex];
+            accumulatedColor += VALUE_TO_FLOAT(LOAD_VALUE(sampleIndex, inputImage));
             actualSamplesCount++;
         }
 
         int outputIndex = (globalY * imageWidth + globalX) * numChannels + c;
         if (actualSamplesCount > 0) {
-            outputImage[outputIndex] = (uchar)(accumulatedColor / actualSamplesCount);
+            STORE_VALUE(TO_VALUE_RTZ(accumulatedColor / actualSamplesCount), outputIndex, outputImage);
         } else {
-            outputImage[outputIndex] = inputImage[outputIndex];
+            STORE_VALUE(LOAD_VALUE(outputIndex, inputImage), outputIndex, outputImage);
         }
     }
 }
 )CLC";
 
-RadialBlurFilter::RadialBlurFilter(int initialIntensity)
-        : m_intensity(initialIntensity)
+const std::string RadialBlurFilter::m_imageKernelSource = R"CLC(
+// То же размытие, но вход - image2d_t: билинейная выборка и обрезка по краю делаются сэмплером,
+// все каналы читаются одним read_imagef, а геометрия считается один раз на пиксель.
+// Собирается после m_pixelTypesSource; результат пишется в обычный буфер. read_imagef возвращает
+// нормированные значения (UNORM) или сами значения (HALF_FLOAT, FLOAT): ELEMENT_SCALE возвращает шкалу Element.
+#if CHANNELS == 1
+#define NARROW(value) (value).x
+#elif CHANNELS == 2
+#define NARROW(value) (value).xy
+#elif CHANNELS == 3
+#define NARROW(value) (value).xyz
+#else
+#define NARROW(value) (value)
+#endif
+
+__constant sampler_t linearSampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_LINEAR;
+
+__kernel void RadialBlurImage(
+    __read_only image2d_t inputImage,
+    __global Element* outputImage,
+    const int imageWidth,
+    const int imageHeight,
+    const int blurIntensity,
+    const float centerX,
+    const float centerY,
+    const int numSamples)
 {
-    InitializeOpenCl();
-    m_program = CreateProgramWithSource(m_context, m_deviceId, m_kernelSource);
-    CreateKernel();
+    int globalX = get_global_id(0);
+    int globalY = get_global_id(1);
+    if (globalX >= imageWidth || globalY >= imageHeight) return;
+
+    float2 position = (float2)((float)globalX, (float)globalY);
+    float2 delta = position - (float2)(centerX, centerY);
+    float distanceToCenter = length(delta);
+    // Центр пикселя в координатах сэмплера смещен на 0.5
+    if (distanceToCenter < 1.0f) {
+        float4 color = read_imagef(inputImage, linearSampler, position + 0.5f);
+        STORE_PIXEL(TO_PIXEL(NARROW(color) * ELEMENT_SCALE), globalY * imageWidth + globalX, outputImage);
+        return;
+    }
+
+    float2 direction = delta / distanceToCenter;
+    float farX = max(centerX, (float)imageWidth - centerX);
+    float farY = max(centerY, (float)imageHeight - centerY);
+    float maxPossibleDist = max(1.0f, sqrt(farX * farX + farY * farY));
+    float stepFactor = 0.005f * blurIntensity;
+    float sampleStep = max(1.0f, 1.0f + (distanceToCenter / maxPossibleDist) * stepFactor * blurIntensity);
+
+    float2 sampleDelta = direction * sampleStep;
+    float4 accumulatedColor = (float4)(0.0f);
+    for (int s = 0; s < numSamples; ++s) {
+        accumulatedColor += read_imagef(inputImage, linearSampler, position - sampleDelta * (float)s + 0.5f);
+    }
+    float4 color = accumulatedColor * (ELEMENT_SCALE / numSamples);
+    STORE_PIXEL(TO_PIXEL(NARROW(color)), globalY * imageWidth + globalX, outputImage);
 }
+)CLC";
 
-RadialBlurFilter::~RadialBlurFilter()
+const std::string RadialBlurFilter::m_polarKernelSource = R"CLC(
+// Размытие через полярные координаты: луч angle из центра - строка полярного буфера,
+// отсчет radius - пиксель на расстоянии radius. Вдоль луча окно усредняется скользящей суммой,
+// поэтому стоимость не зависит от числа сэмплов. Окно для radius - [radius - len + 1, radius],
+// len = (numSamples - 1) * sampleStep + 1; отсчеты за центром заменяются значением в центре.
+
+// value[c] += sign * билинейная выборка канала c в точке (x, y) с обрезкой по краю
+void AddBilinear(__global const Element* image, float x, float y, int imageWidth, int imageHeight,
+                 int numChannels, float sign, float* value)
 {
-    ReleaseOpenCl();
+    x = clamp(x, 0.0f, (float)(imageWidth - 1));
+    y = clamp(y, 0.0f, (float)(imageHeight - 1));
+    int x0 = (int)x;
+    int y0 = (int)y;
+    int x1 = min(x0 + 1, imageWidth - 1);
+    int y1 = min(y0 + 1, imageHeight - 1);
+    float wx = x - (float)x0;
+    float wy = y - (float)y0;
+    for (int c = 0; c < numChannels; ++c) {
+        float top = mix(VALUE_TO_FLOAT(LOAD_VALUE((y0 * imageWidth + x0) * numChannels + c, image)),
+                        VALUE_TO_FLOAT(LOAD_VALUE((y0 * imageWidth + x1) * numChannels + c, image)), wx);
+        float bottom = mix(VALUE_TO_FLOAT(LOAD_VALUE((y1 * imageWidth + x0) * numChannels + c, image)),
+                           VALUE_TO_FLOAT(LOAD_VALUE((y1 * imageWidth + x1) * numChannels + c, image)), wx);
+        value[c] += sign * mix(top, bottom, wy);
+    }
 }
 
-void RadialBlurFilter::InitializeOpenCl()
+__kernel void PolarBlurRays(
+    __global const Element* inputImage,
+    __global Element* polarImage, // angleCount x radiusCount x numChannels
+    const int imageWidth,
+    const int imageHeight,
+    const int numChannels,
+    const float centerX,
+    const float centerY,
+    const int angleCount,
+    const int radiusCount,
+    const int numSamples,
+    const float stepScale) // sampleStep = 1 + radius * stepScale, как в ApplyRadialBlur
 {
-    cl_int err;
-    cl_uint numPlatforms;
-    err = clGetPlatformIDs(0, nullptr, &numPlatforms);
-    CheckCLError(err, "clGetPlatformIDs (count)");
-    if (numPlatforms == 0) throw std::runtime_error("RadialBlurFilter: No OpenCL platforms found.");
-
-    std::vector<cl_platform_id> platforms(numPlatforms);
-    err = clGetPlatformIDs(numPlatforms, platforms.data(), nullptr);
-    CheckCLError(err, "clGetPlatformIDs (list)");
-
-    cl_platform_id platform = platforms[0];
-    err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_GPU, 1, &m_deviceId, nullptr);
-    if (err == CL_DEVICE_NOT_FOUND || m_deviceId == nullptr) {
-        err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_CPU, 1, &m_deviceId, nullptr);
-        CheckCLError(err, "clGetDeviceIDs (CPU) for RadialBlur");
-    } else {
-        CheckCLError(err, "clGetDeviceIDs (GPU) for RadialBlur");
+    int angle = get_global_id(0);
+    if (angle >= angleCount) return;
+
+    float theta = 2.0f * M_PI_F * (float)angle / (float)angleCount;
+    float dirX = cos(theta);
+    float dirY = sin(theta);
+
+    float centerValue[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    AddBilinear(inputImage, centerX, centerY, imageWidth, imageHeight, numChannels, 1.0f, centerValue);
+
+    float sum[4] = {0.0f, 0.0f, 0.0f, 0.0f}; // Сумма отсчетов [tail, radius] с tail >= 0
+    int tail = 0;
+    for (int radius = 0; radius < radiusCount; ++radius) {
+        AddBilinear(inputImage, centerX + dirX * radius, centerY + dirY * radius, imageWidth, imageHeight, numChannels, 1.0f, sum);
+
+        float sampleStep = 1.0f + (float)radius * stepScale;
+        int windowLength = (int)((float)(numSamples - 1) * sampleStep) + 1;
+        int windowStart = radius - windowLength + 1;
+        // Начало окна монотонно, но на всякий случай двигаем его в обе стороны
+        for (; tail < max(windowStart, 0); ++tail) {
+            AddBilinear(inputImage, centerX + dirX * tail, centerY + dirY * tail, imageWidth, imageHeight, numChannels, -1.0f, sum);
+        }
+        for (; tail > max(windowStart, 0); ) {
+            --tail;
+            AddBilinear(inputImage, centerX + dirX * tail, centerY + dirY * tail, imageWidth, imageHeight, numChannels, 1.0f, sum);
+        }
+
+        float beyondCenter = (float)max(-windowStart, 0);
+        int outputIndex = (angle * radiusCount + radius) * numChannels;
+        for (int c = 0; c < numChannels; ++c) {
+            STORE_VALUE(TO_VALUE((sum[c] + beyondCenter * centerValue[c]) / (float)windowLength), outputIndex + c, polarImage);
+        }
     }
+}
 
-    m_context = clCreateContext(nullptr, 1, &m_deviceId, nullptr, nullptr, &err);
-    CheckCLError(err, "clCreateContext for RadialBlur");
+// Обратное преобразование: билинейная выборка из полярного буфера (по углу - с переходом через 0)
+__kernel void PolarToImage(
+    __global const Element* polarImage,
+    __global Element* outputImage,
+    const int imageWidth,
+    const int imageHeight,
+    const int numChannels,
+    const float centerX,
+    const float centerY,
+    const int angleCount,
+    const int radiusCount)
+{
+    int globalX = get_global_id(0);
+    int globalY = get_global_id(1);
+    if (globalX >= imageWidth || globalY >= imageHeight) return;
 
-#if defined(CL_VERSION_2_0) && CL_TARGET_OPENCL_VERSION >= 200
-    m_commandQueue = clCreateCommandQueueWithProperties(m_context, m_deviceId, 0, &err);
-#else
-    m_commandQueue = clCreateCommandQueue(m_context, m_deviceId, 0, &err);
-#endif
-    CheckCLError(err, "clCreateCommandQueue for RadialBlur");
+    float deltaX = (float)globalX - centerX;
+    float deltaY = (float)globalY - centerY;
+    float radius = min(sqrt(deltaX * deltaX + deltaY * deltaY), (float)(radiusCount - 1));
+    float theta = atan2(deltaY, deltaX);
+    if (theta < 0.0f) theta += 2.0f * M_PI_F;
+
+    float anglePos = theta * (float)angleCount / (2.0f * M_PI_F);
+    int angle0 = min((int)anglePos, angleCount - 1);
+    int angle1 = (angle0 + 1) % angleCount;
+    float wa = clamp(anglePos - (float)angle0, 0.0f, 1.0f);
+    int radius0 = (int)radius;
+    int radius1 = min(radius0 + 1, radiusCount - 1);
+    float wr = radius - (float)radius0;
+
+    int outputIndex = (globalY * imageWidth + globalX) * numChannels;
+    for (int c = 0; c < numChannels; ++c) {
+        float inner = mix(VALUE_TO_FLOAT(LOAD_VALUE((angle0 * radiusCount + radius0) * numChannels + c, polarImage)),
+                          VALUE_TO_FLOAT(LOAD_VALUE((angle1 * radiusCount + radius0) * numChannels + c, polarImage)), wa);
+        float outer = mix(VALUE_TO_FLOAT(LOAD_VALUE((angle0 * radiusCount + radius1) * numChannels + c, polarImage)),
+                          VALUE_TO_FLOAT(LOAD_VALUE((angle1 * radiusCount + radius1) * numChannels + c, polarImage)), wa);
+        STORE_VALUE(TO_VALUE(mix(inner, outer, wr)), outputIndex + c, outputImage);
+    }
 }
+)CLC";
 
-void RadialBlurFilter::CreateKernel() {
-    cl_int err;
-    m_kernel = clCreateKernel(m_program, "ApplyRadialBlur", &err);
-    CheckCLError(err, "clCreateKernel (ApplyRadialBlur)");
+RadialBlurFilter::RadialBlurFilter(int initialIntensity)
+        : m_intensity(initialIntensity)
+{
+}
+
+RadialBlurFilter::~RadialBlurFilter()
+{
+    ReleaseImage();
 }
 
-void RadialBlurFilter::ReleaseOpenCl()
+void RadialBlurFilter::ReleaseImage()
 {
-    if (m_kernel) clReleaseKernel(m_kernel);
-    if (m_program) clReleaseProgram(m_program);
-    if (m_commandQueue) clReleaseCommandQueue(m_commandQueue);
-    if (m_context) clReleaseContext(m_context);
+    // clReleaseMemObject откладывает удаление до завершения команд, которые используют изображение
+    if (m_imageFence) clReleaseEvent(m_imageFence);
+    if (m_image) clReleaseMemObject(m_image);
+    m_imageFence = nullptr;
+    m_image = nullptr;
 }
 
-void RadialBlurFilter::ApplyFilter(std::vector<unsigned char>& imageData, int width, int height, int channels)
+int RadialBlurFilter::GetSampleCount() const
 {
-    if (m_intensity <= 0) return; // Интенсивность 0 - нет эффекта
+    return m_samples > 0 ? m_samples : std::max(1, m_intensity / 2 + 1);
+}
 
+bool RadialBlurFilter::EnqueueImage(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                                    ElementType elementType)
+{
+    // Для 3 каналов форматов с такими типами нет (CL_RGB только упакованный), остается буферное ядро
+    static const cl_channel_order channelOrders[] = {0, CL_R, CL_RG, 0, CL_RGBA};
+    // По ElementType: целые - нормированные, чтобы сэмплер мог интерполировать
+    static const cl_channel_type channelTypes[] = {CL_UNORM_INT8, CL_UNORM_INT16, CL_HALF_FLOAT, CL_FLOAT};
+    const OpenCLDeviceInfo& device = m_runtime->GetDeviceInfo();
+    if (!device.imageSupport || channels < 1 || channels > 4 || channelOrders[channels] == 0) return false;
+    if (static_cast<size_t>(width) > device.image2dMaxWidth || static_cast<size_t>(height) > device.image2dMaxHeight) return false;
+
+    cl_image_format format = {};
+    format.image_channel_order = channelOrders[channels];
+    format.image_channel_data_type = channelTypes[static_cast<int>(elementType)];
     cl_int err;
-    size_t imageSizeBytes = static_cast<size_t>(width) * height * channels * sizeof(unsigned char);
-
-    cl_mem inputBuffer = clCreateBuffer(m_context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
-                                        imageSizeBytes, imageData.data(), &err);
-    CheckCLError(err, "RadialBlur clCreateBuffer (inputBuffer)");
-    cl_mem outputBuffer = clCreateBuffer(m_context, CL_MEM_WRITE_ONLY,
-                                         imageSizeBytes, nullptr, &err);
-    CheckCLError(err, "RadialBlur clCreateBuffer (outputBuffer)");
-
-    err = clSetKernelArg(m_kernel, 0, sizeof(cl_mem), &inputBuffer); CheckCLError(err, "RadialBlur SetArg 0");
-    err = clSetKernelArg(m_kernel, 1, sizeof(cl_mem), &outputBuffer); CheckCLError(err, "RadialBlur SetArg 1");
-    err = clSetKernelArg(m_kernel, 2, sizeof(int), &width); CheckCLError(err, "RadialBlur SetArg 2");
-    err = clSetKernelArg(m_kernel, 3, sizeof(int), &height); CheckCLError(err, "RadialBlur SetArg 3");
-    err = clSetKernelArg(m_kernel, 4, sizeof(int), &channels); CheckCLError(err, "RadialBlur SetArg 4");
-    err = clSetKernelArg(m_kernel, 5, sizeof(int), &m_intensity); CheckCLError(err, "RadialBlur SetArg 5");
+    const bool sameImage = m_image && width == m_imageWidth && height == m_imageHeight &&
+                           format.image_channel_order == m_imageFormat.image_channel_order &&
+                           format.image_channel_data_type == m_imageFormat.image_channel_data_type;
+    if (!sameImage) {
+        ReleaseImage();
+        cl_image_desc desc = {};
+        desc.image_type = CL_MEM_OBJECT_IMAGE2D;
+        desc.image_width = static_cast<size_t>(width);
+        desc.image_height = static_cast<size_t>(height);
+        cl_mem image = clCreateImage(m_runtime->GetContext(), CL_MEM_READ_ONLY, &format, &desc, nullptr, &err);
+        // Неподдерживаемый формат или размер (пределы устройства могли не прочитаться) - буферное ядро
+        if (err == CL_IMAGE_FORMAT_NOT_SUPPORTED || err == CL_INVALID_IMAGE_FORMAT_DESCRIPTOR || err == CL_INVALID_IMAGE_SIZE) {
+            return false;
+        }
+        CheckCLError(err, "RadialBlur clCreateImage");
+        m_image = image;
+        m_imageWidth = width;
+        m_imageHeight = height;
+        m_imageFormat = format;
+    }
+
+    // Копия ждет ядро прошлого вызова: оно могло читать изображение из другой очереди
+    const size_t origin[3] = {0, 0, 0};
+    const size_t region[3] = {static_cast<size_t>(width), static_cast<size_t>(height), 1};
+    err = clEnqueueCopyBufferToImage(queue, input, m_image, 0, origin, region, m_imageFence ? 1 : 0,
+                                     m_imageFence ? &m_imageFence : nullptr,
+                                     m_runtime->GetProfiler().Track("RadialBlur CopyBufferToImage", ProfileCategory::TRANSFER));
+    CheckCLError(err, "RadialBlur clEnqueueCopyBufferToImage");
+
+    cl_kernel kernel = GetKernel(m_imageKernelSource, "RadialBlurImage", PixelBuildOptions(channels, elementType));
+    float centerX = m_centerX * static_cast<float>(width);
+    float centerY = m_centerY * static_cast<float>(height);
+    int numSamples = GetSampleCount();
+    err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &m_image);     CheckCLError(err, "RadialBlurImage SetArg 0");
+    err = clSetKernelArg(kernel, 1, sizeof(cl_mem), &output);      CheckCLError(err, "RadialBlurImage SetArg 1");
+    err = clSetKernelArg(kernel, 2, sizeof(int), &width);          CheckCLError(err, "RadialBlurImage SetArg 2");
+    err = clSetKernelArg(kernel, 3, sizeof(int), &height);         CheckCLError(err, "RadialBlurImage SetArg 3");
+    err = clSetKernelArg(kernel, 4, sizeof(int), &m_intensity);    CheckCLError(err, "RadialBlurImage SetArg 4");
+    err = clSetKernelArg(kernel, 5, sizeof(float), &centerX);      CheckCLError(err, "RadialBlurImage SetArg 5");
+    err = clSetKernelArg(kernel, 6, sizeof(float), &centerY);      CheckCLError(err, "RadialBlurImage SetArg 6");
+    err = clSetKernelArg(kernel, 7, sizeof(int), &numSamples);     CheckCLError(err, "RadialBlurImage SetArg 7");
 
     size_t globalWorkSize[2] = {static_cast<size_t>(width), static_cast<size_t>(height)};
-    err = clEnqueueNDRangeKernel(m_commandQueue, m_kernel, 2, nullptr, globalWorkSize, nullptr, 0, nullptr, nullptr);
-    CheckCLError(err, "RadialBlur clEnqueueNDRangeKernel");
+    err = m_runtime->EnqueueTunedKernel(queue, kernel, 2, globalWorkSize,
+                                        m_runtime->GetProfiler().Track("RadialBlurImage", ProfileCategory::COMPUTE));
+    CheckCLError(err, "RadialBlurImage clEnqueueNDRangeKernel");
+
+    cl_event fence = nullptr;
+    err = clEnqueueMarkerWithWaitList(queue, 0, nullptr, &fence);
+    CheckCLError(err, "RadialBlur clEnqueueMarkerWithWaitList");
+    if (m_imageFence) clReleaseEvent(m_imageFence);
+    m_imageFence = fence;
+    return true;
+}
 
-    err = clEnqueueReadBuffer(m_commandQueue, outputBuffer, CL_TRUE, 0,
-                              imageSizeBytes, imageData.data(), 0, nullptr, nullptr);
-    CheckCLError(err, "RadialBlur clEnqueueReadBuffer");
+void RadialBlurFilter::EnqueueOnDevice(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                                       ElementType elementType)
+{
+    if (IsIdentity()) {
+        EnqueueCopy(queue, input, output, width, height, channels, elementType);
+        return;
+    }
+    if (UsesPolar()) {
+        EnqueuePolar(queue, input, output, width, height, channels, elementType);
+        return;
+    }
+    if (m_algorithm == RadialBlurAlgorithm::IMAGE && EnqueueImage(queue, input, output, width, height, channels, elementType)) {
+        return;
+    }
 
-    clFinish(m_commandQueue);
+    float centerX = m_centerX * static_cast<float>(width);
+    float centerY = m_centerY * static_cast<float>(height);
+    int numSamples = GetSampleCount();
+    cl_kernel kernel = GetKernel(m_kernelSource, "ApplyRadialBlur", PixelBuildOptions(0, elementType));
+    cl_int err;
+    err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &input); CheckCLError(err, "RadialBlur SetArg 0");
+    err = clSetKernelArg(kernel, 1, sizeof(cl_mem), &output); CheckCLError(err, "RadialBlur SetArg 1");
+    err = clSetKernelArg(kernel, 2, sizeof(int), &width); CheckCLError(err, "RadialBlur SetArg 2");
+    err = clSetKernelArg(kernel, 3, sizeof(int), &height); CheckCLError(err, "RadialBlur SetArg 3");
+    err = clSetKernelArg(kernel, 4, sizeof(int), &channels); CheckCLError(err, "RadialBlur SetArg 4");
+    err = clSetKernelArg(kernel, 5, sizeof(int), &m_intensity); CheckCLError(err, "RadialBlur SetArg 5");
+    err = clSetKernelArg(kernel, 6, sizeof(float), &centerX); CheckCLError(err, "RadialBlur SetArg 6");
+    err = clSetKernelArg(kernel, 7, sizeof(float), &centerY); CheckCLError(err, "RadialBlur SetArg 7");
+    err = clSetKernelArg(kernel, 8, sizeof(int), &numSamples); CheckCLError(err, "RadialBlur SetArg 8");
 
-    clReleaseMemObject(inputBuffer);
-    clReleaseMemObject(outputBuffer);
+    size_t globalWorkSize[2] = {static_cast<size_t>(width), static_cast<size_t>(height)};
+    err = m_runtime->EnqueueTunedKernel(queue, kernel, 2, globalWorkSize,
+                                        m_runtime->GetProfiler().Track("RadialBlur", ProfileCategory::COMPUTE));
+    CheckCLError(err, "RadialBlur clEnqueueNDRangeKernel");
 }
 
 void RadialBlurFilter::SetEffectRadius(int intensity) // radius является intensity
 {
     m_intensity = std::max(0, intensity);
-}
\ No newline at end of file
+}
+RadialBlurFilter::PolarGrid RadialBlurFilter::GetPolarGrid(int width, int height) const
+{
+    // Лучи до дальнего угла; по углу - примерно один отсчет на пиксель самой длинной окружности
+    float centerX = m_centerX * static_cast<float>(width);
+    float centerY = m_centerY * static_cast<float>(height);
+    float farX = std::max(centerX, static_cast<float>(width) - centerX);
+    float farY = std::max(centerY, static_cast<float>(height) - centerY);
+    PolarGrid grid;
+    grid.maxDistance = std::max(1.0f, std::sqrt(farX * farX + farY * farY));
+    grid.radiusCount = static_cast<int>(std::ceil(grid.maxDistance)) + 2;
+    grid.angleCount = std::max(8, static_cast<int>(std::ceil(2.0f * 3.14159265f * grid.maxDistance)));
+    return grid;
+}
+
+bool RadialBlurFilter::UsesPolar() const
+{
+    return m_algorithm == RadialBlurAlgorithm::POLAR ||
+           (m_algorithm == RadialBlurAlgorithm::AUTO && m_polarIntensityThreshold > 0 && m_intensity >= m_polarIntensityThreshold);
+}
+
+size_t RadialBlurFilter::GetScratchBytes(int width, int rows, int channels, ElementType elementType) const
+{
+    if (IsIdentity()) return 0;
+    if (UsesPolar()) {
+        const PolarGrid grid = GetPolarGrid(width, rows);
+        return static_cast<size_t>(grid.angleCount) * grid.radiusCount * channels * GetElementSize(elementType);
+    }
+    // Изображение для image2d_t того же размера и типа
+    if (m_algorithm == RadialBlurAlgorithm::IMAGE) return static_cast<size_t>(width) * rows * channels * GetElementSize(elementType);
+    return 0;
+}
+
+void RadialBlurFilter::EnqueuePolar(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                                    ElementType elementType)
+{
+    if (channels < 1 || channels > 4) {
+        throw std::runtime_error("Radial blur algo 'polar' supports 1-4 channels, got " + std::to_string(channels));
+    }
+    float centerX = m_centerX * static_cast<float>(width);
+    float centerY = m_centerY * static_cast<float>(height);
+    const PolarGrid grid = GetPolarGrid(width, height);
+    const int radiusCount = grid.radiusCount;
+    const int angleCount = grid.angleCount;
+    int numSamples = GetSampleCount();
+    float stepScale = 0.005f * static_cast<float>(m_intensity) * static_cast<float>(m_intensity) / grid.maxDistance;
+
+    size_t polarBytes = static_cast<size_t>(angleCount) * radiusCount * channels * GetElementSize(elementType);
+    PooledBuffer polarBuffer(m_runtime->GetBufferPool(), polarBytes);
+
+    const std::string buildOptions = PixelBuildOptions(0, elementType);
+    cl_kernel polarRaysKernel = GetKernel(m_polarKernelSource, "PolarBlurRays", buildOptions);
+    cl_kernel polarToImageKernel = GetKernel(m_polarKernelSource, "PolarToImage", buildOptions);
+    cl_int err;
+    err = clSetKernelArg(polarRaysKernel, 0, sizeof(cl_mem), &input);               CheckCLError(err, "PolarBlurRays SetArg 0");
+    err = clSetKernelArg(polarRaysKernel, 1, sizeof(cl_mem), polarBuffer.GetPtr());  CheckCLError(err, "PolarBlurRays SetArg 1");
+    err = clSetKernelArg(polarRaysKernel, 2, sizeof(int), &width);                  CheckCLError(err, "PolarBlurRays SetArg 2");
+    err = clSetKernelArg(polarRaysKernel, 3, sizeof(int), &height);                 CheckCLError(err, "PolarBlurRays SetArg 3");
+    err = clSetKernelArg(polarRaysKernel, 4, sizeof(int), &channels);               CheckCLError(err, "PolarBlurRays SetArg 4");
+    err = clSetKernelArg(polarRaysKernel, 5, sizeof(float), &centerX);              CheckCLError(err, "PolarBlurRays SetArg 5");
+    err = clSetKernelArg(polarRaysKernel, 6, sizeof(float), &centerY);              CheckCLError(err, "PolarBlurRays SetArg 6");
+    err = clSetKernelArg(polarRaysKernel, 7, sizeof(int), &angleCount);             CheckCLError(err, "PolarBlurRays SetArg 7");
+    err = clSetKernelArg(polarRaysKernel, 8, sizeof(int), &radiusCount);            CheckCLError(err, "PolarBlurRays SetArg 8");
+    err = clSetKernelArg(polarRaysKernel, 9, sizeof(int), &numSamples);             CheckCLError(err, "PolarBlurRays SetArg 9");
+    err = clSetKernelArg(polarRaysKernel, 10, sizeof(float), &stepScale);           CheckCLError(err, "PolarBlurRays SetArg 10");
+
+    size_t raysWorkSize[1] = {static_cast<size_t>(angleCount)};
+    err = m_runtime->EnqueueTunedKernel(queue, polarRaysKernel, 1, raysWorkSize,
+                                        m_runtime->GetProfiler().Track("PolarBlurRays", ProfileCategory::COMPUTE));
+    CheckCLError(err, "PolarBlurRays clEnqueueNDRangeKernel");
+
+    err = clSetKernelArg(polarToImageKernel, 0, sizeof(cl_mem), polarBuffer.GetPtr()); CheckCLError(err, "PolarToImage SetArg 0");
+    err = clSetKernelArg(polarToImageKernel, 1, sizeof(cl_mem), &output);              CheckCLError(err, "PolarToImage SetArg 1");
+    err = clSetKernelArg(polarToImageKernel, 2, sizeof(int), &width);                  CheckCLError(err, "PolarToImage SetArg 2");
+    err = clSetKernelArg(polarToImageKernel, 3, sizeof(int), &height);                 CheckCLError(err, "PolarToImage SetArg 3");
+    err = clSetKernelArg(polarToImageKernel, 4, sizeof(int), &channels);               CheckCLError(err, "PolarToImage SetArg 4");
+    err = clSetKernelArg(polarToImageKernel, 5, sizeof(float), &centerX);              CheckCLError(err, "PolarToImage SetArg 5");
+    err = clSetKernelArg(polarToImageKernel, 6, sizeof(float), &centerY);              CheckCLError(err, "PolarToImage SetArg 6");
+    err = clSetKernelArg(polarToImageKernel, 7, sizeof(int), &angleCount);             CheckCLError(err, "PolarToImage SetArg 7");
+    err = clSetKernelArg(polarToImageKernel, 8, sizeof(int), &radiusCount);            CheckCLError(err, "PolarToImage SetArg 8");
+
+    size_t imageWorkSize[2] = {static_cast<size_t>(width), static_cast<size_t>(height)};
+    err = m_runtime->EnqueueTunedKernel(queue, polarToImageKernel, 2, imageWorkSize,
+                                        m_runtime->GetProfiler().Track("PolarToImage", ProfileCategory::COMPUTE));
+    CheckCLError(err, "PolarToImage clEnqueueNDRangeKernel");
+    polarBuffer.ResetAfter(queue);
+}
+
+void RadialBlurFilter::SetOption(const std::string& key, const std::string& value)
+{
+    if (key == "cx") m_centerX = std::stof(value);
+    else if (key == "cy") m_centerY = std::stof(value);
+    else if (key == "samples") m_samples = std::max(0, std::stoi(value));
+    else if (key == "polar_from") m_polarIntensityThreshold = std::max(0, std::stoi(value));
+    else if (key == "algo") {
+        if (value == "auto") m_algorithm = RadialBlurAlgorithm::AUTO;
+        else if (value == "image") m_algorithm = RadialBlurAlgorithm::IMAGE;
+        else if (value == "buffer") m_algorithm = RadialBlurAlgorithm::BUFFER;
+        else if (value == "polar") m_algorithm = RadialBlurAlgorithm::POLAR;
+        else throw std::runtime_error("Unknown radial algo '" + value + "' (auto, image, buffer, polar)");
+    } else {
+        OpenCLImageFilter::SetOption(key, value);
+    }
+}
@@ -1,31 +1,67 @@
 #pragma once
-#include "IImageFilter.h"
+#include "OpenCLImageFilter.h"
 #include <CL/cl.h>
 #include <string>
 #include <vector>
 
-class RadialBlurFilter : public IImageFilter
+enum class RadialBlurAlgorithm
+{
+    AUTO,   // POLAR начиная с интенсивности polar_from, ниже - BUFFER (IMAGE пока не замерен на 4K)
+    IMAGE,  // image2d_t с аппаратной билинейной выборкой; если устройство не поддерживает формат
+            // или размер изображения - BUFFER
+    BUFFER, // Исходное ядро по __global Element
+    POLAR   // Полярные координаты + скользящая сумма вдоль лучей: стоимость не зависит от интенсивности
+};
+
+class RadialBlurFilter : public OpenCLImageFilter
 {
 public:
     RadialBlurFilter(int initialIntensity);
     ~RadialBlurFilter() override;
 
-    void ApplyFilter(std::vector<unsigned char>& imageData, int width, int height, int channels) override;
+    void EnqueueOnDevice(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                         ElementType elementType) override;
     void SetEffectRadius(int intensity) override; // radius - это интенсивность/количество сэмплов
+    // "cx", "cy": центр в долях ширины/высоты (0.5 - середина); "samples": число сэмплов (0 - по интенсивности);
+    // "algo": auto | image | buffer | polar; "polar_from": интенсивность, с которой auto выбирает polar (0 - никогда)
+    void SetOption(const std::string& key, const std::string& value) override;
     std::string GetName() const override { return "Radial Blur"; }
+    [[nodiscard]] bool IsIdentity() const override { return m_intensity <= 0; }
+    [[nodiscard]] size_t GetScratchBytes(int width, int rows, int channels, ElementType elementType) const override;
 
 private:
-    void InitializeOpenCl();
-    void ReleaseOpenCl();
-    void CreateKernel();
+    // false, если путь через изображение недоступен для этого устройства/числа каналов/типа значения/размера
+    bool EnqueueImage(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                      ElementType elementType);
+    void EnqueuePolar(cl_command_queue queue, cl_mem input, cl_mem output, int width, int height, int channels,
+                      ElementType elementType);
+    struct PolarGrid
+    {
+        float maxDistance = 1.0f; // От центра до дальнего угла
+        int radiusCount = 0;
+        int angleCount = 0;
+    };
+    [[nodiscard]] PolarGrid GetPolarGrid(int width, int height) const;
+    [[nodiscard]] bool UsesPolar() const;
+    void ReleaseImage();
+    [[nodiscard]] int GetSampleCount() const;
 
-    int m_intensity; // Интенсивность размытия / количество сэмплов
+    int m_intensity; // Интенсивность размытия
+    float m_centerX = 0.5f;
+    float m_centerY = 0.5f;
+    int m_samples = 0;
+    RadialBlurAlgorithm m_algorithm = RadialBlurAlgorithm::AUTO;
+    int m_polarIntensityThreshold = 48;
 
-    cl_device_id m_deviceId = nullptr;
-    cl_context m_context = nullptr;
-    cl_command_queue m_commandQueue = nullptr;
-    cl_program m_program = nullptr;
-    cl_kernel m_kernel = nullptr;
+    // Изображение последнего вызова IMAGE: повторно используется при тех же размерах и формате.
+    // m_imageFence - маркер после ядра, читавшего его; следующая копия ждет его (очереди могут быть разные)
+    cl_mem m_image = nullptr;
+    int m_imageWidth = 0;
+    int m_imageHeight = 0;
+    cl_image_format m_imageFormat = {};
+    cl_event m_imageFence = nullptr;
 
     static const std::string m_kernelSource;
+    static const std::string m_imageKernelSource;
+    static const std::string m_polarKernelSource;
 };
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "StreamBenchmark.h"
+#include <chrono>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+using Clock = std::chrono::high_resolution_clock;
+using Seconds = std::chrono::duration<double>;
+
+namespace
+{
+using Frames = std::vector<PixelBuffer>;
+
+// Кадры немного отличаются друг от друга, чтобы результат одного нельзя было спутать с другим
+Frames CreateFrames(int width, int height, int channels, int frameCount)
+{
+    Frames frames(frameCount, PixelBuffer(static_cast<size_t>(width) * height * channels));
+    for (int f = 0; f < frameCount; ++f) {
+        PixelBuffer& frame = frames[f];
+        for (size_t i = 0; i < frame.size(); ++i) {
+            frame[i] = static_cast<unsigned char>((i * 7 + (i / channels) % width * 3 + f * 13) & 0xFF);
+        }
+    }
+    return frames;
+}
+
+void PrintThroughput(const std::string& label, double seconds, int frameCount, size_t frameBytes)
+{
+    std::cout << label << ": " << std::fixed << std::setprecision(2) << seconds * 1000.0 << " ms, "
+              << frameCount / seconds << " frames/s, "
+              << frameCount * frameBytes / seconds / (1024.0 * 1024.0) << " MiB/s" << std::endl;
+}
+}
+
+void RunStreamBenchmark(const FilterSpec& spec, int width, int height, int frameCount)
+{
+    std::unique_ptr<OpenCLImageFilter> filter = CreateImageFilter(spec);
+    int channels = filter->GetRequiredChannels() != 0 ? filter->GetRequiredChannels() : 4;
+    const size_t frameBytes = static_cast<size_t>(width) * height * channels;
+
+    std::cout << "Stream: " << frameCount << " frames " << width << "x" << height << "x" << channels
+              << ", filter: " << filter->GetName() << ", frames in flight: "
+              << OpenCLImageFilter::ASYNC_QUEUE_COUNT << std::endl;
+
+    const Frames sourceFrames = CreateFrames(width, height, channels, frameCount);
+
+    // Прогрев: сборка программ, выделение буферов пула и очередей
+    {
+        PixelBuffer warmup = sourceFrames.front();
+        filter->ApplyFilter(warmup, width, height, channels);
+        FilterCompletion warmupAsync = filter->ApplyFilterAsync(warmup, width, height, channels);
+        warmupAsync.Wait();
+    }
+
+    Frames syncFrames = sourceFrames;
+    auto startTime = Clock::now();
+    for (PixelBuffer& frame : syncFrames) {
+        filter->ApplyFilter(frame, width, height, channels);
+    }
+    double syncSeconds = Seconds(Clock::now() - startTime).count();
+
+    Frames asyncFrames = sourceFrames;
+    startTime = Clock::now();
+    {
+        // Кадр N+1 загружается, пока кадр N считается, а кадр N-1 читается на хост
+        std::deque<FilterCompletion> inFlight;
+        for (PixelBuffer& frame : asyncFrames) {
+            inFlight.push_back(filter->ApplyFilterAsync(frame, width, height, channels));
+            if (inFlight.size() >= OpenCLImageFilter::ASYNC_QUEUE_COUNT) {
+                inFlight.front().Wait();
+                inFlight.pop_front();
+            }
+        }
+        for (FilterCompletion& completion : inFlight) completion.Wait();
+    }
+    double asyncSeconds = Seconds(Clock::now() - startTime).count();
+
+    PrintThroughput("Synchronous ApplyFilter", syncSeconds, frameCount, frameBytes);
+    PrintThroughput("Asynchronous ApplyFilterAsync", asyncSeconds, frameCount, frameBytes);
+    std::cout << "Speedup: " << std::setprecision(2) << syncSeconds / asyncSeconds << "x" << std::endl;
+
+    bool verified = syncFrames == asyncFrames;
+    std::cout << "Verification: " << (verified ? "PASSED" : "FAILED") << std::endl;
+}
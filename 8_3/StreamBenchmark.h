@@ -0,0 +1,7 @@
+#pragma once
+#include "FilterPipeline.h"
+
+// Поток одинаковых по размеру синтетических кадров через один фильтр: сначала синхронным
+// ApplyFilter, затем ApplyFilterAsync с несколькими кадрами в полете. Печатает кадры/с
+// обоих вариантов и проверяет, что результаты совпадают.
+void RunStreamBenchmark(const FilterSpec& spec, int width, int height, int frameCount);
@@ -0,0 +1,99 @@
+#include "TuningDatabase.h"
+#include "OpenCLUtils.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+TuningDatabase::TuningDatabase(fs::path file)
+        : m_file(std::move(file))
+{
+    Load();
+}
+
+fs::path TuningDatabase::DefaultPath()
+{
+    const char* envFile = std::getenv("OPENCL_TUNING_FILE");
+    if (envFile != nullptr) {
+        std::string value = envFile;
+        if (value.empty() || value == "off" || value == "0") return {};
+        return value;
+    }
+    std::error_code ec;
+    fs::path tempDir = fs::temp_directory_path(ec);
+    if (ec) return {};
+    return tempDir / "8_3_cl_tuning.txt";
+}
+
+std::string TuningDatabase::MakeSizeClass(cl_uint dims, const size_t* sizes)
+{
+    std::string sizeClass;
+    for (cl_uint d = 0; d < dims; ++d) {
+        size_t rounded = 1;
+        while (rounded < sizes[d]) rounded *= 2;
+        sizeClass += (d > 0 ? "x" : "") + std::to_string(rounded);
+    }
+    return sizeClass;
+}
+
+std::string TuningDatabase::MakeDeviceIdentity(cl_device_id device)
+{
+    cl_platform_id platform = nullptr;
+    clGetDeviceInfo(device, CL_DEVICE_PLATFORM, sizeof(platform), &platform, nullptr);
+    return GetPlatformInfoString(platform, CL_PLATFORM_NAME) + "|" + GetDeviceInfoString(device, CL_DEVICE_NAME) + "|" +
+           GetDeviceInfoString(device, CL_DRIVER_VERSION);
+}
+
+std::optional<std::string> TuningDatabase::Find(const std::string& key) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) return std::nullopt;
+    return it->second;
+}
+
+bool TuningDatabase::IsEmpty() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.empty();
+}
+
+void TuningDatabase::Store(const std::string& key, const std::string& value)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries[key] = value;
+    Save();
+}
+
+void TuningDatabase::Load()
+{
+    if (m_file.empty()) return;
+    std::ifstream in(m_file);
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t tabPos = line.rfind('\t');
+        if (line.empty() || line[0] == '#' || tabPos == std::string::npos) continue;
+        m_entries[line.substr(0, tabPos)] = line.substr(tabPos + 1);
+    }
+}
+
+void TuningDatabase::Save() const
+{
+    if (m_file.empty()) return;
+    // Сначала во временный файл: оборванная запись не портит базу
+    fs::path tempFile = m_file;
+    tempFile += ".tmp";
+    {
+        std::ofstream out(tempFile, std::ios::trunc);
+        if (!out) {
+            std::cerr << "Warning: cannot write the tuning database " << m_file << std::endl;
+            return;
+        }
+        out << "# Work-group and tile sizes found by --tune: platform|device|driver|kernel and build options|size class <TAB> value\n";
+        for (const auto& [key, value] : m_entries) out << key << '\t' << value << '\n';
+    }
+    std::error_code ec;
+    fs::rename(tempFile, m_file, ec);
+    if (ec) std::cerr << "Warning: cannot replace the tuning database " << m_file << ": " << ec.message() << std::endl;
+}
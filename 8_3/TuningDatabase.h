@@ -0,0 +1,41 @@
+#pragma once
+#include <CL/cl.h>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+
+// Файл результатов автонастройки (--tune): лучший локальный размер ядра или размер блока GEMM
+// для устройства, ядра (с опциями сборки) и класса размера задачи. Текстовые строки "ключ<TAB>значение";
+// файл переписывается целиком после каждой новой записи, так что прерванная настройка не теряет
+// уже найденное. Ключ включает версию драйвера: после обновления настройка идет заново.
+class TuningDatabase
+{
+public:
+    // Пустой путь - записи живут только до конца процесса.
+    explicit TuningDatabase(std::filesystem::path file);
+
+    // $OPENCL_TUNING_FILE или <temp>/8_3_cl_tuning.txt; OPENCL_TUNING_FILE=off - без файла.
+    static std::filesystem::path DefaultPath();
+
+    // Класс размера: каждое измерение округляется вверх до степени двойки ("1024x512"),
+    // чтобы близкие размеры изображений пользовались одной записью
+    static std::string MakeSizeClass(cl_uint dims, const size_t* sizes);
+    // "платформа|устройство|драйвер"
+    static std::string MakeDeviceIdentity(cl_device_id device);
+
+    [[nodiscard]] std::optional<std::string> Find(const std::string& key) const;
+    void Store(const std::string& key, const std::string& value);
+
+    [[nodiscard]] bool IsEmpty() const;
+    [[nodiscard]] const std::filesystem::path& GetPath() const { return m_file; }
+
+private:
+    void Load();
+    void Save() const;
+
+    std::filesystem::path m_file;
+    std::map<std::string, std::string> m_entries;
+    mutable std::mutex m_mutex;
+};
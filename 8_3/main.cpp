@@ -1,25 +1,30 @@
 #include "MatrixMultiplier.h"
-#include "GaussianFilter.h"
-#include "MedianFilter.h"      // ДОБАВЛЕНО
-#include "MotionBlurFilter.h"  // ДОБАВЛЕНО
-#include "RadialBlurFilter.h"  // ДОБАВЛЕНО
+#include "BatchProcessor.h"
+#include "FilterPipeline.h"
+#include "ImageIO.h"
+#include "StreamBenchmark.h"
+#include "AlgorithmBenchmark.h"
+#include "FilterVerification.h"
 #include "OpenCLUtils.h"
+#include "OpenCLDevices.h"
+#include "OpenCLRuntime.h"
 #include <iostream>
 #include <string>
 #include <vector>
 #include <stdexcept>
 #include <memory>
-
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include "stb_image_write.h"
+#include <optional>
 
 
 enum class OperationMode
 {
     MATRIX_MULTIPLY,
-    IMAGE_FILTER
+    IMAGE_FILTER,
+    BATCH_FILTER,
+    STREAM_BENCHMARK,
+    ALGORITHM_BENCHMARK,
+    VERIFY,
+    LIST_DEVICES
 };
 
 struct AppArguments
@@ -28,45 +33,184 @@ struct AppArguments
     int matrixRows1 = 0;
     int matrixCols1 = 0;
     int matrixCols2 = 0;
-    std::string filterTypeName;
+    std::string filterTypeName; // Один фильтр или цепочка: "median:3,gaussian:5"
     std::string inputImagePath;
     std::string outputImagePath;
     int filterRadius = 5; // Общее название, для motion blur это длина, для radial - интенсивность
+    std::string deviceSelector; // --device: индекс, подстрока имени или "fastest"
+    int streamWidth = 0;
+    int streamHeight = 0;
+    int streamFrames = 0;
+    std::vector<int> benchParameters;      // bench: значения параметра фильтра
+    std::vector<std::string> benchAlgorithms; // bench: варианты "algo", первый - эталон
+    int benchChannels = 4;
+    ProfilingOptions profiling; // --profile / --profile-json <path>
+    int threadsPerStage = 0; // --threads: потоки декодирования и кодирования в batch (0 - авто)
+    FilterBackend backend = FilterBackend::AUTO; // --backend: для filter и batch
+    bool zeroCopy = true; // --no-zero-copy: явные копии даже на устройствах с общей памятью
+    bool tune = false;    // --tune: перебор локальных размеров и блоков GEMM с записью в базу настройки
+    int stripRows = 0; // --strip-rows: высота полосы OpenCL-цепочки (0 - только при нехватке памяти)
+    std::optional<ElementType> elementType; // --element: тип значений для обработки (по умолчанию - как в файле)
 };
 
+void PrintUsage(const char* programName)
+{
+    std::cerr << "Usage:\n"
+              << "  " << programName << " [options] matrix <rows1> <cols1> <cols2>\n"
+              << "  " << programName << " [options] filter <filter_chain> <input_image_path> <output_image_path> [parameter_value]\n"
+              << "  " << programName << " [options] batch <filter_chain> <input_dir|input_dir/*.png> <output_dir> [parameter_value]\n"
+              << "  " << programName << " [options] stream <filter_type> <width> <height> <frames> [parameter_value]\n"
+              << "  " << programName << " [options] bench <filter_type> <width> <height> <param,param,...> <algo,algo,...> [channels]\n"
+              << "  " << programName << " [options] verify [results.json]\n"
+              << "  " << programName << " --list-devices\n"
+              << "Filter types: gaussian, median, motion, radial\n"
+              << "Filter chain: comma-separated filters with optional parameters, e.g. median:3,gaussian:5,motion\n"
+              << "  (runs on the device without intermediate downloads); options as name:param:key=value,\n"
+              << "  e.g. median:7:algo=tiled (median algo: auto, sort, network, tiled, histogram, radix;\n"
+              << "  gaussian algo: auto, separable, transpose, planar, box; gaussian:24:box_from=16 sets the\n"
+              << "  radius from which auto uses stacked box blurs; motion:15:angle=30 blurs along 30 degrees,\n"
+              << "  motion algo: running, direct; radial:8:cx=0.3:cy=0.6:samples=12 moves the center (fractions of\n"
+              << "  the size) and fixes the sample count, radial algo: auto, image, buffer, polar;\n"
+              << "  radial:80:polar_from=48 sets the intensity from which auto uses the polar remap)\n"
+              << "Point operations in a chain (values as fractions of full scale; alpha is kept): brightness:0.1,\n"
+              << "  contrast:1.5, gamma:2.2, threshold:0.5, invert, swizzle:bgra. Consecutive operations compile into\n"
+              << "  one kernel and run inside the last pass of a preceding gaussian or median, e.g. gaussian:3,gamma:2.2\n"
+              << "Default filter parameter value if not specified: 5\n"
+              << "Options:\n"
+              << "  --device <index|name|fastest>  OpenCL device: index from --list-devices, part of the device\n"
+              << "                                 or platform name, or the fastest one by a micro-benchmark\n"
+              << "  --list-devices                 Print every OpenCL platform/device and exit\n"
+              << "  --profile                      Time every OpenCL command with profiling events and print a\n"
+              << "                                 transfer/compute/host overhead breakdown\n"
+              << "  --profile-json <path>          Same as --profile, also write per-command timings as JSON\n"
+              << "  --threads <n>                  Batch mode: decode and encode threads per stage (default: half the cores)\n"
+              << "  --backend <cpu|opencl|auto>    Filter/batch/verify modes: run filters with OpenCL or on the CPU (SIMD,\n"
+              << "                                 all cores); auto uses the CPU when no OpenCL device is found\n"
+              << "  --no-zero-copy                 Copy images to and from the device even when it shares host memory\n"
+              << "  --tune                         Time work-group sizes (and GEMM tile sizes) for every kernel and problem\n"
+              << "                                 size class without a stored result and save the fastest to the tuning\n"
+              << "                                 database ($OPENCL_TUNING_FILE, default <temp>/8_3_cl_tuning.txt);\n"
+              << "                                 later runs use the stored sizes without --tune\n"
+              << "  --strip-rows <n>               OpenCL filters: process the image in strips of n rows plus halos\n"
+              << "                                 (default: only images that do not fit the device with filter buffers)\n"
+              << "  --element <u8|u16|f16|f32>     Filter/batch modes: convert pixel values to this type before filtering\n"
+              << "                                 (default: as loaded - f32 for .hdr, u16 for 16-bit PNG, u8 otherwise;\n"
+              << "                                 the CPU backend supports u8 only)\n";
+}
+
+// "1,3,5" -> {"1", "3", "5"}
+std::vector<std::string> SplitList(const std::string& list)
+{
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t commaPos = list.find(',', start);
+        if (commaPos == std::string::npos) commaPos = list.size();
+        if (commaPos > start) items.push_back(list.substr(start, commaPos - start));
+        start = commaPos + 1;
+    }
+    return items;
+}
+
 AppArguments ParseAppArguments(int argc, char* argv[])
 {
     AppArguments args;
-    if (argc < 2) {
-        std::cerr << "Usage:\n"
-                  << "  " << argv[0] << " matrix <rows1> <cols1> <cols2>\n"
-                  << "  " << argv[0] << " filter <filter_type> <input_image_path> <output_image_path> [parameter_value]\n"
-                  << "Filter types: gaussian, median, motion, radial\n"
-                  << "Default filter parameter value if not specified: 5\n";
+    std::vector<std::string> positional; // Аргументы без опций: positional[0] - режим
+    bool listDevices = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--device") {
+            if (i + 1 >= argc) throw std::runtime_error("--device needs a value.");
+            args.deviceSelector = argv[++i];
+        } else if (arg == "--profile") {
+            args.profiling.enabled = true;
+        } else if (arg == "--profile-json") {
+            if (i + 1 >= argc) throw std::runtime_error("--profile-json needs a path.");
+            args.profiling.enabled = true;
+            args.profiling.jsonPath = argv[++i];
+        } else if (arg == "--threads") {
+            if (i + 1 >= argc) throw std::runtime_error("--threads needs a value.");
+            args.threadsPerStage = std::stoi(argv[++i]);
+            if (args.threadsPerStage < 1) throw std::runtime_error("--threads must be positive.");
+        } else if (arg == "--no-zero-copy") {
+            args.zeroCopy = false;
+        } else if (arg == "--tune") {
+            args.tune = true;
+        } else if (arg == "--strip-rows") {
+            if (i + 1 >= argc) throw std::runtime_error("--strip-rows needs a value.");
+            args.stripRows = std::stoi(argv[++i]);
+            if (args.stripRows < 1) throw std::runtime_error("--strip-rows must be positive.");
+        } else if (arg == "--element") {
+            if (i + 1 >= argc) throw std::runtime_error("--element needs a value.");
+            args.elementType = ParseElementType(argv[++i]);
+        } else if (arg == "--backend") {
+            if (i + 1 >= argc) throw std::runtime_error("--backend needs a value.");
+            args.backend = ParseFilterBackend(argv[++i]);
+        } else if (arg == "--list-devices") {
+            listDevices = true;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
+    if (listDevices) {
+        args.opMode = OperationMode::LIST_DEVICES;
+        return args;
+    }
+    if (positional.empty()) {
+        PrintUsage(argv[0]);
         throw std::runtime_error("Insufficient arguments.");
     }
 
-    std::string modeStr = argv[1];
+    const std::string& modeStr = positional[0];
     if (modeStr == "matrix") {
         args.opMode = OperationMode::MATRIX_MULTIPLY;
-        if (argc != 5) throw std::runtime_error("Matrix mode needs 3 dimensions.");
-        args.matrixRows1 = std::stoi(argv[2]);
-        args.matrixCols1 = std::stoi(argv[3]);
-        args.matrixCols2 = std::stoi(argv[4]);
+        if (positional.size() != 4) throw std::runtime_error("Matrix mode needs 3 dimensions.");
+        args.matrixRows1 = std::stoi(positional[1]);
+        args.matrixCols1 = std::stoi(positional[2]);
+        args.matrixCols2 = std::stoi(positional[3]);
         if (args.matrixRows1 < 1 || args.matrixCols1 < 1 || args.matrixCols2 < 1) {
             throw std::runtime_error("Matrix dimensions must be positive.");
         }
-    } else if (modeStr == "filter") {
-        args.opMode = OperationMode::IMAGE_FILTER;
-        if (argc < 5) throw std::runtime_error("Filter mode needs: filter_type input_path output_path [parameter_value].");
-        args.filterTypeName = argv[2];
-        args.inputImagePath = argv[3];
-        args.outputImagePath = argv[4];
-        if (argc > 5) args.filterRadius = std::stoi(argv[5]); // filterRadius - это общее имя для параметра фильтра
+    } else if (modeStr == "filter" || modeStr == "batch") {
+        // Пакетный режим принимает те же аргументы, только вход - каталог/маска, а выход - каталог
+        args.opMode = modeStr == "filter" ? OperationMode::IMAGE_FILTER : OperationMode::BATCH_FILTER;
+        if (positional.size() < 4) throw std::runtime_error("Filter mode needs: filter_type input_path output_path [parameter_value].");
+        args.filterTypeName = positional[1];
+        args.inputImagePath = positional[2];
+        args.outputImagePath = positional[3];
+        if (positional.size() > 4) args.filterRadius = std::stoi(positional[4]); // filterRadius - это общее имя для параметра фильтра
 
         if (args.filterRadius < 0) {
             throw std::runtime_error("Filter parameter (radius/length/intensity) must be non-negative.");
         }
+    } else if (modeStr == "stream") {
+        args.opMode = OperationMode::STREAM_BENCHMARK;
+        if (positional.size() < 5) throw std::runtime_error("Stream mode needs: filter_type width height frames [parameter_value].");
+        args.filterTypeName = positional[1];
+        args.streamWidth = std::stoi(positional[2]);
+        args.streamHeight = std::stoi(positional[3]);
+        args.streamFrames = std::stoi(positional[4]);
+        if (positional.size() > 5) args.filterRadius = std::stoi(positional[5]);
+        if (args.streamWidth < 1 || args.streamHeight < 1 || args.streamFrames < 1) {
+            throw std::runtime_error("Stream width, height and frame count must be positive.");
+        }
+    } else if (modeStr == "bench") {
+        args.opMode = OperationMode::ALGORITHM_BENCHMARK;
+        if (positional.size() < 6) throw std::runtime_error("Bench mode needs: filter_type width height params algos [channels].");
+        args.filterTypeName = positional[1];
+        args.streamWidth = std::stoi(positional[2]);
+        args.streamHeight = std::stoi(positional[3]);
+        for (const std::string& value : SplitList(positional[4])) args.benchParameters.push_back(std::stoi(value));
+        args.benchAlgorithms = SplitList(positional[5]);
+        if (positional.size() > 6) args.benchChannels = std::stoi(positional[6]);
+        if (args.streamWidth < 1 || args.streamHeight < 1 || args.benchChannels < 1 || args.benchChannels > 4) {
+            throw std::runtime_error("Bench width/height must be positive and channels 1..4.");
+        }
+    } else if (modeStr == "verify") {
+        // Все фильтры на всех бэкендах против эталона на хосте; путь - для результатов в JSON
+        args.opMode = OperationMode::VERIFY;
+        args.outputImagePath = positional.size() > 1 ? positional[1] : "verify_results.json";
     } else {
         throw std::runtime_error("Unknown mode: " + modeStr);
     }
@@ -79,91 +223,86 @@ int main(int argc, char* argv[])
     try
     {
         AppArguments appArgs = ParseAppArguments(argc, argv);
+        OpenCLRuntime::Configure(DeviceSelectionPolicy::Parse(appArgs.deviceSelector));
+        OpenCLRuntime::ConfigureProfiling(appArgs.profiling);
+        OpenCLRuntime::ConfigureZeroCopy(appArgs.zeroCopy);
+        OpenCLRuntime::ConfigureTuning(appArgs.tune);
+        FilterPipeline::ConfigureBackend(appArgs.backend);
+        FilterPipeline::ConfigureStripRows(appArgs.stripRows);
+        bool usesPipeline = appArgs.opMode == OperationMode::IMAGE_FILTER || appArgs.opMode == OperationMode::BATCH_FILTER ||
+                            appArgs.opMode == OperationMode::VERIFY;
+        if (appArgs.backend == FilterBackend::CPU && !usesPipeline && appArgs.opMode != OperationMode::LIST_DEVICES) {
+            throw std::runtime_error("--backend cpu applies to filter, batch and verify modes only; this mode measures OpenCL.");
+        }
 
-        if (appArgs.opMode == OperationMode::MATRIX_MULTIPLY)
+        if (appArgs.opMode == OperationMode::LIST_DEVICES)
+        {
+            PrintOpenCLDevices(EnumerateOpenCLDevices(), std::cout);
+        }
+        else if (appArgs.opMode == OperationMode::MATRIX_MULTIPLY)
         {
             MatrixMultiplier multiplier;
             multiplier.RunBenchmark(appArgs.matrixRows1, appArgs.matrixCols1, appArgs.matrixCols2);
         }
         else if (appArgs.opMode == OperationMode::IMAGE_FILTER)
         {
-            std::cout << "Applying filter: " << appArgs.filterTypeName
-                      << " with parameter value " << appArgs.filterRadius // Используем общее имя параметра
+            std::vector<FilterSpec> filterSpecs = ParseFilterChain(appArgs.filterTypeName, appArgs.filterRadius);
+            FilterPipeline pipeline = FilterPipeline::FromSpecs(filterSpecs);
+
+            std::cout << "Applying filters: " << pipeline.GetDescription()
                       << "\nInput image: " << appArgs.inputImagePath
                       << "\nOutput image: " << appArgs.outputImagePath
                       << std::endl;
 
-            int width, height, channelsInFile;
-            int desiredChannels = 0; // По умолчанию используем то, что в файле
-
-            if (appArgs.filterTypeName == "gaussian") {
-                // GaussianFilter ожидает 4 канала (RGBA) из-за uchar4 в ядре
-                desiredChannels = 4;
-                std::cout << "Note: Gaussian filter will process image as RGBA (4 channels)." << std::endl;
+            // По умолчанию используем каналы из файла; ядра собираются под их число (-DCHANNELS)
+            int desiredChannels = pipeline.GetRequiredChannels();
+            if (desiredChannels != 0) {
+                std::cout << "Note: image will be processed with " << desiredChannels << " channels." << std::endl;
             }
-            // Для других фильтров (median, motion, radial) ядра написаны так,
-            // чтобы работать с `channels` из файла, поэтому `desiredChannels = 0` (по умолчанию).
 
-            unsigned char *loadedPixels = stbi_load(appArgs.inputImagePath.c_str(), &width, &height, &channelsInFile, desiredChannels);
-            if (!loadedPixels) {
-                throw std::runtime_error("Failed to load image: " + appArgs.inputImagePath + ". Reason: " + stbi_failure_reason());
+            HostImage image = LoadImageFile(appArgs.inputImagePath, desiredChannels);
+            if (appArgs.elementType) {
+                image.pixels = ConvertElements(image.pixels, image.elementType, *appArgs.elementType);
+                image.elementType = *appArgs.elementType;
             }
+            std::cout << "Image loaded: " << image.width << "x" << image.height << ", channels in file: " << image.channelsInFile
+                      << ", channels for processing: " << image.channels
+                      << ", values: " << GetElementTypeName(image.elementType) << std::endl;
 
-            int channelsForProcessing = (desiredChannels == 0) ? channelsInFile : desiredChannels;
+            pipeline.Apply(image.pixels, image.width, image.height, image.channels, image.elementType);
 
-            std::cout << "Image loaded: " << width << "x" << height << ", channels in file: " << channelsInFile
-                      << ", channels for processing: " << channelsForProcessing << std::endl;
+            std::cout << "Filters '" << pipeline.GetDescription() << "' applied." << std::endl;
 
-            std::vector<unsigned char> imageData(loadedPixels, loadedPixels + static_cast<size_t>(width) * height * channelsForProcessing);
-            stbi_image_free(loadedPixels);
-
-            std::unique_ptr<IImageFilter> imageFilter;
-
-            if (appArgs.filterTypeName == "gaussian") {
-                if (channelsForProcessing != 4) {
-                    throw std::runtime_error("Gaussian filter internal error: expected 4 channels for processing but got " + std::to_string(channelsForProcessing));
-                }
-                imageFilter = std::make_unique<GaussianFilter>(appArgs.filterRadius);
-            } else if (appArgs.filterTypeName == "median") {
-                imageFilter = std::make_unique<MedianFilter>(appArgs.filterRadius);
-            } else if (appArgs.filterTypeName == "motion") {
-                imageFilter = std::make_unique<MotionBlurFilter>(appArgs.filterRadius);
-            } else if (appArgs.filterTypeName == "radial") {
-                imageFilter = std::make_unique<RadialBlurFilter>(appArgs.filterRadius);
-            }
-            else {
-                throw std::runtime_error("Unsupported filter type: " + appArgs.filterTypeName);
-            }
-
-            imageFilter->ApplyFilter(imageData, width, height, channelsForProcessing);
-
-            std::cout << "Filter '" << imageFilter->GetName() << "' applied." << std::endl;
-
-            int success = 0;
-            std::string ext;
-            size_t dotPos = appArgs.outputImagePath.rfind('.');
-            if (dotPos != std::string::npos) {
-                ext = appArgs.outputImagePath.substr(dotPos);
-                for(char &c : ext) c = static_cast<char>(tolower(c)); // в нижний регистр
-            }
-
-            if (ext == ".png") {
-                success = stbi_write_png(appArgs.outputImagePath.c_str(), width, height, channelsForProcessing, imageData.data(), width * channelsForProcessing);
-            } else if (ext == ".jpg" || ext == ".jpeg") {
-                success = stbi_write_jpg(appArgs.outputImagePath.c_str(), width, height, channelsForProcessing, imageData.data(), 90);
-            } else if (ext == ".bmp") {
-                success = stbi_write_bmp(appArgs.outputImagePath.c_str(), width, height, channelsForProcessing, imageData.data());
-            } else {
-                std::cerr << "Warning: Unsupported output file extension '" << ext << "'. Attempting to save as PNG to " << appArgs.outputImagePath << ".png" << std::endl;
-                std::string fallbackPath = (dotPos != std::string::npos ? appArgs.outputImagePath.substr(0, dotPos) : appArgs.outputImagePath) + ".png";
-                success = stbi_write_png(fallbackPath.c_str(), width, height, channelsForProcessing, imageData.data(), width * channelsForProcessing);
-                if (success) appArgs.outputImagePath = fallbackPath;
-            }
+            std::string savedPath = SaveImageFile(appArgs.outputImagePath, image);
+            std::cout << "Filtered image saved to: " << savedPath << std::endl;
+        }
+        else if (appArgs.opMode == OperationMode::BATCH_FILTER)
+        {
+            BatchOptions options;
+            options.inputPattern = appArgs.inputImagePath;
+            options.outputDirectory = appArgs.outputImagePath;
+            options.filters = ParseFilterChain(appArgs.filterTypeName, appArgs.filterRadius);
+            options.decodeThreads = appArgs.threadsPerStage;
+            options.encodeThreads = appArgs.threadsPerStage;
+            options.elementType = appArgs.elementType;
 
-            if (!success) {
-                throw std::runtime_error("Failed to save image to: " + appArgs.outputImagePath);
-            }
-            std::cout << "Filtered image saved to: " << appArgs.outputImagePath << std::endl;
+            BatchProcessor processor(options);
+            processor.Run();
+        }
+        else if (appArgs.opMode == OperationMode::STREAM_BENCHMARK)
+        {
+            std::vector<FilterSpec> filterSpecs = ParseFilterChain(appArgs.filterTypeName, appArgs.filterRadius);
+            if (filterSpecs.size() != 1) throw std::runtime_error("Stream mode takes a single filter, not a chain.");
+            RunStreamBenchmark(filterSpecs.front(), appArgs.streamWidth, appArgs.streamHeight, appArgs.streamFrames);
+        }
+        else if (appArgs.opMode == OperationMode::ALGORITHM_BENCHMARK)
+        {
+            RunAlgorithmBenchmark(appArgs.filterTypeName, appArgs.streamWidth, appArgs.streamHeight, appArgs.benchChannels,
+                                  appArgs.benchParameters, appArgs.benchAlgorithms);
+        }
+        else if (appArgs.opMode == OperationMode::VERIFY)
+        {
+            if (!RunFilterVerification(appArgs.outputImagePath, appArgs.backend != FilterBackend::CPU)) return EXIT_FAILURE;
         }
     }
     catch (const std::exception& e)